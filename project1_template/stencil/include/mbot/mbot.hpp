@@ -7,30 +7,73 @@
 #include <termios.h>
 #include <unistd.h>
 
+#include <array>
+#include <atomic>
 #include <mutex>
 #include <thread>
 #include <functional>
+#include <vector>
 
 #include "mbot/messages.hpp"
 #include "mbot/mbot_base.hpp"
 #include "rix/ipc/file.hpp"
+#include "rix/ipc/pipe.hpp"
+#include "rix/ipc/timer_fd.hpp"
 #include "rix/msg/geometry/Twist2DStamped.hpp"
 
 using rix::msg::geometry::Twist2DStamped;
 
 class MBot : public MBotBase {
    public:
-    MBot();
+    /**
+     * @brief Opens the MBot serial port and starts the time synchronization
+     * thread.
+     *
+     * @param timesync_rate The rate at which timesync messages are sent (Hz).
+     */
+    MBot(double timesync_rate = 2.0);
     ~MBot();
 
     bool ok() const;
     void drive(const Twist2DStamped &cmd) const;
 
+    /**
+     * @brief Returns `true` once the board has answered at least one timesync
+     * message.
+     *
+     */
+    bool is_clock_synced() const;
+
+    /**
+     * @brief Estimated offset of the board clock relative to the host clock
+     * (board - host), measured from the most recent timesync reply.
+     *
+     */
+    rix::util::Duration clock_offset() const;
+
+    /**
+     * @brief Round-trip time of the most recent timesync exchange.
+     *
+     */
+    rix::util::Duration clock_round_trip() const;
+
    private:
     void timesync();
+    void send_timesync();
+    void read_serial();
+    void handle_packet(uint16_t topic, const uint8_t *data, size_t len);
 
     mutable std::mutex mtx;
     std::thread timesync_thr;
-    std::atomic<bool> stop_timesync_flag;
     rix::ipc::File file;
-};
\ No newline at end of file
+    rix::ipc::TimerFd timesync_timer;
+    std::array<rix::ipc::Pipe, 2> stop_pipe; /**< 0: read end, 1: write end */
+    rix::util::Duration timesync_period;
+
+    std::vector<uint8_t> rx_buffer;
+    int64_t last_sync_utime;      /**< Host wall time of the last timesync sent (us) */
+    int64_t last_sync_mono_ns;    /**< Host monotonic time of the last timesync sent (ns) */
+    std::atomic<bool> clock_synced;
+    std::atomic<int64_t> offset_us;
+    std::atomic<int64_t> round_trip_ns;
+};
@@ -7,19 +7,140 @@
 #include "rix/ipc/file.hpp"
 #include "rix/ipc/interfaces/io.hpp"
 #include "rix/ipc/interfaces/notification.hpp"
+#include "rix/ipc/poller.hpp"
 #include "rix/ipc/signal.hpp"
+#include "rix/ipc/timer_fd.hpp"
 #include "rix/msg/geometry/Twist2DStamped.hpp"
 #include "rix/msg/standard/UInt32.hpp"
+#include "rix/util/histogram.hpp"
+#include "rix/util/time.hpp"
+#include "rix/util/timer_wheel.hpp"
+#include "rix/util/trace.hpp"
 
 using namespace rix::ipc;
 using namespace rix::msg;
 
 class MBotDriver {
    public:
+    /**
+     * @brief Command counters maintained by `spin`.
+     *
+     */
+    struct Stats {
+        uint64_t received{0};  /**< Commands decoded from the input */
+        uint64_t sent{0};      /**< Commands forwarded to the MBot */
+        uint64_t coalesced{0}; /**< Commands replaced by a newer one before they were sent */
+        uint64_t dropped{0};   /**< Frames discarded because they could not be decoded */
+        uint64_t timeouts{0};  /**< Times the MBot was stopped because commands stopped arriving */
+    };
+
+    /**
+     * @brief The default command rate, matching the 25 Hz control loop of the
+     * MBot firmware.
+     *
+     */
+    static constexpr double default_max_rate = 25.0;
+
     MBotDriver(std::unique_ptr<interfaces::IO> input, std::unique_ptr<MBotBase> mbot);
     void spin(std::unique_ptr<interfaces::Notification> notif);
 
+    /**
+     * @brief Sets the maximum rate at which commands are forwarded to the MBot.
+     * Commands that arrive faster are coalesced so that only the newest one is
+     * sent in each period. A rate of zero or less disables rate limiting.
+     *
+     * @param rate The maximum command rate (Hz)
+     */
+    void set_max_rate(double rate);
+    double max_rate() const;
+
+    /**
+     * @brief Sets the command timeout. If no command arrives within the
+     * timeout while the MBot is moving, a zero-velocity command is sent. A
+     * timeout of zero or less disables the watchdog.
+     *
+     * @param timeout The maximum time between commands
+     */
+    void set_command_timeout(const rix::util::Duration &timeout);
+    rix::util::Duration command_timeout() const;
+
+    /**
+     * @brief Sets how often a summary of the command traffic (command rate and
+     * latency percentiles) is logged while commands are arriving. A period of
+     * zero or less disables the summary.
+     *
+     * @param period The reporting period
+     */
+    void set_report_period(const rix::util::Duration &period);
+    rix::util::Duration report_period() const;
+
+    /**
+     * @brief Sets whether each command on the input is preceded by its size
+     * (a 4-byte UInt32), which is the default. Disable the prefix when the
+     * input preserves message boundaries (a `SEQPACKET` UnixSocket): each read
+     * then returns exactly one command.
+     *
+     * @param size_prefixed true if commands are size-prefixed
+     */
+    void set_size_prefixed(bool size_prefixed);
+    bool size_prefixed() const;
+
+    /**
+     * @brief Enables latency tracing. The latency from the command stamp (set
+     * when the key was read) to when the driver read, decoded and wrote the
+     * command to the MBot is recorded. The report is written to stderr when
+     * `dump` is raised (typically SIGUSR1) and when `spin` returns.
+     *
+     * @param dump Notification that requests a report, may be null.
+     */
+    void enable_trace(std::unique_ptr<interfaces::Notification> dump);
+
+    /**
+     * @brief Returns the latency trace, or null if tracing is disabled.
+     *
+     */
+    const rix::util::Trace *trace() const;
+
+    const Stats &stats() const;
+
    private:
+    void wait(interfaces::Notification &notif, Poller &poller, const rix::util::SteadyTime &deadline,
+              bool &signaled, bool &readable);
+    bool read_input();
+    bool next_command(geometry::Twist2DStamped &cmd);
+    void send(const rix::util::SteadyTime &now);
+    void check_watchdog();
+    void stop();
+    void report();
+
     std::unique_ptr<interfaces::IO> input;
     std::unique_ptr<MBotBase> mbot;
-};
\ No newline at end of file
+    rix::util::Duration send_period;
+    rix::util::Duration command_timeout_;
+    rix::util::Duration report_period_;
+    std::vector<uint8_t> rx_buffer;
+    size_t rx_offset;
+    bool size_prefixed_;
+    Stats stats_;
+
+    rix::util::TimerWheel timers;                /**< Send slots, watchdog and report deadlines */
+    TimerFd timer_fd;                            /**< Armed for the earliest deadline in `timers` */
+    rix::util::TimerWheel::Id send_timer;        /**< Next send slot, while a command is pending */
+    rix::util::TimerWheel::Id watchdog_timer;    /**< Command timeout, while the MBot is moving */
+    rix::util::TimerWheel::Id report_timer;      /**< End of the current reporting window */
+    geometry::Twist2DStamped latest;             /**< Newest command, sent at the next send slot */
+    bool pending;                                /**< true if `latest` has not been sent yet */
+    bool moving;                                 /**< true if the last command sent was non-zero */
+    rix::util::SteadyTime next_send;             /**< Start of the next send slot */
+    rix::util::SteadyTime last_command;          /**< Arrival of the last command */
+
+    rix::util::SteadyTime report_start; /**< Start of the current reporting window */
+    Stats report_stats;                 /**< Counters at the start of the current reporting window */
+    rix::util::Histogram report_latency; /**< Stamp-to-receive latency in the current window (ns) */
+
+    std::unique_ptr<rix::util::Trace> trace_;
+    std::unique_ptr<interfaces::Notification> trace_dump;
+    size_t trace_read;
+    size_t trace_decode;
+    size_t trace_write;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rix {
+namespace bag {
+
+/**
+ * @brief How the records of a chunk are stored.
+ */
+enum class Compression : uint32_t {
+    NONE = 0, /**< As is */
+    LZ = 1,   /**< Compressed with `util::lz` */
+};
+
+/**
+ * @brief Layout of a bag file. All values are in host byte order.
+ *
+ * @details A bag starts with `file_magic`, followed by chunks and, if it was
+ * closed cleanly, an index and a footer:
+ *
+ *     file_magic
+ *     ChunkHeader, chunk data      (repeated)
+ *     ChunkInfo                    (one per chunk)
+ *     Footer
+ *
+ * The chunk data is a sequence of records, each a `RecordHeader` followed by
+ * the serialized message, possibly compressed as a whole. A bag without a footer (the recorder was killed) is
+ * still readable: its chunks are found by walking the chunk headers.
+ */
+namespace format {
+
+constexpr char file_magic[8] = {'R', 'I', 'X', 'B', 'A', 'G', '0', '1'};
+constexpr uint32_t chunk_magic = 0x4b4e4843;         // "CHNK"
+constexpr uint64_t footer_magic = 0x58444e4947414258;  // "XBAGINDX"
+
+struct ChunkHeader {
+    uint32_t magic;
+    uint32_t compression; /**< A `Compression` */
+    uint64_t stored_size; /**< Size of the data in the file */
+    uint64_t raw_size;    /**< Size of the records */
+    int64_t start;        /**< Earliest stamp in the chunk (ns since the epoch) */
+    int64_t end;          /**< Latest stamp in the chunk (ns since the epoch) */
+    uint64_t count;       /**< Number of records */
+};
+
+struct RecordHeader {
+    uint32_t size; /**< Size of the message */
+    uint32_t reserved;
+    uint64_t hash[2]; /**< Type of the message (see `Message::hash`) */
+    int64_t stamp;    /**< Receive time (ns since the epoch) */
+};
+
+struct ChunkInfo {
+    uint64_t offset; /**< Offset of the ChunkHeader in the file */
+    int64_t start;
+    int64_t end;
+    uint64_t count;
+};
+
+struct Footer {
+    uint64_t index_offset; /**< Offset of the first ChunkInfo in the file */
+    uint64_t chunk_count;
+    uint64_t magic;
+};
+
+}  // namespace format
+}  // namespace bag
+}  // namespace rix
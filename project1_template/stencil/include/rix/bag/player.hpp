@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "rix/bag/reader.hpp"
+#include "rix/ipc/interfaces/io.hpp"
+#include "rix/ipc/interfaces/notification.hpp"
+#include "rix/ipc/timer_fd.hpp"
+#include "rix/util/histogram.hpp"
+#include "rix/util/time.hpp"
+
+namespace rix {
+namespace bag {
+
+/**
+ * @brief Replays the messages of a bag to an output, keeping their original
+ * timing.
+ *
+ * @details Each message is sent at an absolute deadline on the monotonic
+ * clock, `start + (stamp - first stamp) / speed`, so like `util::Rate` the
+ * time spent writing a message or a late wakeup does not delay the following
+ * ones. The deadlines are waited on with a `TimerFd`, together with the stop
+ * notification. A speed of 0 sends every message as fast as the output
+ * accepts it.
+ *
+ * Messages are written size-prefixed (a 4-byte UInt32) by default, like the
+ * teleop's output, so the replay can be piped into `mbot_driver`. The output
+ * is meant for `mbot_driver` (through stdout, a FIFO or its socket), not for
+ * an MBot itself, whose pty expects the packets of `encode_msg`.
+ */
+class Player {
+   public:
+    struct Stats {
+        uint64_t sent = 0;      //< Messages written.
+        uint64_t failed = 0;    //< Messages the output did not accept.
+        uint64_t skipped = 0;   //< Messages of another type.
+        util::Duration elapsed; //< Time from the first message to the last one.
+        util::Histogram lateness; //< Lateness of every message, in nanoseconds.
+    };
+
+    /**
+     * @brief Creates a player that writes to `output`.
+     */
+    explicit Player(std::unique_ptr<ipc::interfaces::IO> output);
+
+    /**
+     * @brief Sets the playback speed: 1 replays in real time, 2 twice as fast,
+     * and 0 as fast as possible.
+     */
+    void set_speed(double speed);
+    double speed() const;
+
+    /**
+     * @brief Sets whether each message is preceded by its size (a 4-byte
+     * UInt32), which is the default. Disable the prefix when the output keeps
+     * message boundaries (a SEQPACKET socket).
+     */
+    void set_size_prefixed(bool size_prefixed);
+    bool size_prefixed() const;
+
+    /**
+     * @brief Only replays messages of this type (see `Message::hash`). By
+     * default, every message is replayed.
+     */
+    void set_type(const std::array<uint64_t, 2> &hash);
+
+    /**
+     * @brief Replays the messages from the current position of `reader` to the
+     * end of the bag, or until `notif` is raised.
+     * @param reader The bag, positioned at the first message to replay (see
+     * `Reader::seek`).
+     * @param notif Stops the replay when raised, may be null.
+     * @return false if the replay was stopped by `notif`.
+     */
+    bool play(Reader &reader, const ipc::interfaces::Notification *notif = nullptr);
+
+    /**
+     * @brief Returns the statistics of the last call to `play`.
+     */
+    const Stats &stats() const;
+
+   private:
+    /**
+     * @brief Waits until `deadline`.
+     * @return false if `notif` was raised.
+     */
+    bool wait_until(const util::SteadyTime &deadline, const ipc::interfaces::Notification *notif);
+
+    /**
+     * @brief Writes one message, waiting while the output is full.
+     */
+    bool send(const View &view);
+
+    std::unique_ptr<ipc::interfaces::IO> output_;
+    double speed_;
+    bool size_prefixed_;
+    bool filter_;
+    std::array<uint64_t, 2> hash_;
+    ipc::TimerFd timer_;
+    std::vector<uint8_t> frame_;
+    Stats stats_;
+};
+
+}  // namespace bag
+}  // namespace rix
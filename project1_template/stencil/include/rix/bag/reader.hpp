@@ -0,0 +1,149 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "rix/bag/format.hpp"
+#include "rix/msg/message.hpp"
+#include "rix/util/time.hpp"
+
+namespace rix {
+namespace bag {
+
+/**
+ * @brief A message read from a bag. `data` points into the reader and is
+ * valid until the next call to `Reader::next`, `seek` or `close`.
+ */
+struct View {
+    std::array<uint64_t, 2> hash;
+    util::Time stamp;
+    const uint8_t *data;
+    size_t size;
+
+    /**
+     * @brief Deserializes the message.
+     * @return false if `msg` has another type or the data is invalid.
+     */
+    bool deserialize(msg::Message &msg) const;
+};
+
+/**
+ * @brief Reads a bag written by `Writer`.
+ *
+ * @details The file is memory-mapped, so opening a bag only reads its index
+ * and messages are read in place. `seek` finds the chunk containing a time
+ * with a binary search on the index, then scans that chunk only. If stamps
+ * went backwards across chunks, so the chunks are not sorted by their latest
+ * stamp, `seek` checks the index linearly instead, still skipping the chunks
+ * that end before the time.
+ *
+ * Compressed chunks are decompressed when they are first read, so seeking
+ * only decompresses the chunk it lands in.
+ *
+ * A bag whose recorder did not close it has no index. Its chunks are found by
+ * walking the chunk headers instead (see `indexed`), and a chunk cut short is
+ * ignored.
+ *
+ * Not thread-safe.
+ */
+class Reader {
+   public:
+    Reader();
+
+    /**
+     * @brief Opens a bag. Check `is_open`.
+     */
+    explicit Reader(const std::string &path);
+
+    Reader(const Reader &) = delete;
+    Reader &operator=(const Reader &) = delete;
+
+    ~Reader();
+
+    /**
+     * @brief Opens a bag and moves to its first message. Closes the current
+     * bag first, if any.
+     * @return true if the file is a bag, false otherwise (errno is set, EINVAL
+     * if the file is not a bag).
+     */
+    bool open(const std::string &path);
+    void close();
+    bool is_open() const;
+
+    /**
+     * @brief Returns false if the bag has no index and its chunks were found
+     * by scanning the file.
+     */
+    bool indexed() const;
+
+    /**
+     * @brief Returns the number of messages in the bag.
+     */
+    uint64_t size() const;
+
+    /**
+     * @brief Returns the number of chunks in the bag.
+     */
+    size_t chunks() const;
+
+    /**
+     * @brief Returns the stamp of the earliest message, or 0 if the bag is
+     * empty.
+     */
+    util::Time start_time() const;
+
+    /**
+     * @brief Returns the stamp of the latest message, or 0 if the bag is
+     * empty.
+     */
+    util::Time end_time() const;
+
+    /**
+     * @brief Moves to the first message, in the order of the bag, stamped at
+     * or after `time`.
+     * @return false if there is no such message.
+     */
+    bool seek(const util::Time &time);
+
+    /**
+     * @brief Moves to the first message.
+     */
+    void rewind();
+
+    /**
+     * @brief Reads the next message.
+     * @return false at the end of the bag.
+     */
+    bool next(View &view);
+
+   private:
+    /**
+     * @brief Makes chunk `index` the current chunk.
+     * @return false if it is corrupted.
+     */
+    bool load(size_t index);
+
+    /**
+     * @brief Reads the record at `position_` in the current chunk without
+     * consuming it.
+     */
+    bool peek(View &view) const;
+
+    const uint8_t *map_;
+    size_t map_size_;
+    bool indexed_;
+    bool sorted_;  /**< Whether the chunks are sorted by their latest stamp */
+    std::vector<format::ChunkInfo> index_;
+    uint64_t count_;
+
+    size_t chunk_;         /**< Index of the current chunk */
+    const uint8_t *data_;  /**< Records of the current chunk */
+    size_t data_size_;
+    size_t position_;      /**< Offset of the next record in `data_` */
+    std::vector<uint8_t> decompressed_; /**< Records of the current chunk, if compressed */
+};
+
+}  // namespace bag
+}  // namespace rix
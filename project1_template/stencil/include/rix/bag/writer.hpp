@@ -0,0 +1,179 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rix/bag/format.hpp"
+#include "rix/msg/message.hpp"
+#include "rix/util/time.hpp"
+
+namespace rix {
+namespace bag {
+
+/**
+ * @brief Records messages to a bag file (see `format`).
+ *
+ * @details `write` copies the message into the current chunk in memory and
+ * returns; it never touches the file. Full chunks are handed to a background
+ * thread that writes them, so a slow disk does not stall the caller. If the
+ * disk falls so far behind that `max_pending` chunks are waiting, the new
+ * chunk is dropped instead (see `dropped`). The chunk index is written when
+ * the bag is closed.
+ *
+ * Stamps should not decrease, since the reader seeks with the index assuming
+ * chunks are in time order.
+ *
+ * Thread-safe.
+ */
+class Writer {
+   public:
+    static constexpr size_t default_chunk_size = 1 << 18;
+    static constexpr size_t default_max_pending = 16;
+
+    Writer();
+
+    /**
+     * @brief Creates a bag, truncating the file. Check `is_open`.
+     */
+    explicit Writer(const std::string &path, size_t chunk_size = default_chunk_size);
+
+    Writer(const Writer &) = delete;
+    Writer &operator=(const Writer &) = delete;
+
+    /**
+     * @brief Destructor. Closes the bag.
+     */
+    ~Writer();
+
+    /**
+     * @brief Creates a bag, truncating the file. Closes the current bag
+     * first, if any.
+     * @param path The path of the bag.
+     * @param chunk_size The size at which a chunk is handed to the background
+     * thread. Larger chunks mean fewer, larger writes and a smaller index.
+     * @return true if the file was created, false otherwise (errno is set).
+     */
+    bool open(const std::string &path, size_t chunk_size = default_chunk_size);
+
+    /**
+     * @brief Writes the buffered chunks and the index, then closes the file.
+     * @return true if everything was written, false otherwise (errno is set).
+     */
+    bool close();
+
+    bool is_open() const;
+
+    /**
+     * @brief Records a message.
+     * @param msg The message.
+     * @param stamp The receive time of the message.
+     * @return false if the bag is not open.
+     */
+    bool write(const msg::Message &msg, const util::Time &stamp = util::Time::now());
+
+    /**
+     * @brief Records a message that is already serialized.
+     * @param hash The type of the message (see `Message::hash`).
+     */
+    bool write(const std::array<uint64_t, 2> &hash, const uint8_t *data, size_t size,
+               const util::Time &stamp = util::Time::now());
+
+    /**
+     * @brief Hands the current chunk to the background thread and waits until
+     * every chunk is written.
+     * @return false if a write failed (errno is set).
+     */
+    bool flush();
+
+    /**
+     * @brief Sets how chunks are compressed. Chunks are compressed by the
+     * background thread, so compression costs the caller nothing, and a chunk
+     * that does not get smaller is stored as is. Takes effect from the next
+     * chunk written.
+     */
+    void set_compression(Compression compression);
+    Compression compression() const;
+
+    /**
+     * @brief Returns the number of bytes written to the file so far, which
+     * with compression is less than the size of the records.
+     */
+    uint64_t bytes_written() const;
+
+    /**
+     * @brief Sets the number of full chunks that may wait for the disk before
+     * new chunks are dropped.
+     */
+    void set_max_pending(size_t chunks);
+    size_t max_pending() const;
+
+    /**
+     * @brief Returns the number of messages recorded, including those still
+     * buffered but not those dropped.
+     */
+    uint64_t written() const;
+
+    /**
+     * @brief Returns the number of messages dropped because the disk could not
+     * keep up.
+     */
+    uint64_t dropped() const;
+
+   private:
+    struct Chunk {
+        std::vector<uint8_t> data;
+        int64_t start;
+        int64_t end;
+        uint64_t count;
+    };
+
+    /**
+     * @brief Returns space for a record of `size` bytes at the end of the
+     * current chunk. Called with `mutex_` held.
+     */
+    uint8_t *append(const std::array<uint64_t, 2> &hash, size_t size, int64_t stamp);
+
+    /**
+     * @brief Queues the current chunk for the background thread. Unless
+     * `force` is set, the chunk is dropped if too many chunks are pending.
+     * Called with `mutex_` held.
+     */
+    void seal(bool force);
+
+    void flush_loop();
+    bool write_chunk(const Chunk &chunk, Compression compression);
+    bool write_all(const void *data, size_t size);
+
+    mutable std::mutex mutex_;
+    std::condition_variable pending_cv_; /**< Signals the background thread */
+    std::condition_variable done_cv_;    /**< Signals `flush` */
+    int fd_;
+    size_t chunk_size_;
+    size_t max_pending_;
+    Chunk current_;
+    std::deque<Chunk> pending_;
+    std::vector<std::vector<uint8_t>> free_; /**< Buffers of written chunks, reused */
+    bool busy_;                              /**< true while a chunk is being written */
+    bool stopping_;
+    int error_;                              /**< errno of the first failed write */
+    Compression compression_;
+    std::thread thread_;
+
+    // Owned by the background thread
+    std::vector<format::ChunkInfo> index_;
+    std::vector<uint8_t> compressed_;
+    std::atomic<uint64_t> offset_; /**< End of the file, also read by `bytes_written` */
+
+    std::atomic<uint64_t> written_;
+    std::atomic<uint64_t> dropped_;
+};
+
+}  // namespace bag
+}  // namespace rix
@@ -0,0 +1,369 @@
+#pragma once
+
+#include <sys/eventfd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rix/ipc/file.hpp"
+#include "rix/ipc/poller.hpp"
+#include "rix/ipc/topic.hpp"
+#include "rix/util/time.hpp"
+
+namespace rix {
+namespace ipc {
+
+namespace detail {
+
+/**
+ * @brief A lock-free single-producer single-consumer ring of values, stored
+ * in slots allocated once.
+ *
+ * @details The producer can drop the oldest entry with the compare-and-swap
+ * on the read index used by `ShmRing`: the side that wins the swap owns the
+ * slot at that position. Since the winner moves the value out after the
+ * swap, each slot also has a sequence number, set to the position that may
+ * fill it next once the value has been moved out. The producer only writes a
+ * slot when its sequence number matches, waiting for the few instructions it
+ * takes the consumer to finish otherwise.
+ */
+template <typename V>
+class SlotRing {
+   public:
+    explicit SlotRing(size_t capacity) : mask_(round_up_pow2(capacity) - 1), slots_(mask_ + 1), head_(0), tail_(0) {
+        for (size_t i = 0; i < slots_.size(); i++) {
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    SlotRing(const SlotRing &) = delete;
+    SlotRing &operator=(const SlotRing &) = delete;
+
+    /**
+     * @brief Pushes a copy of `value`. When the ring is full and `overwrite`
+     * is set, the oldest entries are dropped to make room; otherwise the ring
+     * is left unchanged and false is returned.
+     */
+    bool push(const V &value, bool overwrite) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        uint64_t tail = tail_.load(std::memory_order_acquire);
+        while (head - tail > mask_) {
+            if (!overwrite) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (tail_.compare_exchange_weak(tail, tail + 1, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                take(tail);
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                tail++;
+            }
+        }
+        Slot &slot = slots_[head & mask_];
+        // The consumer may still be moving the value out of this slot
+        while (slot.seq.load(std::memory_order_acquire) != head) {
+            std::this_thread::yield();
+        }
+        slot.value = value;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Moves the oldest entry into `value`.
+     */
+    bool pop(V &value) {
+        uint64_t tail = tail_.load(std::memory_order_acquire);
+        while (tail != head_.load(std::memory_order_acquire)) {
+            if (tail_.compare_exchange_strong(tail, tail + 1, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                value = take(tail);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool empty() const { return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire); }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    size_t capacity() const { return mask_ + 1; }
+
+   private:
+    struct Slot {
+        std::atomic<uint64_t> seq;
+        V value;
+    };
+
+    /**
+     * @brief Moves the value out of the slot at `position`, which the caller
+     * won the swap for, and hands the slot back to the producer.
+     */
+    V take(uint64_t position) {
+        Slot &slot = slots_[position & mask_];
+        V value = std::move(slot.value);
+        slot.seq.store(position + mask_ + 1, std::memory_order_release);
+        return value;
+    }
+
+    static size_t round_up_pow2(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    const uint64_t mask_;
+    std::vector<Slot> slots_;
+    alignas(64) std::atomic<uint64_t> head_;
+    alignas(64) std::atomic<uint64_t> tail_;
+    std::atomic<uint64_t> dropped_{0};
+};
+
+}  // namespace detail
+
+/**
+ * @class Channel
+ * @brief Publishes messages of type `T` to subscribers in the same process
+ * without serializing them, and optionally to other processes through a
+ * topic.
+ *
+ * @details Messages are published as `std::shared_ptr<const T>`. Each
+ * subscription has its own lock-free queue whose slots hold these pointers
+ * and are allocated once, so delivering a message copies a `shared_ptr` into
+ * a slot (an atomic increment of its reference count) per subscriber without
+ * allocating, and every subscriber sees the same immutable object.
+ *
+ * If the channel is created with a topic name, it also owns a `TopicWriter`
+ * for `Subscriber<T>`s in other processes. A message is only serialized when
+ * such a subscriber exists.
+ *
+ * Like `TopicReader`, `Subscription::fd` is an eventfd that is readable when
+ * messages arrived after subscribing or after `take` found the queue empty,
+ * so a subscription can be waited on with a `Poller`. The eventfd is only written when the
+ * subscriber has caught up.
+ *
+ * `publish` may be called from one thread at a time; each subscription may be
+ * read by one thread at a time.
+ */
+template <typename T>
+class Channel {
+   public:
+    using Ptr = std::shared_ptr<const T>;
+
+    /**
+     * @class Subscription
+     * @brief The queue of one subscriber. Returned by `Channel::subscribe`.
+     */
+    class Subscription {
+       public:
+        Subscription(size_t capacity, DropPolicy policy)
+            : queue_(capacity), policy_(policy), wakeup_(::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {}
+
+        /**
+         * @brief Takes the oldest message without blocking.
+         *
+         * @return true if a message was taken, false if the queue is empty.
+         */
+        bool take(Ptr &msg) {
+            if (!queue_.pop(msg)) {
+                // Arm before consuming the wakeup, so a message published
+                // meanwhile is either popped below or writes the eventfd again
+                arm();
+                consume_wakeup();
+                if (!queue_.pop(msg)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * @brief Waits until a message is available or the subscription is
+         * closed.
+         *
+         */
+        bool wait(const rix::util::Duration &duration) {
+            if (!queue_.empty() || !connected()) {
+                return true;
+            }
+            if (arm() && !consume_wakeup()) {
+                Poller poller;
+                poller.add(wakeup_.fd());
+                poller.wait(duration);
+            }
+            return !queue_.empty() || !connected();
+        }
+
+        int fd() const { return wakeup_.fd(); }
+
+        /**
+         * @brief Returns false once the channel is destroyed or has closed
+         * this subscription (see `DropPolicy::DISCONNECT`). Messages already
+         * queued can still be taken.
+         *
+         */
+        bool connected() const { return !closed_.load(std::memory_order_acquire); }
+
+        /**
+         * @brief Returns the number of messages dropped because the queue was
+         * full.
+         *
+         */
+        uint64_t dropped() const { return queue_.dropped(); }
+
+       private:
+        friend class Channel;
+
+        bool arm() {
+            waiting_.store(true, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!queue_.empty() || !connected()) {
+                waiting_.store(false, std::memory_order_relaxed);
+                return false;
+            }
+            return true;
+        }
+
+        bool consume_wakeup() {
+            uint64_t count;
+            wakeup_.read(reinterpret_cast<uint8_t *>(&count), sizeof(count));
+            return !queue_.empty();
+        }
+
+        void wake() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (waiting_.load(std::memory_order_relaxed) && waiting_.exchange(false, std::memory_order_acq_rel)) {
+                uint64_t one = 1;
+                wakeup_.write(reinterpret_cast<const uint8_t *>(&one), sizeof(one));
+            }
+        }
+
+        void close() {
+            closed_.store(true, std::memory_order_release);
+            uint64_t one = 1;
+            wakeup_.write(reinterpret_cast<const uint8_t *>(&one), sizeof(one));
+        }
+
+        detail::SlotRing<Ptr> queue_;
+        DropPolicy policy_;
+        File wakeup_;
+        // A new subscription is empty and armed, so the first message makes
+        // `fd` readable before any `take`
+        std::atomic<bool> waiting_{true};
+        std::atomic<bool> closed_{false};
+    };
+
+    /**
+     * @brief Creates a channel.
+     *
+     * @param topic If not empty, messages are also published on this topic
+     * for other processes. Check `ok`.
+     */
+    explicit Channel(const std::string &topic = "") {
+        if (!topic.empty()) {
+            writer_ = std::make_unique<TopicWriter>(topic, T().hash());
+        }
+    }
+
+    Channel(const Channel &) = delete;
+    Channel &operator=(const Channel &) = delete;
+
+    /**
+     * @brief Destructor. Closes every subscription.
+     *
+     */
+    ~Channel() {
+        std::lock_guard<std::mutex> guard(mutex_);
+        for (auto &subscription : subscriptions_) {
+            subscription->close();
+        }
+    }
+
+    /**
+     * @brief Returns false if the topic could not be created.
+     *
+     */
+    bool ok() const { return !writer_ || writer_->ok(); }
+
+    /**
+     * @brief Subscribes to the channel. The subscription ends when the
+     * returned pointer is released.
+     *
+     * @param capacity The maximum number of queued messages, rounded up to a
+     * power of two
+     * @param policy What `publish` does when the queue is full
+     */
+    std::shared_ptr<Subscription> subscribe(size_t capacity = 64, DropPolicy policy = DropPolicy::DROP_OLDEST) {
+        auto subscription = std::make_shared<Subscription>(capacity, policy);
+        std::lock_guard<std::mutex> guard(mutex_);
+        subscriptions_.push_back(subscription);
+        return subscription;
+    }
+
+    /**
+     * @brief Publishes a message to every subscriber. The message must not be
+     * modified afterwards.
+     *
+     */
+    void publish(Ptr msg) {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            for (auto it = subscriptions_.begin(); it != subscriptions_.end();) {
+                Subscription &subscription = **it;
+                // Only the channel holds a released subscription, and nothing
+                // else can reach it
+                if (it->use_count() == 1) {
+                    it = subscriptions_.erase(it);
+                    continue;
+                }
+                if (!subscription.queue_.push(msg, subscription.policy_ == DropPolicy::DROP_OLDEST)) {
+                    if (subscription.policy_ == DropPolicy::DISCONNECT) {
+                        subscription.close();
+                        it = subscriptions_.erase(it);
+                        continue;
+                    }
+                }
+                subscription.wake();
+                ++it;
+            }
+        }
+
+        // Serialize only for subscribers in other processes
+        if (writer_ && writer_->subscribers() > 0) {
+            buffer_.resize(msg->size());
+            size_t offset = 0;
+            msg->serialize(buffer_.data(), offset);
+            writer_->write(buffer_.data(), buffer_.size());
+        }
+    }
+
+    /**
+     * @brief Copies `msg` into a new shared message and publishes it.
+     *
+     */
+    void publish(const T &msg) { publish(std::make_shared<const T>(msg)); }
+
+    /**
+     * @brief Returns the number of subscribers in this process.
+     *
+     */
+    size_t subscribers() const {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return std::count_if(subscriptions_.begin(), subscriptions_.end(),
+                             [](const std::shared_ptr<Subscription> &s) { return s.use_count() > 1; });
+    }
+
+   private:
+    mutable std::mutex mutex_;
+    std::vector<std::shared_ptr<Subscription>> subscriptions_;
+    std::unique_ptr<TopicWriter> writer_;
+    std::vector<uint8_t> buffer_;
+};
+
+}  // namespace ipc
+}  // namespace rix
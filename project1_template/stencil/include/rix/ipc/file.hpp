@@ -156,7 +156,7 @@ class File : public interfaces::IO {
      * 
      * @return int The file descriptor
      */
-    int fd() const;
+    int fd() const override;
 
     /**
      * @brief Returns `true` if the file is in a valid state, `false` otherwise.
@@ -25,6 +25,9 @@ class IO {
     virtual bool wait_for_readable(const rix::util::Duration &duration) const = 0;
     virtual void set_nonblocking(bool status) = 0;
     virtual bool is_nonblocking() const = 0;
+
+    // Underlying file descriptor for multiplexed waits, or -1 if there is none.
+    virtual int fd() const { return -1; }
 };
 
 }  // namespace interfaces
@@ -19,6 +19,10 @@ class Notification {
     bool is_ready() const { return wait(rix::util::Duration(0.0)); }
     virtual bool raise() const = 0;
     virtual bool wait(const rix::util::Duration &duration) const = 0;
+
+    // File descriptor that becomes readable when the notification is raised,
+    // or -1 if there is none. Call `wait` to consume the notification.
+    virtual int fd() const { return -1; }
 };
 
 }  // namespace interfaces
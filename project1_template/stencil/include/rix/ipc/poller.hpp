@@ -0,0 +1,80 @@
+#pragma once
+
+#include <poll.h>
+
+#include <cstddef>
+#include <vector>
+
+#include "rix/util/time.hpp"
+
+namespace rix {
+namespace ipc {
+
+/**
+ * @class Poller
+ * @brief Waits on several file descriptors at once. This allows a single
+ * thread to sleep until any of its inputs, signals or timers are ready, instead
+ * of waiting on each of them in turn with a short timeout.
+ *
+ * Timeouts have nanosecond resolution (see `ppoll(2)`), so deadlines are not
+ * rounded to whole milliseconds.
+ *
+ */
+class Poller {
+   public:
+    /**
+     * @brief Constructs an empty Poller.
+     *
+     */
+    Poller();
+
+    /**
+     * @brief Adds a file descriptor to the set. Negative file descriptors are
+     * accepted and never become ready.
+     *
+     * @param fd The file descriptor to wait on
+     * @param events The events to wait for (POLLIN, POLLOUT, ...)
+     * @return size_t The index used to query the file descriptor with `ready`
+     */
+    size_t add(int fd, short events = POLLIN);
+
+    /**
+     * @brief Stops waiting on the file descriptor at `index`. The index remains
+     * valid and `ready` returns `false` for it.
+     *
+     * @param index The index returned by `add`
+     */
+    void disable(size_t index);
+
+    /**
+     * @brief Waits until at least one file descriptor is ready or the timeout
+     * elapses. A timeout of `Duration::max()` waits forever, and a timeout of
+     * zero or less returns immediately.
+     *
+     * @param timeout The maximum duration to wait
+     * @return int The number of ready file descriptors, 0 on timeout or if
+     * interrupted by a signal, or -1 on error.
+     */
+    int wait(const util::Duration &timeout);
+
+    /**
+     * @brief Returns `true` if the file descriptor at `index` was ready after
+     * the last call to `wait`. Hang-ups and errors count as ready so that the
+     * following read or write reports them.
+     *
+     * @param index The index returned by `add`
+     */
+    bool ready(size_t index) const;
+
+    /**
+     * @brief Returns the number of file descriptors in the set.
+     *
+     */
+    size_t size() const;
+
+   private:
+    std::vector<struct pollfd> fds_;
+};
+
+}  // namespace ipc
+}  // namespace rix
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "rix/ipc/file.hpp"
+
+namespace rix {
+namespace ipc {
+
+/**
+ * @class SharedMemory
+ * @brief Anonymous shared memory region backed by a memory file (see
+ * `memfd_create(2)`) and mapped into the address space. Inherits from the
+ * `File` class.
+ *
+ * The region has no name in the file system: it is shared by passing its
+ * file descriptor to another process (see `UnixSocket::send_fds`), which maps
+ * it with `SharedMemory(int fd)`. The memory is released when every
+ * descriptor is closed and every mapping is unmapped.
+ *
+ */
+class SharedMemory : public File {
+   public:
+    /**
+     * @brief Creates a zero-filled shared memory region.
+     *
+     * @param name Name of the memory file, only used for debugging
+     * (`/proc/<pid>/fd`)
+     * @param size The size of the region in bytes
+     * @return SharedMemory The region, invalid on failure (errno is set)
+     */
+    static SharedMemory create(const std::string &name, size_t size);
+
+    /**
+     * @brief Default constructor. This does not open a file descriptor.
+     *
+     */
+    SharedMemory();
+
+    /**
+     * @brief Maps the whole memory file `fd`, typically received from another
+     * process. Takes ownership of `fd`, which is closed if it cannot be
+     * mapped.
+     *
+     * @param fd The file descriptor of the memory file
+     */
+    explicit SharedMemory(int fd);
+
+    /**
+     * @brief Copy constructor. This will duplicate the underlying file
+     * descriptor using `dup` and map it again. Both objects refer to the same
+     * memory.
+     *
+     * @param src The SharedMemory to be copied
+     */
+    SharedMemory(const SharedMemory &src);
+
+    /**
+     * @brief Assignment operator. This will duplicate the underlying file
+     * descriptor using `dup` and map it again.
+     *
+     * @param src The SharedMemory to be copied
+     * @return SharedMemory& A reference to the destination SharedMemory
+     */
+    SharedMemory &operator=(const SharedMemory &src);
+
+    /**
+     * @brief Destructor. Unmaps the region and closes the file descriptor.
+     *
+     */
+    ~SharedMemory();
+
+    /**
+     * @brief Move constructor. The mapping moves with the file descriptor, so
+     * pointers into the region remain valid.
+     *
+     * @param src The SharedMemory to be moved
+     */
+    SharedMemory(SharedMemory &&src);
+
+    /**
+     * @brief Move assignment operator. Unmaps and closes the destination, if
+     * valid, then moves the source mapping and file descriptor.
+     *
+     * @param src The SharedMemory to be moved
+     * @return SharedMemory& A reference to the destination SharedMemory
+     */
+    SharedMemory &operator=(SharedMemory &&src);
+
+    uint8_t *data() const;
+    size_t size() const;
+
+   private:
+    /**
+     * @brief Maps the file descriptor. On failure the descriptor is closed and
+     * the object is invalid.
+     */
+    void map();
+    void unmap();
+
+    uint8_t *data_;
+    size_t size_;
+};
+
+}  // namespace ipc
+}  // namespace rix
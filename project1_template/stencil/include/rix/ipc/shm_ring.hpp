@@ -0,0 +1,161 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "rix/ipc/shared_memory.hpp"
+
+namespace rix {
+namespace ipc {
+
+/**
+ * @class ShmRing
+ * @brief A single-producer single-consumer ring buffer of variable size
+ * records in shared memory, so the producer and consumer can be different
+ * processes.
+ *
+ * @details Records use the layout of `util::SpscRing`: an 8-byte header, the
+ * record padded to 8 bytes, and never wrapping around the end of the buffer.
+ * The read and write indices live in the shared memory next to the buffer.
+ *
+ * Unlike `util::SpscRing`, the producer may overwrite the oldest records when
+ * the ring is full (`push` with `overwrite`), so a slow consumer loses old
+ * records instead of holding the producer back. To make this safe, both sides
+ * advance the read index with a compare-and-swap and `pop` copies the record
+ * out before claiming it: if the producer dropped the record while it was
+ * being copied, the copy is discarded and the next record is read.
+ *
+ * The ring also holds the flags used to wake a blocked consumer (`arm` and
+ * `disarm`) and to tell the consumer the producer is gone (`close`). Waking
+ * is left to the owner, typically with an eventfd passed along with the
+ * memory.
+ *
+ * Like `File`, operations are `const`: they act on the shared memory, not on
+ * the object.
+ */
+class ShmRing {
+   public:
+    /**
+     * @brief Creates an empty ring in a new shared memory region.
+     *
+     * @param capacity The size of the buffer in bytes, rounded up to a power
+     * of two of at least 64.
+     * @return ShmRing The ring, invalid on failure (errno is set)
+     */
+    static ShmRing create(size_t capacity);
+
+    /**
+     * @brief Default constructor. The ring is invalid.
+     *
+     */
+    ShmRing();
+
+    /**
+     * @brief Attaches to a ring created by `create`, typically in another
+     * process. The ring is invalid (errno is EINVAL) if the memory does not
+     * hold a ring.
+     *
+     * @param memory The shared memory of the ring
+     */
+    explicit ShmRing(SharedMemory memory);
+
+    ShmRing(const ShmRing &) = delete;
+    ShmRing &operator=(const ShmRing &) = delete;
+
+    /**
+     * @brief Move constructor. Invalidates the source ring.
+     *
+     * @param src The ShmRing to be moved
+     */
+    ShmRing(ShmRing &&src);
+
+    /**
+     * @brief Move assignment operator. Invalidates the source ring.
+     *
+     * @param src The ShmRing to be moved
+     * @return ShmRing& A reference to the destination ShmRing
+     */
+    ShmRing &operator=(ShmRing &&src);
+
+    bool ok() const;
+
+    /**
+     * @brief Returns the shared memory of the ring, to pass its file
+     * descriptor to the consumer.
+     *
+     */
+    const SharedMemory &memory() const;
+
+    /**
+     * @brief Copies a record into the ring. Producer only.
+     *
+     * @param data The record
+     * @param size The size of the record in bytes
+     * @param overwrite If true and the ring is full, the oldest records are
+     * dropped to make room. Otherwise the new record is dropped.
+     * @return true if the record was pushed, false if it was dropped or is
+     * larger than `max_record_size`.
+     */
+    bool push(const void *data, size_t size, bool overwrite) const;
+
+    /**
+     * @brief Copies the oldest record out of the ring and removes it.
+     * Consumer only.
+     *
+     * @param record Set to the record
+     * @return true if a record was read, false if the ring is empty.
+     */
+    bool pop(std::vector<uint8_t> &record) const;
+
+    bool empty() const;
+
+    /**
+     * @brief Returns the number of records dropped because the ring was full,
+     * either the oldest (overwritten) or the newest (rejected).
+     *
+     */
+    uint64_t dropped() const;
+
+    /**
+     * @brief Tells the producer the consumer is about to block. Consumer only.
+     *
+     * @return true if the ring is still empty, so the consumer may block until
+     * woken. false if records arrived meanwhile.
+     */
+    bool arm() const;
+
+    /**
+     * @brief Clears the flag set by `arm`. Producer only, after a push.
+     *
+     * @return true if the consumer was armed and must be woken.
+     */
+    bool disarm() const;
+
+    /**
+     * @brief Marks the ring as closed: no more records will be pushed.
+     *
+     */
+    void close() const;
+    bool closed() const;
+
+    size_t capacity() const;
+    size_t max_record_size() const;
+
+   private:
+    struct Header;
+
+    static constexpr uint32_t padding = 1;
+    static constexpr size_t header_size = 8;
+
+    static size_t align(size_t size) { return (size + 7) & ~size_t(7); }
+
+    SharedMemory memory_;
+    Header *header_;
+    uint8_t *buffer_;
+    size_t capacity_;
+};
+
+}  // namespace ipc
+}  // namespace rix
@@ -100,6 +100,15 @@ class Signal : public interfaces::Notification {
      */
     virtual bool wait(const rix::util::Duration &d) const;
 
+    /**
+     * @brief Returns the read end of the notification pipe, which becomes
+     * readable when the signal arrives, or -1 if the Signal is in an invalid
+     * state. This allows the Signal to be waited on together with other file
+     * descriptors. Call `wait` to consume the notification.
+     *
+     */
+    int fd() const override;
+
    private:
     /**
      * @brief SignalNotifier struct contains a pipe and an initialization flag.
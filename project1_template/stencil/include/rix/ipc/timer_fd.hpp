@@ -0,0 +1,128 @@
+#pragma once
+
+#include <sys/timerfd.h>
+
+#include "rix/ipc/file.hpp"
+
+namespace rix {
+namespace ipc {
+
+/**
+ * @class TimerFd
+ * @brief Kernel timer exposed as a file descriptor (see `timerfd_create(2)`).
+ * Inherits from the `File` class. The timer is driven by `CLOCK_MONOTONIC`, so
+ * it is unaffected by changes to the wall clock. The file becomes readable
+ * when the timer expires, which allows it to be waited on alongside other file
+ * descriptors with `poll`.
+ *
+ * Periodic timers are re-armed by the kernel relative to the previous
+ * expiration, not relative to when the expiration was consumed, so a loop
+ * driven by a TimerFd does not accumulate drift.
+ *
+ */
+class TimerFd : public File {
+   public:
+    /**
+     * @brief Creates a disarmed TimerFd on `CLOCK_MONOTONIC`.
+     *
+     * @param nonblocking Flag to toggle non-blocking IO
+     */
+    TimerFd(bool nonblocking = false);
+
+    /**
+     * @brief Copy constructor. This will duplicate the underlying file
+     * descriptor using `dup`. Both objects refer to the same kernel timer.
+     *
+     * @param src The TimerFd to be copied
+     */
+    TimerFd(const TimerFd &src);
+
+    /**
+     * @brief Assignment operator. This will duplicate the underlying file
+     * descriptor using `dup`. Both objects refer to the same kernel timer.
+     *
+     * @param src The TimerFd to be copied
+     */
+    TimerFd &operator=(const TimerFd &src);
+
+    /**
+     * @brief Move constructor. Moves the source file descriptor to the
+     * destination TimerFd and invalidates the source TimerFd.
+     *
+     * @param src The TimerFd to be moved
+     */
+    TimerFd(TimerFd &&src);
+
+    /**
+     * @brief Move assignment operator. If the destination TimerFd is valid,
+     * close the destination. Moves the source file descriptor to the
+     * destination TimerFd and invalidates the source TimerFd.
+     *
+     * @param src The TimerFd to be moved
+     */
+    TimerFd &operator=(TimerFd &&src);
+
+    /**
+     * @brief Destructor. This will close the underlying file descriptor.
+     *
+     */
+    ~TimerFd();
+
+    /**
+     * @brief Arms the timer. The first expiration occurs after `initial`
+     * elapses, and subsequent expirations occur every `interval`. An interval
+     * of zero creates a one-shot timer. An initial duration of zero or less
+     * expires as soon as possible.
+     *
+     * @param initial The duration until the first expiration
+     * @param interval The period of subsequent expirations
+     * @return true if the timer was armed successfully.
+     */
+    bool set(const util::Duration &initial, const util::Duration &interval = util::Duration()) const;
+
+    /**
+     * @brief Arms the timer as a one-shot timer that expires at an absolute
+     * time. Deadlines that have already passed expire as soon as possible.
+     * Unlike a relative duration, the deadline is not delayed by the time
+     * spent before the call.
+     *
+     * @param deadline The time of the expiration
+     * @return true if the timer was armed successfully.
+     */
+    bool set_at(const util::SteadyTime &deadline) const;
+
+    /**
+     * @brief Arms the timer to expire every `period`, starting one period from
+     * now.
+     *
+     * @param period The timer period
+     * @return true if the timer was armed successfully.
+     */
+    bool set_periodic(const util::Duration &period) const;
+
+    /**
+     * @brief Disarms the timer. Expirations that have not been consumed are
+     * discarded.
+     *
+     * @return true if the timer was disarmed successfully.
+     */
+    bool disarm() const;
+
+    /**
+     * @brief Returns `true` if the timer is currently armed.
+     *
+     */
+    bool armed() const;
+
+    /**
+     * @brief Consumes pending expirations. In blocking mode this waits for the
+     * next expiration.
+     *
+     * @return uint64_t The number of expirations since the last call, or 0 if
+     * none were pending (non-blocking mode) or an error occurred.
+     */
+    uint64_t consume() const;
+};
+
+}  // namespace ipc
+}  // namespace rix
@@ -0,0 +1,288 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rix/ipc/file.hpp"
+#include "rix/ipc/interfaces/io.hpp"
+#include "rix/ipc/shm_ring.hpp"
+#include "rix/ipc/unix_socket.hpp"
+#include "rix/util/time.hpp"
+
+namespace rix {
+namespace ipc {
+
+/**
+ * @brief What a publisher does when a subscriber's ring is full.
+ */
+enum class DropPolicy : uint32_t {
+    DROP_OLDEST, /**< Overwrite the oldest messages, so the newest always arrive */
+    DROP_NEWEST, /**< Drop the new message, so the subscriber sees an unbroken prefix */
+    DISCONNECT,  /**< Close the subscription, for subscribers that must not miss messages */
+};
+
+/**
+ * @brief Returns the path of the socket on which the publisher of `topic`
+ * accepts subscribers.
+ */
+std::string topic_path(const std::string &topic);
+
+/**
+ * @class TopicWriter
+ * @brief The publishing end of a named topic. Each `write` publishes one
+ * serialized message to every subscriber.
+ *
+ * @details The writer listens on a SEQPACKET UnixSocket at `topic_path(topic)`.
+ * A subscriber connects and sends the hash of its message type, the size of
+ * its ring and its `DropPolicy`. If the hash matches, the writer creates a
+ * `ShmRing` for the subscriber and sends back its shared memory and an eventfd
+ * with `UnixSocket::send_fds`. Publishing then only copies the message into
+ * each ring; the eventfd is only written when a subscriber is blocked waiting
+ * (see `ShmRing::arm`), so a busy subscriber costs no system call.
+ *
+ * Subscribers are accepted on a background thread. A subscriber that closes its
+ * connection (or exits) is removed. There is at most one writer per topic.
+ *
+ * Implements `interfaces::IO` so it can replace the output of an existing
+ * sender; messages are not size-prefixed.
+ */
+class TopicWriter : public interfaces::IO {
+   public:
+    /**
+     * @brief Creates the topic. The writer is invalid (see `ok`) if the topic
+     * name is invalid (EINVAL), if the topic already has a writer
+     * (EADDRINUSE), or if the socket cannot be created (errno is set).
+     *
+     * @param topic The name of the topic, without `/`
+     * @param hash The hash of the message type (see `Message::hash`)
+     */
+    TopicWriter(const std::string &topic, const std::array<uint64_t, 2> &hash);
+
+    TopicWriter(const TopicWriter &) = delete;
+    TopicWriter &operator=(const TopicWriter &) = delete;
+
+    /**
+     * @brief Destructor. Closes every subscription and removes the topic.
+     *
+     */
+    ~TopicWriter();
+
+    bool ok() const;
+
+    /**
+     * @brief Publishes one message to every subscriber.
+     *
+     * @return ssize_t `size`, even if some subscribers dropped the message.
+     */
+    ssize_t write(const uint8_t *src, size_t size) const override;
+
+    /**
+     * @brief Not supported, fails with EBADF.
+     *
+     */
+    ssize_t read(uint8_t *dst, size_t size) const override;
+
+    bool wait_for_writable(const rix::util::Duration &duration) const override;
+    bool wait_for_readable(const rix::util::Duration &duration) const override;
+    void set_nonblocking(bool status) override;
+    bool is_nonblocking() const override;
+
+    /**
+     * @brief Returns the number of subscribers.
+     *
+     */
+    size_t subscribers() const;
+
+   private:
+    struct Subscription;
+
+    void accept_loop();
+
+    /**
+     * @brief Reads the request of a new connection and, if it is valid,
+     * replies with the ring and eventfd and adds the subscriber.
+     */
+    void add_subscriber(UnixSocket &connection);
+
+    std::string path_;
+    std::array<uint64_t, 2> hash_;
+    UnixSocket listener_;
+    File stop_; /**< eventfd that stops the accept thread */
+    std::thread thread_;
+    mutable std::mutex mutex_;
+    mutable std::vector<std::shared_ptr<Subscription>> subscriptions_;
+};
+
+/**
+ * @class TopicReader
+ * @brief The subscribing end of a named topic. Each `read` returns one
+ * serialized message.
+ *
+ * @details Messages are read from a `ShmRing` owned by this subscriber. `fd`
+ * is an eventfd that becomes readable when messages arrive after the ring was
+ * found empty, or after subscribing, so the reader can be waited on with a
+ * `Poller` before its first `read`: it stays readable until a `read` finds
+ * the ring empty.
+ *
+ * Implements `interfaces::IO` so it can replace the input of an existing
+ * receiver; messages are not size-prefixed.
+ */
+class TopicReader : public interfaces::IO {
+   public:
+    static constexpr size_t default_capacity = 1 << 16;
+
+    /**
+     * @brief Subscribes to a topic. The reader is invalid (see `ok`) if the
+     * topic has no writer (ENOENT), if its message type differs (EPROTOTYPE),
+     * or on any other failure (errno is set).
+     *
+     * @param topic The name of the topic
+     * @param hash The hash of the message type (see `Message::hash`)
+     * @param capacity The size of the ring in bytes
+     * @param policy What the writer does when the ring is full
+     */
+    TopicReader(const std::string &topic, const std::array<uint64_t, 2> &hash,
+                size_t capacity = default_capacity, DropPolicy policy = DropPolicy::DROP_OLDEST);
+
+    bool ok() const;
+
+    /**
+     * @brief Reads one message. Messages larger than `size` are truncated.
+     * When no message is available, a non-blocking reader fails with EAGAIN
+     * and a blocking reader waits for one.
+     *
+     * @return ssize_t The size of the message, 0 if the writer is gone and
+     * every message was read, or -1 on error.
+     */
+    ssize_t read(uint8_t *dst, size_t size) const override;
+
+    /**
+     * @brief Not supported, fails with EBADF.
+     *
+     */
+    ssize_t write(const uint8_t *src, size_t size) const override;
+
+    bool wait_for_writable(const rix::util::Duration &duration) const override;
+
+    /**
+     * @brief Waits until a message is available or the writer is gone.
+     *
+     */
+    bool wait_for_readable(const rix::util::Duration &duration) const override;
+    void set_nonblocking(bool status) override;
+    bool is_nonblocking() const override;
+    int fd() const override;
+
+    /**
+     * @brief Returns false once the writer is gone or has closed this
+     * subscription (see `DropPolicy::DISCONNECT`). Messages already in the
+     * ring can still be read.
+     *
+     */
+    bool connected() const;
+
+    /**
+     * @brief Returns the number of messages dropped because the ring was full.
+     *
+     */
+    uint64_t dropped() const;
+
+   private:
+    /**
+     * @brief Pops a message, or arms the ring and consumes the pending wakeup
+     * when it is empty.
+     */
+    bool pop() const;
+
+    /**
+     * @brief Resets the eventfd, which may still be set by a wakeup whose
+     * messages were already read. Returns true if the ring is not empty.
+     */
+    bool consume_wakeup() const;
+
+    UnixSocket connection_;
+    ShmRing ring_;
+    File wakeup_; /**< eventfd written by the writer */
+    bool nonblocking_;
+    mutable std::vector<uint8_t> message_;
+};
+
+/**
+ * @class Publisher
+ * @brief Publishes messages of type `T` to a named topic (see `TopicWriter`).
+ */
+template <typename T>
+class Publisher {
+   public:
+    explicit Publisher(const std::string &topic) : writer_(topic, T().hash()) {}
+
+    bool ok() const { return writer_.ok(); }
+
+    /**
+     * @brief Serializes `msg` once and publishes it to every subscriber.
+     *
+     */
+    void publish(const T &msg) {
+        thread_local std::vector<uint8_t> buffer;
+        buffer.resize(msg.size());
+        size_t offset = 0;
+        msg.serialize(buffer.data(), offset);
+        writer_.write(buffer.data(), buffer.size());
+    }
+
+    size_t subscribers() const { return writer_.subscribers(); }
+
+   private:
+    TopicWriter writer_;
+};
+
+/**
+ * @class Subscriber
+ * @brief Receives messages of type `T` from a named topic (see
+ * `TopicReader`).
+ */
+template <typename T>
+class Subscriber {
+   public:
+    explicit Subscriber(const std::string &topic, size_t capacity = TopicReader::default_capacity,
+                        DropPolicy policy = DropPolicy::DROP_OLDEST)
+        : reader_(topic, T().hash(), capacity, policy), buffer_(capacity) {
+        reader_.set_nonblocking(true);
+    }
+
+    bool ok() const { return reader_.ok(); }
+
+    /**
+     * @brief Takes the oldest message without blocking.
+     *
+     * @return true if a message was taken, false if none is available or it
+     * could not be deserialized.
+     */
+    bool take(T &msg) {
+        ssize_t size = reader_.read(buffer_.data(), buffer_.size());
+        size_t offset = 0;
+        return size > 0 && msg.deserialize(buffer_.data(), size, offset);
+    }
+
+    /**
+     * @brief Waits until a message is available or the publisher is gone.
+     *
+     */
+    bool wait(const rix::util::Duration &duration) const { return reader_.wait_for_readable(duration); }
+
+    int fd() const { return reader_.fd(); }
+    bool connected() const { return reader_.connected(); }
+    uint64_t dropped() const { return reader_.dropped(); }
+
+   private:
+    TopicReader reader_;
+    std::vector<uint8_t> buffer_;
+};
+
+}  // namespace ipc
+}  // namespace rix
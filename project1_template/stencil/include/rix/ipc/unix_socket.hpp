@@ -0,0 +1,188 @@
+#pragma once
+
+#include <sys/socket.h>
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "rix/ipc/file.hpp"
+
+namespace rix {
+namespace ipc {
+
+/**
+ * @class UnixSocket
+ * @brief Local (Unix domain) socket. Inherits from the `File` class.
+ *
+ * A `STREAM` socket is a bidirectional byte stream, like a pair of pipes. A
+ * `SEQPACKET` socket preserves message boundaries: each `write` is received by
+ * exactly one `read`, so messages do not need a size prefix. Both types can
+ * pass open file descriptors to the peer (see `send_fds`), which is how
+ * shared memory is handed between processes.
+ *
+ * Use `pair` for a connected pair of sockets (like `Pipe::create`), or
+ * `listen`, `accept` and `connect` for sockets bound to a path. The factory
+ * methods return invalid sockets (see `ok`) on failure, with errno set.
+ *
+ */
+class UnixSocket : public File {
+   public:
+    enum class Type { STREAM = SOCK_STREAM, SEQPACKET = SOCK_SEQPACKET };
+
+    /**
+     * @brief Creates a pair of connected sockets (see `socketpair(2)`).
+     *
+     * @param type The socket type
+     * @return std::array<UnixSocket, 2> The two ends
+     */
+    static std::array<UnixSocket, 2> pair(Type type);
+
+    /**
+     * @brief Creates a listening socket bound to `path`. A socket file left at
+     * `path` by a listener that exited is removed first. Fails with
+     * EADDRINUSE if `path` is another kind of file or a listener is still
+     * accepting connections on it.
+     *
+     * @param path The path of the socket file
+     * @param type The socket type
+     * @param backlog The maximum number of pending connections
+     * @return UnixSocket The listening socket
+     */
+    static UnixSocket listen(const std::string &path, Type type, int backlog = 16);
+
+    /**
+     * @brief Connects to a listening socket bound to `path`.
+     *
+     * @param path The path of the socket file
+     * @param type The socket type, which must match the listener's
+     * @return UnixSocket The connected socket
+     */
+    static UnixSocket connect(const std::string &path, Type type);
+
+    /**
+     * @brief Default constructor. This does not open a file descriptor.
+     *
+     */
+    UnixSocket();
+
+    /**
+     * @brief Copy constructor. This will duplicate the underlying file
+     * descriptor using `dup`.
+     *
+     * @param src The UnixSocket to be copied.
+     */
+    UnixSocket(const UnixSocket &src);
+
+    /**
+     * @brief Assignment operator. This will duplicate the underlying file
+     * descriptor using `dup`.
+     *
+     * @param src The UnixSocket to be copied.
+     */
+    UnixSocket &operator=(const UnixSocket &src);
+
+    /**
+     * @brief Destructor. This will close the underlying file descriptor.
+     *
+     */
+    ~UnixSocket();
+
+    /**
+     * @brief Move constructor. Moves the source file descriptor to the
+     * destination UnixSocket and invalidates the source UnixSocket.
+     *
+     * @param src The UnixSocket to be moved
+     */
+    UnixSocket(UnixSocket &&src);
+
+    /**
+     * @brief Move assignment operator. If the destination UnixSocket is valid,
+     * close the destination. Moves the source file descriptor to the
+     * destination UnixSocket and invalidates the source UnixSocket.
+     *
+     * @param src The UnixSocket to be moved
+     * @return UnixSocket& A reference to the destination UnixSocket
+     */
+    UnixSocket &operator=(UnixSocket &&src);
+
+    /**
+     * @brief Accepts a pending connection on a listening socket. Blocks until
+     * a connection arrives unless the socket is non-blocking.
+     *
+     * @return UnixSocket The connected socket, invalid on failure
+     */
+    UnixSocket accept() const;
+
+    /**
+     * @brief Writes `size` bytes from `src` to the socket. Unlike `File::write`
+     * this does not raise `SIGPIPE` when the peer has closed; it fails with
+     * `EPIPE` instead.
+     *
+     * @return ssize_t The number of bytes actually written, or -1 on error.
+     */
+    ssize_t write(const uint8_t *src, size_t size) const override;
+
+    /**
+     * @brief Writes `size` bytes from `src` along with open file descriptors.
+     * The peer receives duplicates of `fds`, which remain open in this
+     * process.
+     *
+     * @return ssize_t The number of bytes actually written, or -1 on error.
+     */
+    ssize_t send_fds(const uint8_t *src, size_t size, const std::vector<int> &fds) const;
+
+    /**
+     * @brief Reads up to `size` bytes into `dst` along with any file
+     * descriptors sent with them. The caller owns the received descriptors.
+     *
+     * @param fds Set to the received file descriptors
+     * @param max_fds The maximum number of file descriptors to receive. Extra
+     * descriptors are closed by the kernel.
+     * @return ssize_t The number of bytes actually read, or -1 on error.
+     */
+    ssize_t receive_fds(uint8_t *dst, size_t size, std::vector<int> &fds, size_t max_fds = 16) const;
+
+    /**
+     * @brief Sets the size of the kernel send buffer (`SO_SNDBUF`). The kernel
+     * doubles the value to account for bookkeeping.
+     *
+     * @return true on success, false otherwise (errno is set).
+     */
+    bool set_send_buffer_size(int size);
+
+    /**
+     * @brief Sets the size of the kernel receive buffer (`SO_RCVBUF`).
+     *
+     * @return true on success, false otherwise (errno is set).
+     */
+    bool set_receive_buffer_size(int size);
+
+    /**
+     * @brief Returns the size of the kernel send buffer, or -1 on error.
+     *
+     */
+    int send_buffer_size() const;
+
+    /**
+     * @brief Returns the size of the kernel receive buffer, or -1 on error.
+     *
+     */
+    int receive_buffer_size() const;
+
+    Type type() const;
+
+   private:
+    /**
+     * @brief Private constructor used by the factory methods.
+     *
+     * @param fd The underlying file descriptor
+     * @param type The socket type
+     */
+    UnixSocket(int fd, Type type);
+
+    Type type_;
+};
+
+}  // namespace ipc
+}  // namespace rix
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "rix/util/log.hpp"
+#include "rix/util/time.hpp"
+
+/**
+ * @brief Writes a record to the binary log, if it is open. `format` must be a
+ * string literal in which each `{}` is replaced by the next argument when the
+ * log is decoded. Arguments may be integers, enums, floating point values,
+ * booleans, characters and strings.
+ *
+ * Example: `RIX_BLOG(rix::util::Log::INFO, "sent vx={} wz={}", vx, wz);`
+ */
+#define RIX_BLOG(level, format, ...) \
+    ::rix::util::BinaryLog::log([] {}, __FILE__, __LINE__, level, format __VA_OPT__(, ) __VA_ARGS__)
+
+namespace rix {
+namespace util {
+
+namespace detail {
+
+template <typename T>
+inline constexpr bool dependent_false = false;
+
+/**
+ * @brief The type code of a binary log argument, stored in the call site
+ * descriptor so records only carry the raw values.
+ */
+template <typename T>
+constexpr char binary_log_type() {
+    using U = std::decay_t<T>;
+    if constexpr (std::is_same_v<U, bool>) {
+        return 'b';
+    } else if constexpr (std::is_same_v<U, char>) {
+        return 'c';
+    } else if constexpr (std::is_enum_v<U> || (std::is_integral_v<U> && std::is_signed_v<U>)) {
+        return 'i';
+    } else if constexpr (std::is_integral_v<U>) {
+        return 'u';
+    } else if constexpr (std::is_floating_point_v<U>) {
+        return 'd';
+    } else if constexpr (std::is_convertible_v<const U &, std::string_view>) {
+        return 's';
+    } else {
+        static_assert(dependent_false<U>, "Unsupported binary log argument type");
+    }
+}
+
+template <typename T>
+size_t binary_log_size(const T &value) {
+    constexpr char type = binary_log_type<T>();
+    if constexpr (type == 'b' || type == 'c') {
+        return 1;
+    } else if constexpr (type == 's') {
+        return sizeof(uint32_t) + std::string_view(value).size();
+    } else {
+        return 8;
+    }
+}
+
+template <typename T>
+void binary_log_encode(uint8_t *&data, const T &value) {
+    constexpr char type = binary_log_type<T>();
+    if constexpr (type == 'b' || type == 'c') {
+        *data++ = static_cast<uint8_t>(value);
+    } else if constexpr (type == 'i') {
+        int64_t v = static_cast<int64_t>(value);
+        std::memcpy(data, &v, sizeof(v));
+        data += sizeof(v);
+    } else if constexpr (type == 'u') {
+        uint64_t v = static_cast<uint64_t>(value);
+        std::memcpy(data, &v, sizeof(v));
+        data += sizeof(v);
+    } else if constexpr (type == 'd') {
+        double v = static_cast<double>(value);
+        std::memcpy(data, &v, sizeof(v));
+        data += sizeof(v);
+    } else {
+        std::string_view v(value);
+        uint32_t size = static_cast<uint32_t>(v.size());
+        std::memcpy(data, &size, sizeof(size));
+        std::memcpy(data + sizeof(size), v.data(), v.size());
+        data += sizeof(size) + v.size();
+    }
+}
+
+}  // namespace detail
+
+/**
+ * @brief A binary structured log for high-rate telemetry.
+ *
+ * @details Each `RIX_BLOG` call site registers a descriptor (file, line, level,
+ * format string and argument types) the first time it runs while the log is
+ * open. The descriptor is written to the log once, and each record then only
+ * stores a timestamp, the site id and the raw bytes of the arguments. No text
+ * is formatted when logging; `decode` (and the `rix_log_decode` tool)
+ * reconstructs the text offline.
+ *
+ * Records are appended to an in-memory buffer. Once it exceeds `buffer_size`
+ * it is handed to a background thread that writes it to the file, so logging
+ * never waits on the disk. If `max_pending` buffers are still waiting to be
+ * written, records are dropped instead (see `dropped`). `flush` and `close`
+ * wait until everything buffered is written.
+ *
+ * The file starts with the 8 bytes `RIXBLOG1`, followed by entries made of a
+ * `uint32_t` id, a `uint32_t` payload size and the payload. Entries with id 0
+ * describe a call site: its id, line and level (`int32_t` each), then the
+ * file, format and argument types, each a `uint32_t` length and characters.
+ * Other entries are records of that site: an `int64_t` timestamp (ns since the
+ * epoch) followed by the arguments. Integers and floating point values are
+ * stored as 8 bytes, booleans and characters as 1 byte, and strings as a
+ * `uint32_t` length and characters, all in host byte order.
+ *
+ * Thread-safe.
+ */
+class BinaryLog {
+   public:
+    static constexpr size_t buffer_size = 1 << 16;
+    static constexpr size_t max_pending = 64;
+
+    /**
+     * @brief Opens a binary log file, truncating it. Closes the current file
+     * first, if any.
+     * @param path The path of the file.
+     * @return true if the file was opened, false otherwise (errno is set).
+     */
+    static bool open(const std::string &path);
+
+    /**
+     * @brief Writes the buffered records and closes the file.
+     * @return true if all records were written, false otherwise (errno is set).
+     */
+    static bool close();
+
+    /**
+     * @brief Writes the buffered records to the file.
+     * @return true if all records were written, false otherwise (errno is set).
+     */
+    static bool flush();
+
+    static bool is_open() { return open_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Returns the number of records dropped because the disk could not
+     * keep up, since the file was opened.
+     */
+    static uint64_t dropped() { return dropped_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Writes a record. Use `RIX_BLOG`, which passes a unique `Tag` per
+     * call site so each site registers its descriptor exactly once.
+     */
+    template <typename Tag, typename... Args>
+    static void log(Tag, const char *file, int line, Log::Level level, const char *format, const Args &...args);
+
+    /**
+     * @brief Converts a binary log to text, one line per record.
+     * @param is The binary log.
+     * @param os The stream to write the text to.
+     * @param local_time If true, timestamps are printed in local time instead
+     * of GMT.
+     * @return true if the whole log was decoded, false if it is not a binary
+     * log or is corrupted. A log truncated in the middle of a record (for
+     * example by a crash) decodes up to that record.
+     */
+    static bool decode(std::istream &is, std::ostream &os, bool local_time = false);
+
+   private:
+    static uint32_t register_site(const char *file, int line, Log::Level level, const char *format,
+                                  const char *types);
+    static void write(uint32_t site, int64_t stamp, const uint8_t *data, size_t size);
+
+    inline static std::atomic<bool> open_{false};
+    inline static std::atomic<uint64_t> dropped_{0};
+};
+
+template <typename Tag, typename... Args>
+void BinaryLog::log(Tag, const char *file, int line, Log::Level level, const char *format, const Args &...args) {
+    if (!is_open()) {
+        return;
+    }
+    int64_t stamp = Time::now().to_nanoseconds();
+
+    static const char types[] = {detail::binary_log_type<Args>()..., '\0'};
+    static const uint32_t site = register_site(file, line, level, format, types);
+
+    thread_local std::vector<uint8_t> buffer;
+    buffer.resize((detail::binary_log_size(args) + ... + 0));
+    [[maybe_unused]] uint8_t *data = buffer.data();
+    (detail::binary_log_encode(data, args), ...);
+    write(site, stamp, buffer.data(), buffer.size());
+}
+
+}  // namespace util
+}  // namespace rix
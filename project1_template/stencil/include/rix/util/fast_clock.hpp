@@ -0,0 +1,158 @@
+#pragma once
+
+#include <time.h>
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define RIX_UTIL_FAST_CLOCK_TSC 1
+#else
+#define RIX_UTIL_FAST_CLOCK_TSC 0
+#endif
+
+#include "rix/util/time.hpp"
+
+namespace rix {
+namespace util {
+
+/**
+ * @brief A low-overhead tick source for hot-path instrumentation.
+ *
+ * @details On x86 CPUs with an invariant TSC (constant rate across frequency
+ * and power state changes, CPUID 0x80000007 EDX bit 8), ticks are read
+ * directly from the time stamp counter, which costs a few nanoseconds and no
+ * system call. The tick rate is calibrated once against `CLOCK_MONOTONIC`,
+ * which takes a 10 ms sleep, and ticks are converted to nanoseconds with a
+ * fixed-point multiply. Call `init` at startup so the calibration does not
+ * stall the first caller, typically a control loop; otherwise it happens on
+ * first use. On other CPUs, or when the TSC is not invariant, ticks are
+ * nanoseconds read from `clock_gettime(CLOCK_MONOTONIC)` (served by the vDSO,
+ * so still without a system call).
+ *
+ * Ticks are only meaningful within the same process on the same machine. Use
+ * `Time` for stamps that are shared with other processes.
+ */
+class FastClock {
+   public:
+    using Ticks = uint64_t;
+
+    /**
+     * @brief Calibrates the tick rate now, if it was not done yet. Sleeps for
+     * the calibration window the first time. `Log::init` calls this.
+     */
+    static void init();
+
+    /**
+     * @brief Reads the tick counter. The read may be reordered with earlier
+     * instructions, so use this to mark the start of a measured region.
+     * @return Ticks The current tick count.
+     */
+    static Ticks now();
+
+    /**
+     * @brief Reads the tick counter after all earlier instructions have
+     * completed (rdtscp). Use this to mark the end of a measured region.
+     * @return Ticks The current tick count.
+     */
+    static Ticks now_ordered();
+
+    /**
+     * @brief Converts a number of ticks to nanoseconds.
+     * @param ticks The number of ticks (typically a difference of two reads).
+     * @return int64_t The number of nanoseconds.
+     */
+    static int64_t to_nanoseconds(Ticks ticks);
+
+    /**
+     * @brief Converts a number of ticks to a Duration.
+     * @param ticks The number of ticks (typically a difference of two reads).
+     * @return Duration The duration.
+     */
+    static Duration to_duration(Ticks ticks);
+
+    /**
+     * @brief Gets the elapsed Duration between two tick counts.
+     * @param start The earlier tick count.
+     * @param end The later tick count.
+     * @return Duration The elapsed time, or zero if `end` is before `start`.
+     */
+    static Duration elapsed(Ticks start, Ticks end);
+
+    /**
+     * @brief Converts a tick count to a point on the monotonic clock.
+     * @param ticks The tick count.
+     * @return SteadyTime The corresponding time.
+     */
+    static SteadyTime to_steady_time(Ticks ticks);
+
+    /**
+     * @brief Whether ticks are read from the time stamp counter.
+     */
+    static bool uses_tsc();
+
+    /**
+     * @brief Whether the CPU reports an invariant time stamp counter.
+     */
+    static bool invariant_tsc();
+
+    /**
+     * @brief The calibrated number of ticks per second.
+     */
+    static double frequency();
+
+   private:
+    struct Calibration {
+        bool tsc;
+        uint64_t mult;  // nanoseconds per tick in 32.32 fixed point
+        Ticks base_ticks;
+        int64_t base_ns;
+    };
+
+    static const Calibration &calibration();
+    static Calibration calibrate();
+    static Ticks monotonic_ns();
+};
+
+inline FastClock::Ticks FastClock::monotonic_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<Ticks>(ts.tv_sec) * 1'000'000'000 + static_cast<Ticks>(ts.tv_nsec);
+}
+
+inline const FastClock::Calibration &FastClock::calibration() {
+    static const Calibration c = calibrate();
+    return c;
+}
+
+inline void FastClock::init() { calibration(); }
+
+inline FastClock::Ticks FastClock::now() {
+#if RIX_UTIL_FAST_CLOCK_TSC
+    if (calibration().tsc) {
+        return __rdtsc();
+    }
+#endif
+    return monotonic_ns();
+}
+
+inline FastClock::Ticks FastClock::now_ordered() {
+#if RIX_UTIL_FAST_CLOCK_TSC
+    if (calibration().tsc) {
+        unsigned int aux;
+        return __rdtscp(&aux);
+    }
+#endif
+    return monotonic_ns();
+}
+
+inline int64_t FastClock::to_nanoseconds(Ticks ticks) {
+    return static_cast<int64_t>((static_cast<unsigned __int128>(ticks) * calibration().mult) >> 32);
+}
+
+inline Duration FastClock::to_duration(Ticks ticks) { return Duration(Duration::Type(to_nanoseconds(ticks))); }
+
+inline Duration FastClock::elapsed(Ticks start, Ticks end) { return end > start ? to_duration(end - start) : Duration(); }
+
+}  // namespace util
+}  // namespace rix
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rix {
+namespace util {
+
+class Duration;  // Forward declaration, time.hpp includes this header
+
+/**
+ * @brief A histogram of non-negative integer values (typically latencies in
+ * nanoseconds) with bounded relative error.
+ *
+ * @details Values are grouped into log-linear buckets: every power of two is
+ * split into 32 equal sub-buckets, so any recorded value is reported with a
+ * relative error below 1/32 (~3%) across the whole 64-bit range. Recording is
+ * a handful of integer operations and never allocates, which makes the
+ * histogram cheap enough to update for every message.
+ */
+class Histogram {
+   public:
+    /**
+     * @brief Constructs an empty histogram.
+     */
+    Histogram();
+
+    Histogram(const Histogram &other);
+    Histogram &operator=(const Histogram &other);
+
+    /**
+     * @brief Records a value. Negative values are recorded as zero.
+     * @param value The value to record.
+     * @param count The number of times to record the value.
+     */
+    void record(int64_t value, uint64_t count = 1);
+
+    /**
+     * @brief Records a duration in nanoseconds.
+     * @param duration The duration to record.
+     */
+    void record(const Duration &duration);
+
+    /**
+     * @brief Adds every value recorded in `other` to this histogram.
+     * @param other The histogram to merge.
+     */
+    void merge(const Histogram &other);
+
+    /**
+     * @brief Removes all recorded values.
+     */
+    void reset();
+
+    uint64_t count() const;
+    int64_t min() const;
+    int64_t max() const;
+    double mean() const;
+
+    /**
+     * @brief Returns the value below which `percentile` percent of the
+     * recorded values fall, or 0 if the histogram is empty.
+     * @param percentile The percentile, between 0 and 100.
+     */
+    int64_t percentile(double percentile) const;
+
+   private:
+    static constexpr int sub_bucket_bits = 5;
+    static constexpr int64_t sub_bucket_count = int64_t(1) << sub_bucket_bits;
+
+    static size_t index_of(int64_t value);
+    static int64_t highest_value_of(size_t index);
+
+    std::vector<uint64_t> counts_;
+    uint64_t total_;
+    int64_t min_;
+    int64_t max_;
+    double sum_;
+};
+
+}  // namespace util
+}  // namespace rix
@@ -4,19 +4,58 @@
 #define RIX_UTIL_LOG_LEVEL 1
 #endif
 
+/**
+ * @brief Logs to `rix::util::Log::stream` on the first and then every `n`th
+ * execution of the statement, e.g.
+ * `RIX_LOG_EVERY_N(warn, 100) << "Dropped frame" << std::endl;`. When the
+ * level is disabled, the statement costs a single relaxed atomic load and its
+ * arguments are not evaluated.
+ */
+#define RIX_LOG_EVERY_N(stream, n)                                                           \
+    if (!::rix::util::Log::stream.enabled()) {                                               \
+    } else if (static ::rix::util::detail::EveryN rix_log_every_; !rix_log_every_.tick(n)) { \
+    } else                                                                                   \
+        ::rix::util::Log::stream
+
+/**
+ * @brief Logs to `rix::util::Log::stream` at most once every `seconds`, e.g.
+ * `RIX_LOG_EVERY_T(info, 1.0) << "Queue depth " << depth << std::endl;`. When
+ * the level is disabled, the statement costs a single relaxed atomic load.
+ */
+#define RIX_LOG_EVERY_T(stream, seconds)                                                           \
+    if (!::rix::util::Log::stream.enabled()) {                                                     \
+    } else if (static ::rix::util::detail::EveryT rix_log_every_; !rix_log_every_.tick(seconds)) { \
+    } else                                                                                         \
+        ::rix::util::Log::stream
+
+#include <fcntl.h>
 #include <pwd.h>
+#include <signal.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cerrno>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <mutex>
+#include <thread>
+#include <vector>
 
+#include "rix/util/fast_clock.hpp"
+#include "rix/util/spsc_ring.hpp"
 #include "rix/util/time.hpp"
 
 namespace rix {
@@ -29,32 +68,82 @@ namespace detail {
  * once. This is used by the Log class to write data to both stdout and a log
  * file at the same time.
  *
+ * Data is collected in the put area, a buffer owned by the TeeBuffer, so
+ * writing a character or a span that fits does not call a virtual function.
+ * The data is forwarded on `sync` (for example on `std::endl`) or when the
+ * buffer is full, with one call per target: `sputn` for stream buffers, and a
+ * single `writev` of the buffered data and the new span for file
+ * descriptors. Spans larger than the buffer are forwarded without being
+ * copied.
+ *
+ * Like any stream buffer, a TeeBuffer must not be written by several threads
+ * at once; `Log` only writes to its TeeBuffer under a lock.
+ *
  */
 class TeeBuffer : public std::streambuf {
    public:
+    static constexpr size_t buffer_size = 4096;
+
     TeeBuffer(std::vector<std::streambuf *> targets);
+    explicit TeeBuffer(int fd);
+    TeeBuffer(const TeeBuffer &other);
+    ~TeeBuffer() override;
+
+    void add(std::streambuf *target);
+
+    /**
+     * @brief Adds a file descriptor target. The descriptor is not closed by
+     * the TeeBuffer.
+     */
+    void add(int fd);
 
+   protected:
     int overflow(int c) override;
+    std::streamsize xsputn(const char *s, std::streamsize n) override;
     int sync() override;
-    void add(std::streambuf *target);
 
    private:
+    /**
+     * @brief Forwards the put area followed by `s` to every target, then
+     * empties the put area.
+     */
+    bool forward(const char *s, size_t n);
+
     std::vector<std::streambuf *> targets_;
+    std::vector<int> fds_;
+    std::array<char, buffer_size> buffer_;
 };
 
-inline TeeBuffer::TeeBuffer(std::vector<std::streambuf *> targets) : targets_(targets) {}
+inline TeeBuffer::TeeBuffer(std::vector<std::streambuf *> targets) : targets_(targets) {
+    setp(buffer_.data(), buffer_.data() + buffer_.size());
+}
+inline TeeBuffer::TeeBuffer(int fd) : fds_{fd} { setp(buffer_.data(), buffer_.data() + buffer_.size()); }
+inline TeeBuffer::TeeBuffer(const TeeBuffer &other) : std::streambuf(), targets_(other.targets_), fds_(other.fds_) {
+    setp(buffer_.data(), buffer_.data() + buffer_.size());
+}
+inline TeeBuffer::~TeeBuffer() { sync(); }
 inline int TeeBuffer::overflow(int c) {
-    if (c != EOF) {
-        for (auto target : targets_) {
-            if (target->sputc(c) == EOF) {
-                return EOF;
-            }
-        }
+    // Only called when the put area is full
+    if (c == EOF) {
+        return 0;
     }
-    return 0;
+    if (!forward(nullptr, 0)) {
+        return EOF;
+    }
+    *pptr() = static_cast<char>(c);
+    pbump(1);
+    return c;
+}
+inline std::streamsize TeeBuffer::xsputn(const char *s, std::streamsize n) {
+    if (n <= epptr() - pptr()) {
+        std::memcpy(pptr(), s, n);
+        pbump(static_cast<int>(n));
+        return n;
+    }
+    return forward(s, n) ? n : 0;
 }
 inline int TeeBuffer::sync() {
-    int result = 0;
+    int result = forward(nullptr, 0) ? 0 : -1;
     for (auto target : targets_) {
         if (target->pubsync() == -1) {
             result = -1;
@@ -63,6 +152,43 @@ inline int TeeBuffer::sync() {
     return result;
 }
 inline void TeeBuffer::add(std::streambuf *target) { targets_.push_back(target); }
+inline void TeeBuffer::add(int fd) { fds_.push_back(fd); }
+inline bool TeeBuffer::forward(const char *s, size_t n) {
+    size_t buffered = pptr() - pbase();
+    bool ok = true;
+    for (auto target : targets_) {
+        if (target->sputn(pbase(), buffered) != static_cast<std::streamsize>(buffered) ||
+            target->sputn(s, n) != static_cast<std::streamsize>(n)) {
+            ok = false;
+        }
+    }
+    for (int fd : fds_) {
+        iovec iov[2] = {{pbase(), buffered}, {const_cast<char *>(s), n}};
+        int first = buffered == 0 ? 1 : 0;
+        int count = n == 0 ? 1 : 2;
+        while (first < count) {
+            ssize_t written = ::writev(fd, iov + first, count - first);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                ok = false;
+                break;
+            }
+            // Skip what was written, possibly part of a span
+            while (first < count && static_cast<size_t>(written) >= iov[first].iov_len) {
+                written -= iov[first].iov_len;
+                first++;
+            }
+            if (first < count) {
+                iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + written;
+                iov[first].iov_len -= written;
+            }
+        }
+    }
+    setp(buffer_.data(), buffer_.data() + buffer_.size());
+    return ok;
+}
 
 /**
  * @brief TeeStream class. This is used to write data to multiple streams at
@@ -92,6 +218,79 @@ class NullBuffer : public std::streambuf {
 
 inline int NullBuffer::overflow(int c) { return c; }
 
+/**
+ * @brief NullStream class. A stream over a NullBuffer that is always in the
+ * bad state, so insertions return immediately without formatting their
+ * argument.
+ *
+ */
+class NullStream : public std::ostream {
+   public:
+    NullStream() : std::ostream(&buffer_) { setstate(std::ios::badbit); }
+
+   private:
+    NullBuffer buffer_;
+};
+
+/**
+ * @brief Header of a record queued by an asynchronous log call. The text of
+ * the record follows it in the queue.
+ *
+ */
+struct LogRecord {
+    static constexpr uint32_t continuation = 1;  //< Text logged after a flush, written without a header
+
+    int64_t stamp;   //< Time of the log call (ns since the epoch)
+    int32_t level;
+    uint32_t flags;
+};
+
+/**
+ * @brief The record queue of a thread that logs asynchronously. It is shared by
+ * the thread and the writer, so records queued just before the thread exits
+ * are still written.
+ *
+ */
+struct LogQueue {
+    explicit LogQueue(size_t capacity) : ring(capacity), closed(false) {}
+
+    SpscRing ring;
+    std::atomic<bool> closed;  //< Set when the thread exits, no more records will be pushed
+};
+
+/**
+ * @brief Per call site state of `RIX_LOG_EVERY_N`.
+ *
+ */
+class EveryN {
+   public:
+    bool tick(uint64_t n) { return n <= 1 || count_.fetch_add(1, std::memory_order_relaxed) % n == 0; }
+
+   private:
+    std::atomic<uint64_t> count_{0};
+};
+
+/**
+ * @brief Per call site state of `RIX_LOG_EVERY_T`.
+ *
+ */
+class EveryT {
+   public:
+    bool tick(double seconds) {
+        int64_t now = FastClock::to_nanoseconds(FastClock::now());
+        int64_t next = next_.load(std::memory_order_relaxed);
+        if (now < next) {
+            return false;
+        }
+        // Only one of the threads that reach the deadline together logs
+        return next_.compare_exchange_strong(next, now + static_cast<int64_t>(seconds * 1e9),
+                                             std::memory_order_relaxed);
+    }
+
+   private:
+    std::atomic<int64_t> next_{std::numeric_limits<int64_t>::min()};
+};
+
 }  // namespace detail
 
 /**
@@ -109,14 +308,8 @@ class Log {
     enum Level { DEBUG, INFO, WARN, ERROR, FATAL };
 
    private:
-    /**
-     * @brief static declaration of NullBuffer used by LogStream objects to
-     * "write" to when the RIX_UTIL_LOG_LEVEL < level.
-     *
-     */
-    inline static detail::NullBuffer null_buffer{};
-    inline static std::ofstream logFile{};
-    inline static detail::TeeBuffer tee_buffer{std::vector<std::streambuf *>{std::cout.rdbuf()}};
+    inline static int log_fd{-1};
+    inline static detail::TeeBuffer tee_buffer{STDOUT_FILENO};
     inline static std::mutex mutex{};
 
     /**
@@ -134,17 +327,161 @@ class Log {
         template <typename T>
         std::ostream &operator<<(const T &val);
 
-        inline static std::ostream null_stream{&Log::null_buffer};
-        inline static std::ostream tee_stream{&Log::tee_buffer};
-        inline static std::mutex &mutex{Log::mutex};
+        /**
+         * @brief Returns `true` if data logged to this stream is currently
+         * written. Costs a single relaxed atomic load.
+         */
+        bool enabled() const {
+            return level >= RIX_UTIL_LOG_LEVEL && level >= runtime_level.load(std::memory_order_relaxed);
+        }
+
+        inline static detail::NullStream null_stream{};
 
-        inline static std::string create_header(const Time &t);
-        inline static std::string create_plain_header(const Time &t);
+        /**
+         * @brief Writes the header of a log line into `buffer` without
+         * allocating. The header is truncated if the buffer is too small.
+         * @return size_t The length of the header.
+         */
+        inline static size_t create_header(char *buffer, size_t size, const Time &t);
+        inline static size_t create_plain_header(char *buffer, size_t size, const Time &t);
+
+        static constexpr size_t header_size = 256;
+    };
+
+    /**
+     * @brief RecordBuffer class. Each thread logs into its own RecordBuffer,
+     * which collects the text of a log call in its put area and emits it as
+     * one record when the stream is flushed (for example by `std::endl`) or
+     * when the next log call begins. While the asynchronous writer runs the
+     * record is queued for it; otherwise it is written to `tee_buffer` with
+     * its header, under `mutex`.
+     *
+     */
+    class RecordBuffer : public std::streambuf {
+       public:
+        RecordBuffer();
+        ~RecordBuffer();
+
+        void begin(Level level, const Time &t);
+
+        /**
+         * @brief Emits the text logged since the last record.
+         *
+         * @param flush Whether to also flush `tee_buffer` in synchronous
+         * mode.
+         */
+        void flush_record(bool flush = false);
+
+       protected:
+        int overflow(int c) override;
+        std::streamsize xsputn(const char *s, std::streamsize n) override;
+        int sync() override;
+
+       private:
+        /**
+         * @brief Grows the put area to hold at least `extra` more characters.
+         */
+        void reserve(size_t extra);
+
+        detail::LogRecord record_{};
+        std::string text_; /**< Storage of the put area */
+        std::shared_ptr<detail::LogQueue> queue_;
     };
 
+    inline static std::ostream &thread_stream();
+    inline static void write_loop();
+    inline static void join_async();
+    inline static size_t create_header(Level level, char *buffer, size_t size, const Time &t);
+
+    inline static std::atomic<bool> async_enabled{false};
+    inline static std::atomic<bool> async_running{false};
+    inline static std::atomic<bool> writer_sleeping{false};
+    inline static std::atomic<uint64_t> async_dropped{0};
+    inline static size_t queue_capacity{1 << 16};
+    inline static std::mutex async_mutex{};
+    inline static std::condition_variable async_cv{};
+    inline static std::vector<std::shared_ptr<detail::LogQueue>> queues{};
+    inline static std::thread writer{};
+
    public:
+    /**
+     * @brief Sets the name shown in every header and, if `logToFile` is set,
+     * also writes the log to ~/.rix/log. Also calibrates `FastClock`, which
+     * `RIX_LOG_EVERY_T` uses, so the first rate-limited log call does not
+     * stall its caller.
+     *
+     */
     inline static void init(const std::string &name, bool logToFile = false);
 
+    /**
+     * @brief Switches to asynchronous logging. Log calls format their text
+     * into a per-thread buffer and queue it in a per-thread lock-free ring,
+     * without taking a lock or making a system call. A background thread
+     * formats the headers and writes the records in batches, ordered by the
+     * time of the log call. If a ring is full the record is dropped, and the
+     * number of dropped records is logged by the writer.
+     *
+     * Call `stop_async` before returning from `main`. The writer is also
+     * stopped at exit as a fallback, but by then the main thread's buffer is
+     * gone, so only records already queued are written.
+     *
+     * @param capacity The size in bytes of each thread's ring.
+     */
+    inline static void start_async(size_t capacity = 1 << 16);
+
+    /**
+     * @brief Writes all queued records, stops the background thread and
+     * returns to synchronous logging.
+     *
+     */
+    inline static void stop_async();
+
+    inline static bool is_async() { return async_enabled.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Returns the number of records dropped because a ring was full.
+     *
+     */
+    inline static uint64_t dropped() { return async_dropped.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Returns `true` if data logged at `level` is written. This is a
+     * compile time constant, so statements guarded by `if constexpr` are
+     * removed entirely when the level is disabled, including the formatting of
+     * their arguments.
+     *
+     */
+    static constexpr bool enabled(Level level) { return level >= RIX_UTIL_LOG_LEVEL; }
+
+    /**
+     * @brief Sets the lowest level that is written, without restarting.
+     * Levels below RIX_UTIL_LOG_LEVEL stay compiled out, so to enable debug
+     * output at runtime, build with RIX_UTIL_LOG_LEVEL=0 and set the default
+     * level here.
+     *
+     */
+    static void set_level(Level level) { runtime_level.store(level, std::memory_order_relaxed); }
+    static Level level() { return static_cast<Level>(runtime_level.load(std::memory_order_relaxed)); }
+
+    /**
+     * @brief Returns `true` if data logged at `level` is written, taking the
+     * runtime level into account.
+     *
+     */
+    static bool is_enabled(Level level) {
+        return enabled(level) && level >= runtime_level.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Installs a handler that switches between the current level and
+     * `level` each time the process receives `signum`, for example to turn
+     * on debug output for a while with `kill -USR2`.
+     *
+     * @return true if the handler was installed, false otherwise (errno is
+     * set).
+     */
+    inline static bool toggle_level_on_signal(int signum, Level level);
+
     /**
      * The public LogStream objects. These are used to log inforamtion at the
      * corresponding level. If RIX_UTIL_LOG_LEVEL is greater than the template
@@ -163,65 +500,356 @@ class Log {
     inline static const std::string unbold = "\x1b[22m";
     inline static std::string name;
     inline static bool is_init{false};
+    inline static std::atomic<int> runtime_level{Level::DEBUG};
+    inline static std::atomic<int> toggle_level{Level::DEBUG};
+    inline static std::atomic<int> saved_level{Level::DEBUG};
+
+    inline static void on_toggle_signal(int signum);
 
     inline static std::string get_color_code(Level level);
     inline static std::string get_level_string(Level level);
 };
 
+namespace detail {
+
+/**
+ * @brief Appends `data` to a fixed size buffer, truncating it if it does not
+ * fit. Keeps room for a null terminator.
+ */
+inline void append(char *buffer, size_t size, size_t &length, const char *data, size_t data_size) {
+    size_t n = std::min(data_size, size - 1 - length);
+    std::memcpy(buffer + length, data, n);
+    length += n;
+    buffer[length] = '\0';
+}
+
+inline void append(char *buffer, size_t size, size_t &length, const std::string &data) {
+    append(buffer, size, length, data.data(), data.size());
+}
+
+}  // namespace detail
+
 template <Log::Level level>
 template <typename T>
 inline std::ostream &Log::LogStream<level>::operator<<(const T &val) {
-    if (level < RIX_UTIL_LOG_LEVEL) {
+    if (!enabled()) {
         return null_stream;
     }
 
-    std::lock_guard<std::mutex> guard(mutex);
-    std::string header = create_header(Time::now());
-    return tee_stream << header << val;
+    std::ostream &stream = thread_stream();
+    static_cast<RecordBuffer *>(stream.rdbuf())->begin(level, Time::now());
+    return stream << val;
 }
 
 template <Log::Level level>
-inline std::string Log::LogStream<level>::create_header(const Time &t) {
-    std::stringstream ss;
+inline size_t Log::LogStream<level>::create_header(char *buffer, size_t size, const Time &t) {
+    // The level field only depends on the level, so it is formatted once
+    static const std::string level_field = [] {
+        std::stringstream ss;
+        std::string level_str = "[" + bold + get_color_code(level) + get_level_string(level) + reset_color + "] ";
+        ss << std::setw(21) << std::left << level_str;
+        return ss.str();
+    }();
 
     // Date field
-    ss << "[" << t.to_string() << "] ";
+    size_t length = 0;
+    detail::append(buffer, size, length, "[", 1);
+    length += t.format(buffer + length, size - length);
+    detail::append(buffer, size, length, "] ", 2);
 
     // Level field
-    std::string level_str = "[" + bold + get_color_code(level) + get_level_string(level) + reset_color + "] ";
-    ss << std::setw(21) << std::left << level_str;
+    detail::append(buffer, size, length, level_field);
 
     // Name field
     if (is_init) {
-        ss << "[" << bold << name << unbold << "] ";
+        detail::append(buffer, size, length, "[", 1);
+        detail::append(buffer, size, length, bold);
+        detail::append(buffer, size, length, name);
+        detail::append(buffer, size, length, unbold);
+        detail::append(buffer, size, length, "] ", 2);
     }
 
-    return ss.str();
+    return length;
 }
 
 template <Log::Level level>
-inline std::string Log::LogStream<level>::create_plain_header(const Time &t) {
-    std::stringstream ss;
+inline size_t Log::LogStream<level>::create_plain_header(char *buffer, size_t size, const Time &t) {
+    static const std::string level_field = [] {
+        std::stringstream ss;
+        std::string level_str = "[" + get_level_string(level) + "] ";
+        ss << std::setw(8) << std::left << level_str;
+        return ss.str();
+    }();
 
     // Date field
-    ss << "[" << t.to_string() << "] ";
+    size_t length = 0;
+    detail::append(buffer, size, length, "[", 1);
+    length += t.format(buffer + length, size - length);
+    detail::append(buffer, size, length, "] ", 2);
 
     // Level field
-    std::string level_str = "[" + get_level_string(level) + "] ";
-    ss << std::setw(8) << std::left << level_str;
+    detail::append(buffer, size, length, level_field);
 
     // Name field
     if (is_init) {
-        ss << "[" << name << "] ";
+        detail::append(buffer, size, length, "[", 1);
+        detail::append(buffer, size, length, name);
+        detail::append(buffer, size, length, "] ", 2);
+    }
+
+    return length;
+}
+
+inline Log::RecordBuffer::RecordBuffer() : text_(256, '\0') { setp(text_.data(), text_.data() + text_.size()); }
+
+inline Log::RecordBuffer::~RecordBuffer() {
+    flush_record(true);
+    if (queue_) {
+        queue_->closed.store(true, std::memory_order_release);
+    }
+}
+
+inline void Log::RecordBuffer::begin(Level level, const Time &t) {
+    // Text logged without a flush belongs to the previous call
+    flush_record();
+    record_.stamp = t.to_nanoseconds();
+    record_.level = level;
+    record_.flags = 0;
+}
+
+inline void Log::RecordBuffer::flush_record(bool flush) {
+    size_t size = pptr() - pbase();
+    if (size == 0) {
+        return;
+    }
+    // Records go through the writer until it has drained its queues, so the
+    // last record of `stop_async` is written after the queued ones
+    if (async_running.load(std::memory_order_acquire)) {
+        if (!queue_) {
+            queue_ = std::make_shared<detail::LogQueue>(queue_capacity);
+            std::lock_guard<std::mutex> guard(async_mutex);
+            queues.push_back(queue_);
+        }
+        if (!queue_->ring.push(&record_, sizeof(record_), pbase(), size)) {
+            async_dropped.fetch_add(1, std::memory_order_relaxed);
+        } else if (writer_sleeping.load(std::memory_order_relaxed)) {
+            async_cv.notify_one();
+        }
+    } else {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (!(record_.flags & detail::LogRecord::continuation)) {
+            char header[LogStream<Level::INFO>::header_size];
+            Time stamp(Time::Type(std::chrono::nanoseconds(record_.stamp)));
+            tee_buffer.sputn(header, create_header(static_cast<Level>(record_.level), header, sizeof(header), stamp));
+        }
+        tee_buffer.sputn(pbase(), size);
+        if (flush) {
+            tee_buffer.pubsync();
+        }
+    }
+    setp(text_.data(), text_.data() + text_.size());
+    record_.flags |= detail::LogRecord::continuation;
+}
+
+inline void Log::RecordBuffer::reserve(size_t extra) {
+    size_t size = pptr() - pbase();
+    if (size + extra <= text_.size()) {
+        return;
+    }
+    text_.resize(std::max(text_.size() * 2, size + extra));
+    setp(text_.data(), text_.data() + text_.size());
+    pbump(static_cast<int>(size));
+}
+
+inline int Log::RecordBuffer::overflow(int c) {
+    // Only called when the put area is full
+    if (c == EOF) {
+        return 0;
     }
+    reserve(1);
+    *pptr() = static_cast<char>(c);
+    pbump(1);
+    return c;
+}
+
+inline std::streamsize Log::RecordBuffer::xsputn(const char *s, std::streamsize n) {
+    reserve(n);
+    std::memcpy(pptr(), s, n);
+    pbump(static_cast<int>(n));
+    return n;
+}
 
-    return ss.str();
+inline int Log::RecordBuffer::sync() {
+    flush_record(true);
+    return 0;
+}
+
+inline std::ostream &Log::thread_stream() {
+    thread_local RecordBuffer buffer;
+    thread_local std::ostream stream(&buffer);
+    return stream;
+}
+
+inline size_t Log::create_header(Level level, char *buffer, size_t size, const Time &t) {
+    switch (level) {
+        case Level::DEBUG:
+            return LogStream<Level::DEBUG>::create_header(buffer, size, t);
+        case Level::INFO:
+            return LogStream<Level::INFO>::create_header(buffer, size, t);
+        case Level::WARN:
+            return LogStream<Level::WARN>::create_header(buffer, size, t);
+        case Level::ERROR:
+            return LogStream<Level::ERROR>::create_header(buffer, size, t);
+        default:
+            return LogStream<Level::FATAL>::create_header(buffer, size, t);
+    }
+}
+
+inline void Log::write_loop() {
+    struct Entry {
+        detail::LogRecord record;
+        size_t offset;
+        size_t size;
+    };
+    std::vector<std::shared_ptr<detail::LogQueue>> snapshot;
+    std::vector<Entry> entries;
+    std::string text;
+    std::string out;
+    char header[LogStream<Level::INFO>::header_size];
+
+    while (true) {
+        bool stopping = !async_running.load(std::memory_order_acquire);
+        {
+            std::lock_guard<std::mutex> guard(async_mutex);
+            snapshot = queues;
+        }
+
+        // Drain every ring, then order the batch by the time of the log calls.
+        // The sort is stable, so continuations stay after their record.
+        entries.clear();
+        text.clear();
+        for (auto &queue : snapshot) {
+            const uint8_t *data;
+            size_t size;
+            while (queue->ring.front(data, size)) {
+                Entry entry;
+                std::memcpy(&entry.record, data, sizeof(entry.record));
+                entry.offset = text.size();
+                entry.size = size - sizeof(entry.record);
+                text.append(reinterpret_cast<const char *>(data) + sizeof(entry.record), entry.size);
+                entries.push_back(entry);
+                queue->ring.pop();
+            }
+        }
+        {
+            // Queues of exited threads are removed once drained
+            std::lock_guard<std::mutex> guard(async_mutex);
+            queues.erase(std::remove_if(queues.begin(), queues.end(),
+                                        [](const std::shared_ptr<detail::LogQueue> &queue) {
+                                            return queue->closed.load(std::memory_order_acquire) &&
+                                                   queue->ring.empty();
+                                        }),
+                         queues.end());
+        }
+        snapshot.clear();
+
+        uint64_t dropped = async_dropped.exchange(0, std::memory_order_relaxed);
+        if (entries.empty() && dropped == 0) {
+            if (stopping) {
+                break;
+            }
+            // Producers only notify while the writer sleeps, and the timeout
+            // bounds the delay of a record pushed just before it fell asleep.
+            writer_sleeping.store(true);
+            std::unique_lock<std::mutex> lock(async_mutex);
+            async_cv.wait_for(lock, std::chrono::milliseconds(50));
+            writer_sleeping.store(false);
+            continue;
+        }
+
+        std::stable_sort(entries.begin(), entries.end(),
+                         [](const Entry &a, const Entry &b) { return a.record.stamp < b.record.stamp; });
+        out.clear();
+        for (const Entry &entry : entries) {
+            if (!(entry.record.flags & detail::LogRecord::continuation)) {
+                Time stamp(Time::Type(std::chrono::nanoseconds(entry.record.stamp)));
+                out.append(header, create_header(static_cast<Level>(entry.record.level), header, sizeof(header), stamp));
+            }
+            out.append(text, entry.offset, entry.size);
+        }
+        if (dropped > 0) {
+            out.append(header, create_header(Level::WARN, header, sizeof(header), Time::now()));
+            out.append(std::to_string(dropped) + " log records dropped, the log queue was full\n");
+        }
+
+        std::lock_guard<std::mutex> guard(mutex);
+        tee_buffer.sputn(out.data(), out.size());
+        tee_buffer.pubsync();
+    }
+}
+
+inline void Log::start_async(size_t capacity) {
+    if (async_running.exchange(true)) {
+        return;
+    }
+    queue_capacity = capacity;
+    writer = std::thread(write_loop);
+    static bool registered = (std::atexit(join_async), true);
+    (void)registered;
+    async_enabled.store(true, std::memory_order_release);
+}
+
+inline void Log::stop_async() {
+    if (!async_running.load()) {
+        return;
+    }
+    async_enabled.store(false, std::memory_order_release);
+
+    // Flush the calling thread's last record, the writer drains the rest
+    thread_stream().flush();
+    join_async();
+}
+
+inline void Log::join_async() {
+    // Also the exit handler: thread_local buffers may be destroyed already
+    // (their destructors queue their last record), so only the writer is
+    // touched here.
+    async_enabled.store(false, std::memory_order_release);
+    async_running.store(false, std::memory_order_release);
+    async_cv.notify_one();
+    if (writer.joinable()) {
+        writer.join();
+    }
+}
+
+inline bool Log::toggle_level_on_signal(int signum, Level level) {
+    toggle_level.store(level);
+    saved_level.store(runtime_level.load());
+
+    struct sigaction action = {};
+    action.sa_handler = on_toggle_signal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    return sigaction(signum, &action, nullptr) == 0;
+}
+
+inline void Log::on_toggle_signal(int) {
+    // Only lock-free atomics, which are safe in a signal handler
+    int current = runtime_level.load();
+    int target = toggle_level.load();
+    if (current == target) {
+        runtime_level.store(saved_level.load());
+    } else {
+        saved_level.store(current);
+        runtime_level.store(target);
+    }
 }
 
 inline void Log::init(const std::string &name, bool logToFile) {
     if (is_init) {
         return;
     }
+    FastClock::init();
     Log::name = name;
     if (logToFile) {
         const char *homeDir;
@@ -238,8 +866,12 @@ inline void Log::init(const std::string &name, bool logToFile) {
                 return;
             }
         }
-        logFile.open(dirName + name + "_" + std::to_string(Time::now().to_nanoseconds()) + ".log");
-        tee_buffer.add(logFile.rdbuf());
+        std::string path = dirName + name + "_" + std::to_string(Time::now().to_nanoseconds()) + ".log";
+        log_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (log_fd >= 0) {
+            std::lock_guard<std::mutex> guard(mutex);
+            tee_buffer.add(log_fd);
+        }
     }
     is_init = true;
 }
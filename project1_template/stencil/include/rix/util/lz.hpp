@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rix {
+namespace util {
+
+/**
+ * @brief A fast LZ77 block codec, in the LZ4 block format.
+ *
+ * @details Blocks are compressed greedily with a small hash table of recent
+ * positions, which runs at several hundred MB/s and suits data with repeated
+ * byte sequences (record headers, slowly changing values). Decompression only
+ * copies literals and earlier output, and checks every length and offset
+ * against the buffers, so corrupted input fails instead of overrunning.
+ *
+ * A block does not record its uncompressed size; the caller stores it.
+ */
+namespace lz {
+
+/**
+ * @brief Returns the largest compressed size of `size` bytes. Incompressible
+ * data grows by about 0.4%.
+ */
+size_t compress_bound(size_t size);
+
+/**
+ * @brief Compresses a block.
+ * @param src The data to compress.
+ * @param size The size of the data.
+ * @param dst The output, at least `compress_bound(size)` bytes.
+ * @return The compressed size.
+ */
+size_t compress(const uint8_t *src, size_t size, uint8_t *dst);
+
+/**
+ * @brief Decompresses a block.
+ * @param src The compressed block.
+ * @param size The size of the compressed block.
+ * @param dst The output, `raw_size` bytes.
+ * @param raw_size The uncompressed size of the block.
+ * @return false if the block is corrupted or does not decompress to exactly
+ * `raw_size` bytes.
+ */
+bool decompress(const uint8_t *src, size_t size, uint8_t *dst, size_t raw_size);
+
+}  // namespace lz
+}  // namespace util
+}  // namespace rix
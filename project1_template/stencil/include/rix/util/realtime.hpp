@@ -0,0 +1,31 @@
+#pragma once
+
+namespace rix {
+namespace util {
+
+/**
+ * @brief Switches the calling thread to the `SCHED_FIFO` real-time scheduling
+ * policy, so it preempts all normal threads as soon as it becomes runnable.
+ * Requires `CAP_SYS_NICE` or a suitable `RLIMIT_RTPRIO`.
+ * @param priority The real-time priority, from 1 (lowest) to 99 (highest).
+ * @return true if the policy was set, false otherwise (errno is set).
+ */
+bool set_realtime_priority(int priority);
+
+/**
+ * @brief Restricts the calling thread to a single CPU, which avoids migrations
+ * and keeps its caches warm. Threads created afterwards inherit the affinity.
+ * @param cpu The index of the CPU.
+ * @return true if the affinity was set, false otherwise (errno is set).
+ */
+bool pin_to_cpu(int cpu);
+
+/**
+ * @brief Locks all current and future pages of the process in memory, so the
+ * process never stalls on a page fault.
+ * @return true if the memory was locked, false otherwise (errno is set).
+ */
+bool lock_memory();
+
+}  // namespace util
+}  // namespace rix
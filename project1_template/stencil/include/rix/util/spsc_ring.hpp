@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rix {
+namespace util {
+
+/**
+ * @brief A lock-free single-producer single-consumer ring buffer of variable
+ * size records.
+ *
+ * @details Records are copied into a contiguous byte buffer, each preceded by
+ * an 8-byte header, and padded to 8 bytes. A record never wraps: if it does
+ * not fit before the end of the buffer, the remainder is skipped and the record
+ * starts at the beginning. The producer and consumer each own one index and
+ * only read the other with acquire semantics, so `push` and `front`/`pop`
+ * never block and never make a system call. Each side caches the other's
+ * index to avoid touching its cache line on every call.
+ *
+ * Exactly one thread may push and exactly one thread may read.
+ */
+class SpscRing {
+   public:
+    /**
+     * @brief Constructs an empty ring.
+     * @param capacity The size of the buffer in bytes, rounded up to a power of
+     * two of at least 64.
+     */
+    explicit SpscRing(size_t capacity);
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    /**
+     * @brief Copies a record into the ring.
+     * @param data The record.
+     * @param size The size of the record in bytes.
+     * @return true if the record was pushed, false if the ring is full or the
+     * record is larger than `max_record_size`.
+     */
+    bool push(const void *data, size_t size);
+
+    /**
+     * @brief Copies a record made of two parts (typically a header and a
+     * payload) into the ring.
+     * @return true if the record was pushed, false otherwise.
+     */
+    bool push(const void *first, size_t first_size, const void *second, size_t second_size);
+
+    /**
+     * @brief Gets the oldest record without removing it.
+     * @param data Set to the record. Valid until `pop` is called.
+     * @param size Set to the size of the record.
+     * @return true if a record is available, false if the ring is empty.
+     */
+    bool front(const uint8_t *&data, size_t &size);
+
+    /**
+     * @brief Removes the record returned by the last call to `front`.
+     */
+    void pop();
+
+    bool empty() const;
+    size_t capacity() const;
+    size_t max_record_size() const;
+
+   private:
+    static constexpr uint32_t padding = 1;
+    static constexpr size_t header_size = 8;
+
+    static size_t align(size_t size) { return (size + 7) & ~size_t(7); }
+
+    std::vector<uint8_t> buffer_;
+    size_t mask_;
+
+    alignas(64) std::atomic<uint64_t> head_;  //< Written by the producer.
+    uint64_t cached_tail_;                    //< Producer's copy of `tail_`.
+
+    alignas(64) std::atomic<uint64_t> tail_;  //< Written by the consumer.
+    uint64_t cached_head_;                    //< Consumer's copy of `head_`.
+    size_t front_size_;                       //< Size of the record at `tail_`.
+};
+
+}  // namespace util
+}  // namespace rix
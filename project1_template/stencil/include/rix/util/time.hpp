@@ -6,12 +6,25 @@
 
 #include "rix/msg/standard/Duration.hpp"
 #include "rix/msg/standard/Time.hpp"
+#include "rix/util/histogram.hpp"
 
 namespace rix {
 namespace util {
 
+/**
+ * @brief The wall clock. `Time` is based on this clock and should only be
+ * used for timestamps that are shared with other processes or machines (for
+ * example message stamps), since it jumps when the system time is adjusted.
+ */
 using Clock = std::chrono::system_clock;
 
+/**
+ * @brief The monotonic clock (`CLOCK_MONOTONIC` on Linux). `SteadyTime` is
+ * based on this clock and should be used for deadlines, rates and measuring
+ * elapsed time.
+ */
+using SteadyClock = std::chrono::steady_clock;
+
 class Duration;  // Forward declaration
 
 class Time {
@@ -44,6 +57,20 @@ class Time {
     bool operator>=(const Time &other) const;
 
     std::string to_string(bool local_time = false) const;
+
+    /**
+     * @brief Formats the time as `MM/DD/YY HH:MM:SS.uuuuuu ZONE` into a caller
+     * supplied buffer, without allocating. The date and time of day are cached
+     * per thread and only recomputed when the second changes, so formatting
+     * consecutive times is mostly a copy.
+     * @param buffer The buffer to write to. The output is null-terminated.
+     * @param size The size of the buffer, `format_size` is always enough.
+     * @param local_time Format in the local time zone instead of GMT.
+     * @return size_t The length of the output, or 0 if the buffer is too small.
+     */
+    size_t format(char *buffer, size_t size, bool local_time = false) const;
+    static constexpr size_t format_size = 64;
+
     rix::msg::standard::Time to_msg();
 
     enum RoundType { FLOOR = 0, CEIL, NEAREST };
@@ -119,6 +146,48 @@ class Duration {
     Type d;
 };
 
+/**
+ * @brief A point in time on the monotonic clock. Unlike `Time`, a SteadyTime
+ * never jumps when the wall clock is stepped (by NTP or the MBot timesync, for
+ * example), so it is used for deadlines and for measuring elapsed time. The
+ * epoch of the monotonic clock is unspecified (typically system boot), so a
+ * SteadyTime is only meaningful within the same machine and boot.
+ */
+class SteadyTime {
+   public:
+    using Type = std::chrono::time_point<SteadyClock, std::chrono::nanoseconds>;
+    static SteadyTime now();
+    static SteadyTime max() { return SteadyTime(Type::max()); }
+    static SteadyTime min() { return SteadyTime(Type::min()); }
+
+    SteadyTime();
+    SteadyTime(const Type &time_point);
+
+    SteadyTime(const SteadyTime &other);
+    SteadyTime &operator=(const SteadyTime &other);
+
+    SteadyTime operator+(const Duration &other) const;
+    SteadyTime operator-(const Duration &other) const;
+    Duration operator-(const SteadyTime &other) const;
+
+    SteadyTime &operator+=(const Duration &other);
+    SteadyTime &operator-=(const Duration &other);
+    bool operator==(const SteadyTime &other) const;
+    bool operator!=(const SteadyTime &other) const;
+    bool operator<(const SteadyTime &other) const;
+    bool operator<=(const SteadyTime &other) const;
+    bool operator>(const SteadyTime &other) const;
+    bool operator>=(const SteadyTime &other) const;
+
+    int64_t to_nanoseconds() const;
+
+    const Type &get() const;
+    Type &get();
+
+   private:
+    Type tp;
+};
+
 /**
  * @brief Sleep for a given duration
  * @param duration The duration to sleep for.
@@ -132,7 +201,16 @@ void sleep_for(const Duration &duration);
 void sleep_until(const Time &time);
 
 /**
- * @brief A class for measuring time.
+ * @brief Sleep until a given time on the monotonic clock. The deadline is
+ * absolute, so time spent before the call or a late wakeup from an
+ * interruption does not delay it.
+ * @param time The time to sleep until.
+ */
+void sleep_until(const SteadyTime &time);
+
+/**
+ * @brief A class for measuring time. Elapsed time is measured on the monotonic
+ * clock.
  */
 class Timer {
    public:
@@ -161,12 +239,26 @@ class Timer {
     Duration get() const;
 
    private:
-    Time start_;  //< The start time.
-    Time end_;    //< The end time.
+    SteadyTime start_;  //< The start time.
+    SteadyTime end_;    //< The end time.
 };
 
 /**
- * @brief A class for setting the rate of a loop.
+ * @brief A class for setting the rate of a loop. Deadlines are kept on the
+ * monotonic clock, so the rate is unaffected by changes to the wall clock.
+ * Each deadline is one period after the previous one (not after the previous
+ * wakeup), so wakeup latency does not accumulate into drift.
+ *
+ * By default `sleep` blocks in the kernel until the deadline, which wakes up
+ * tens of microseconds late (milliseconds under load). With a spin margin, it
+ * sleeps until the margin before the deadline and busy-waits the rest, which
+ * trades CPU time for wakeups within a microsecond of the deadline. For tight
+ * loops, combine it with `set_realtime_priority` and `pin_to_cpu` from
+ * rix/util/realtime.hpp.
+ *
+ * When `sleep` is called after its deadline (an overrun), the next deadline
+ * depends on the overrun policy, and `stats` records how the loop is keeping
+ * up.
  *
  * @example shared_mutex.cpp
  * @example tcp_client.cpp
@@ -177,11 +269,32 @@ class Timer {
  */
 class Rate {
    public:
+    /**
+     * @brief What to do when `sleep` is called after its deadline.
+     * SKIP: drop the missed periods and keep the original phase, so the next
+     * deadline is the next one on the original grid.
+     * CATCH_UP: keep every deadline, so `sleep` returns immediately until the
+     * loop is back on schedule. Use when every cycle must run.
+     * REALIGN: start a new period now, shifting the phase of the loop.
+     */
+    enum OverrunPolicy { SKIP = 0, CATCH_UP, REALIGN };
+
+    struct Stats {
+        uint64_t cycles = 0;       //< Number of calls to `sleep`.
+        uint64_t overruns = 0;     //< Calls made after the deadline had passed.
+        uint64_t missed = 0;       //< Periods dropped by the SKIP policy.
+        Duration max_lateness;     //< Largest lateness of a cycle.
+        Histogram jitter;          //< Lateness of every cycle, in nanoseconds.
+    };
+
     static inline double min_frequency() { return (1e9 / std::chrono::nanoseconds::max().count()); }
     static inline double max_frequency() { return 1e9; }
     static inline Duration min_period() { return Duration(0, 1); }
     static inline Duration max_period() { return Duration(std::chrono::nanoseconds::max()); }
 
+    /**
+     * @brief Constructs a Rate object with the shortest period, `min_period`.
+     */
     Rate();
     /**
      * @brief Constructs a Rate object.
@@ -199,14 +312,57 @@ class Rate {
      */
     bool sleep();
 
+    /**
+     * @brief Starts a new period now, discarding the current deadline.
+     */
+    void reset();
+
     Duration period() const;
+
+    /**
+     * @brief Sets the period, clamped to `min_period` like the constructor.
+     */
     void set_period(const Duration &period);
     double frequency() const;
     void set_frequency(double frequency);
 
+    /**
+     * @brief Sets how long before each deadline `sleep` stops sleeping and
+     * starts spinning. Zero (the default) disables spinning.
+     * @param margin The spin margin. Should cover the wakeup latency of the
+     * system, typically 50-200 us.
+     */
+    void set_spin_margin(const Duration &margin);
+    Duration spin_margin() const;
+
+    /**
+     * @brief Sets the overrun policy. The default is REALIGN.
+     */
+    void set_overrun_policy(OverrunPolicy policy);
+    OverrunPolicy overrun_policy() const;
+
+    /**
+     * @brief Gets the statistics of all cycles since construction or the last
+     * call to `reset_stats`.
+     */
+    const Stats &stats() const;
+    void reset_stats();
+
+    /**
+     * @brief Gets how late the last call to `sleep` returned relative to its
+     * deadline. Zero means the deadline was met exactly.
+     */
+    Duration lateness() const;
+
    private:
+    void record(const Duration &lateness);
+
     Duration period_;
-    Time start_;
+    SteadyTime start_;
+    Duration spin_margin_;
+    OverrunPolicy policy_;
+    Stats stats_;
+    Duration lateness_;
 };
 
 }  // namespace util
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "rix/util/time.hpp"
+
+namespace rix {
+namespace util {
+
+/**
+ * @brief A hierarchical timing wheel for scheduling many deadlines.
+ *
+ * @details Time is divided into ticks of a fixed resolution. The wheel has four
+ * levels of 256 slots: level 0 holds timers due within the next 256 ticks, one
+ * slot per tick, and each higher level covers 256 times the span of the level
+ * below. Timers in a higher level are moved down (cascaded) when the wheel
+ * reaches their slot, so each timer is touched at most once per level.
+ * Scheduling and cancelling a timer are O(1), and `advance` expires every due
+ * timer in one pass. Deadlines are rounded up to the next tick, so a timer
+ * never fires early and fires at most one tick late.
+ *
+ * The wheel does not wait by itself. A loop arms a single timer (for example a
+ * `rix::ipc::TimerFd` with `set_at`) to `next_deadline`, waits on it alongside
+ * its other file descriptors, and calls `advance` when it wakes up. Timer
+ * callbacks run inside `advance` and may schedule or cancel timers.
+ *
+ * Not thread-safe.
+ */
+class TimerWheel {
+   public:
+    using Id = uint64_t;
+    using Callback = std::function<void()>;
+
+    /**
+     * @brief The identifier of no timer. Never returned by `schedule`.
+     */
+    static constexpr Id invalid_id = 0;
+
+    /**
+     * @brief Constructs an empty wheel.
+     * @param resolution The length of a tick. Must be positive.
+     * @param start The time of tick zero.
+     */
+    explicit TimerWheel(const Duration &resolution = Duration(0.001), const SteadyTime &start = SteadyTime::now());
+
+    /**
+     * @brief Schedules a callback. Deadlines that have already passed expire
+     * at the next tick.
+     * @param deadline When the callback should run.
+     * @param callback The callback.
+     * @return Id The identifier of the timer.
+     */
+    Id schedule(const SteadyTime &deadline, Callback callback);
+
+    /**
+     * @brief Moves a pending timer to a new deadline, keeping its callback.
+     * @param id The identifier of the timer.
+     * @param deadline The new deadline.
+     * @return true if the timer was pending, false otherwise.
+     */
+    bool reschedule(Id id, const SteadyTime &deadline);
+
+    /**
+     * @brief Cancels a pending timer.
+     * @param id The identifier of the timer.
+     * @return true if the timer was pending, false if it already expired or was
+     * cancelled.
+     */
+    bool cancel(Id id);
+
+    /**
+     * @brief Returns true if the timer is scheduled and has not expired yet.
+     */
+    bool pending(Id id) const;
+
+    /**
+     * @brief Runs the callbacks of all timers whose deadline is at or before
+     * `now`.
+     * @param now The current time.
+     * @return size_t The number of callbacks that ran.
+     */
+    size_t advance(const SteadyTime &now);
+
+    /**
+     * @brief Gets the time at which `advance` next has work to do: either the
+     * expiry of the earliest timer, or the time at which timers in a higher
+     * level must be cascaded.
+     * @return SteadyTime The next deadline, or `SteadyTime::max()` if no timer
+     * is pending.
+     */
+    SteadyTime next_deadline() const;
+
+    /**
+     * @brief Gets the number of pending timers.
+     */
+    size_t size() const;
+
+    Duration resolution() const;
+
+   private:
+    static constexpr int levels = 4;
+    static constexpr int slot_bits = 8;
+    static constexpr uint32_t slots = 1u << slot_bits;
+    static constexpr uint32_t npos = ~0u;
+    static constexpr uint32_t expired_list = levels * slots;
+
+    struct Node {
+        uint32_t prev;
+        uint32_t next;
+        uint32_t list;
+        uint32_t generation;
+        uint64_t tick;
+        Callback callback;
+    };
+
+    uint64_t next_tick() const;
+    uint64_t tick_of(const SteadyTime &time) const;
+    SteadyTime time_of(uint64_t tick) const;
+    Node *find(Id id);
+    const Node *find(Id id) const;
+    void place(uint32_t index);
+    void link(uint32_t index, uint32_t list);
+    void unlink(uint32_t index);
+    void release(uint32_t index);
+    void cascade(int level);
+    int next_slot(int level, uint32_t from) const;
+
+    int64_t resolution_ns_;
+    SteadyTime start_;
+    uint64_t current_;  //< The last tick that was processed.
+    size_t size_;
+    std::vector<Node> nodes_;
+    uint32_t free_;
+    std::vector<uint32_t> heads_;
+    std::array<std::array<uint64_t, slots / 64>, levels> occupied_;
+};
+
+}  // namespace util
+}  // namespace rix
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "rix/util/histogram.hpp"
+#include "rix/util/time.hpp"
+
+namespace rix {
+namespace util {
+
+/**
+ * @brief Latency tracing for a message pipeline.
+ *
+ * @details A Trace owns one latency histogram per named stage. Each stage
+ * records the time elapsed from a common origin (for drive commands, the
+ * stamp set when the key was read) to the moment the message passed that
+ * stage. Because the origin is a wall clock stamp carried in the message,
+ * stages recorded in different processes on the same host line up, and the
+ * last stage gives the end-to-end latency.
+ *
+ * Recording is allocation-free; `report` formats percentiles for every stage.
+ */
+class Trace {
+   public:
+    /**
+     * @brief Constructs an empty Trace.
+     * @param name The name printed in the report header.
+     */
+    explicit Trace(const std::string &name);
+
+    /**
+     * @brief Adds a stage to the trace. Stages are reported in the order they
+     * were added.
+     * @param name The name of the stage.
+     * @return size_t The identifier to pass to `record`.
+     */
+    size_t add_stage(const std::string &name);
+
+    /**
+     * @brief Records the latency of a message at a stage.
+     * @param stage The stage identifier returned by `add_stage`.
+     * @param latency The time elapsed since the origin of the message.
+     */
+    void record(size_t stage, const Duration &latency);
+
+    /**
+     * @brief Records the latency of a message at a stage as the time elapsed
+     * from `origin` to now.
+     * @param stage The stage identifier returned by `add_stage`.
+     * @param origin The origin of the message.
+     */
+    void record(size_t stage, const Time &origin);
+
+    /**
+     * @brief Writes a table with the count and latency percentiles (in
+     * microseconds) of every stage.
+     * @param os The stream to write to.
+     */
+    void report(std::ostream &os) const;
+
+    /**
+     * @brief Removes all recorded latencies.
+     */
+    void reset();
+
+    const Histogram &stage(size_t stage) const;
+
+   private:
+    std::string name_;
+    std::vector<std::string> stage_names_;
+    std::vector<Histogram> stages_;
+};
+
+}  // namespace util
+}  // namespace rix
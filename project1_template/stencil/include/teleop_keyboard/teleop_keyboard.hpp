@@ -1,14 +1,21 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include "rix/ipc/fifo.hpp"
 #include "rix/ipc/file.hpp"
+#include "rix/ipc/poller.hpp"
 #include "rix/ipc/signal.hpp"
 #include "rix/msg/geometry/Twist2DStamped.hpp"
 #include "rix/msg/standard/UInt32.hpp"
 #include "rix/util/argument_parser.hpp"
 #include "rix/util/time.hpp"
+#include "rix/util/trace.hpp"
 
 using namespace rix::ipc;
 using namespace rix::msg;
@@ -20,11 +27,143 @@ class TeleopKeyboard {
                    std::unique_ptr<rix::ipc::interfaces::IO> output, double linear_speed,
                    double angular_speed);
 
+    /**
+     * @brief Reads keys from the input and writes the corresponding commands
+     * to the output until `notif` is raised. When the input and `notif` expose
+     * file descriptors, the loop sleeps in a single wait on both and reacts
+     * to keys as soon as they arrive; otherwise it checks `notif` and the
+     * input every 100 ms.
+     *
+     * @param notif Notification that stops the loop (typically SIGINT).
+     */
     void spin(std::unique_ptr<rix::ipc::interfaces::Notification> notif);
 
+    /**
+     * @brief Sets how a batch of keys read at once is sent. When coalescing
+     * (the default), only the command of the last valid key is sent. Otherwise
+     * one frame is sent per valid key. Either way, the batch is written with a
+     * single write.
+     *
+     * @param coalesce Whether to send only the last command of a batch.
+     */
+    void set_coalesce(bool coalesce);
+    bool coalesce() const;
+
+    /**
+     * @brief Sets whether each frame is preceded by its size (a 4-byte
+     * UInt32), which is the default. Disable the prefix when the output
+     * preserves message boundaries (a `SEQPACKET` UnixSocket); each frame is
+     * then written on its own.
+     *
+     * @param size_prefixed true if frames are size-prefixed
+     */
+    void set_size_prefixed(bool size_prefixed);
+    bool size_prefixed() const;
+
+    /**
+     * @brief Enables streaming. Instead of sending a command per key, `spin`
+     * starts a thread that sends the current command at a fixed rate, on
+     * absolute deadlines, and keys only change the target command. The
+     * stream gives the driver a heartbeat while the operator holds still.
+     *
+     * The stream repeats the last target forever, so to the driver the MBot
+     * is always being commanded: its command timeout never stops the MBot
+     * while the teleop runs, only when the teleop dies or hangs. Press the
+     * stop key to stop.
+     *
+     * @param rate The rate of the stream (Hz), 0 to send on keys only (the
+     * default).
+     */
+    void set_stream_rate(double rate);
+    double stream_rate() const;
+
+    /**
+     * @brief Sets the acceleration limits of the stream. The streamed command
+     * moves towards the target command by at most these amounts per second.
+     * Ignored when not streaming.
+     *
+     * @param linear The linear acceleration (m/s^2), 0 to jump to the target.
+     * @param angular The angular acceleration (rad/s^2), 0 to jump to the
+     * target.
+     */
+    void set_acceleration(double linear, double angular);
+    double linear_acceleration() const;
+    double angular_acceleration() const;
+
+    /**
+     * @brief Enables latency tracing. The latency from reading a key to
+     * serializing and writing the corresponding command is recorded. The
+     * report is written to stderr when `dump` is raised (typically SIGUSR1)
+     * and when `spin` returns. Streamed frames are not tied to a key and are
+     * not traced.
+     *
+     * @param dump Notification that requests a report, may be null.
+     */
+    void enable_trace(std::unique_ptr<rix::ipc::interfaces::Notification> dump);
+
+    /**
+     * @brief Returns the latency trace, or null if tracing is disabled.
+     *
+     */
+    const rix::util::Trace *trace() const;
+
    private:
+    /**
+     * @brief Maps a key to a command.
+     * @return true if the key is a command key, false if it is ignored.
+     */
+    bool map_key(char key, geometry::Twist2D &twist) const;
+
+    /**
+     * @brief Serializes the Twist2DStamped frame (size-prefixed unless
+     * disabled) of every command key, and the frame of the stream, once. Sending a command then
+     * only patches the fields that change before the write.
+     */
+    void build_templates();
+
+    /**
+     * @brief Writes the next sequence number and `stamp` into a frame.
+     */
+    void stamp_frame(uint8_t *frame, const rix::msg::standard::Time &stamp);
+
+    /**
+     * @brief Writes the velocities of `twist` into a frame.
+     */
+    void set_frame_twist(uint8_t *frame, const geometry::Twist2D &twist) const;
+
+    /**
+     * @brief Sends the ramped command at the stream rate until `streaming` is
+     * cleared. Runs on the publisher thread.
+     */
+    void stream();
+
     std::unique_ptr<rix::ipc::interfaces::IO> input;
     std::unique_ptr<rix::ipc::interfaces::IO> output;
     double linear_speed;
     double angular_speed;
+    bool coalesce_;
+    bool size_prefixed_;
+    double stream_rate_;
+    double linear_acceleration_;
+    double angular_acceleration_;
+
+    // Pre-serialized frames, indexed by key. Empty for keys that are not
+    // commands.
+    std::array<std::vector<uint8_t>, 256> key_frames;
+    std::vector<uint8_t> stream_frame;
+    size_t seq_offset;
+    size_t stamp_offset;
+    size_t twist_offset;
+    uint32_t seq;
+
+    // Target command of the stream, set by key events
+    std::mutex target_mutex;
+    geometry::Twist2D target;
+    std::atomic<bool> streaming;
+    std::thread publisher;
+
+    std::unique_ptr<rix::util::Trace> trace_;
+    std::unique_ptr<rix::ipc::interfaces::Notification> trace_dump;
+    size_t trace_serialize;
+    size_t trace_write;
 };
\ No newline at end of file
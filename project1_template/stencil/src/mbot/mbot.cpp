@@ -1,6 +1,28 @@
 #include "mbot/mbot.hpp"
 
-MBot::MBot() : file("/dev/mbot_lcm", O_RDWR | O_NOCTTY | O_NDELAY, 0) {
+#include <poll.h>
+
+#include <cstdio>
+
+namespace {
+
+int64_t realtime_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+}  // namespace
+
+MBot::MBot(double timesync_rate)
+    : file("/dev/mbot_lcm", O_RDWR | O_NOCTTY | O_NDELAY, 0),
+      stop_pipe(rix::ipc::Pipe::create()),
+      timesync_period(timesync_rate > 0.0 ? 1.0 / timesync_rate : 0.5),
+      last_sync_utime(0),
+      last_sync_mono_ns(0),
+      clock_synced(false),
+      offset_us(0),
+      round_trip_ns(0) {
     if (!file.ok()) {
         perror("open");
         return;
@@ -24,12 +46,16 @@ MBot::MBot() : file("/dev/mbot_lcm", O_RDWR | O_NOCTTY | O_NDELAY, 0) {
         return;
     }
 
+    if (!timesync_timer.ok() || !stop_pipe[0].ok()) {
+        return;
+    }
     timesync_thr = std::thread(std::bind(&MBot::timesync, this));
 }
 
 MBot::~MBot() {
-    // Set the stop flag for the time synchronization thread
-    stop_timesync_flag = 1;
+    // Wake the time synchronization thread so it exits immediately
+    uint8_t val = 1;
+    stop_pipe[1].write(&val, 1);
 
     // Join the time synchronization thread
     if (timesync_thr.joinable()) {
@@ -39,6 +65,16 @@ MBot::~MBot() {
 
 bool MBot::ok() const { return file.ok(); }
 
+bool MBot::is_clock_synced() const { return clock_synced; }
+
+rix::util::Duration MBot::clock_offset() const {
+    return rix::util::Duration(std::chrono::microseconds(offset_us.load()));
+}
+
+rix::util::Duration MBot::clock_round_trip() const {
+    return rix::util::Duration(std::chrono::nanoseconds(round_trip_ns.load()));
+}
+
 void MBot::drive(const Twist2DStamped &cmd) const {
     serial_twist2D_t mbot_cmd;
     mbot_cmd.utime = rix::util::Time(cmd.header.stamp).to_microseconds();
@@ -58,32 +94,133 @@ void MBot::drive(const Twist2DStamped &cmd) const {
 }
 
 void MBot::timesync() {
-    int status;
+    // The timer is re-armed by the kernel relative to its previous expiration,
+    // so the period does not drift by the time spent encoding and writing.
+    if (!timesync_timer.set(rix::util::Duration(0.0), timesync_period)) {
+        perror("timerfd_settime");
+        return;
+    }
+
+    struct pollfd fds[3];
+    fds[0] = {timesync_timer.fd(), POLLIN, 0};
+    fds[1] = {stop_pipe[0].fd(), POLLIN, 0};
+    fds[2] = {file.fd(), POLLIN, 0};
 
     // Time synchronization loop
-    while (!stop_timesync_flag) {
-        // Encode the timesync message
-        serial_timestamp_t msg = {0};
-        struct timespec ts;
-        clock_gettime(CLOCK_REALTIME, &ts);
-        msg.utime = ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
-        const size_t msg_size = sizeof(serial_timestamp_t) + ROS_PKG_LENGTH;
-        uint8_t rospkt[msg_size];
-        if (encode_msg((uint8_t *)&msg, sizeof(serial_timestamp_t), MBOT_TIMESYNC, rospkt, msg_size) < 0) {
-            perror("encode_msg");
+    while (true) {
+        if (poll(fds, 3, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("poll");
             break;
         }
 
-        // Send the timesync message
-        mtx.lock();
-        status = file.write(rospkt, msg_size);
-        mtx.unlock();
-        if (status < 0) {
-            perror("write");
+        // Stop requested by the destructor
+        if (fds[1].revents) {
+            break;
+        }
+
+        // Replies from the board
+        if (fds[2].revents & POLLIN) {
+            read_serial();
+        }
+
+        // The device is gone: poll would report it again immediately, and
+        // timesync messages could not be written anyway
+        if (fds[2].revents & (POLLHUP | POLLERR | POLLNVAL)) {
+            fprintf(stderr, "MBot serial device closed or failed, stopping time synchronization\n");
+            break;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            timesync_timer.consume();
+            send_timesync();
+        }
+    }
+    timesync_timer.disarm();
+}
+
+void MBot::send_timesync() {
+    // Encode the timesync message
+    serial_timestamp_t msg = {0};
+    msg.utime = realtime_us();
+    const size_t msg_size = sizeof(serial_timestamp_t) + ROS_PKG_LENGTH;
+    uint8_t rospkt[msg_size];
+    if (encode_msg((uint8_t *)&msg, sizeof(serial_timestamp_t), MBOT_TIMESYNC, rospkt, msg_size) < 0) {
+        perror("encode_msg");
+        return;
+    }
+
+    // Send the timesync message
+    mtx.lock();
+    int64_t sent_ns = rix::util::SteadyTime::now().to_nanoseconds();
+    int status = file.write(rospkt, msg_size);
+    mtx.unlock();
+    if (status < 0) {
+        perror("write");
+        return;
+    }
+    last_sync_utime = msg.utime;
+    last_sync_mono_ns = sent_ns;
+}
+
+void MBot::read_serial() {
+    uint8_t chunk[256];
+    ssize_t n = file.read(chunk, sizeof(chunk));
+    if (n <= 0) {
+        return;
+    }
+    rx_buffer.insert(rx_buffer.end(), chunk, chunk + n);
+
+    // Extract every complete ROS packet from the receive buffer
+    size_t start = 0;
+    while (rx_buffer.size() - start >= ROS_PKG_LENGTH) {
+        uint8_t *pkt = rx_buffer.data() + start;
+        if (pkt[0] != SYNC_FLAG || pkt[1] != VERSION_FLAG) {
+            start++;
+            continue;
+        }
+        uint8_t len_addends[2] = {pkt[2], pkt[3]};
+        if (checksum(len_addends, 2) != pkt[4]) {
+            start++;
+            continue;
+        }
+        size_t msg_len = pkt[2] | (pkt[3] << 8);
+        if (rx_buffer.size() - start < msg_len + ROS_PKG_LENGTH) {
             break;
         }
 
-        // Run at 2 Hz
-        usleep(500000);
+        // The trailing checksum covers the topic and the message payload
+        int sum = pkt[5] + pkt[6];
+        for (size_t i = 0; i < msg_len; i++) {
+            sum += pkt[ROS_HEADER_LENGTH + i];
+        }
+        if (255 - (sum % 256) != pkt[ROS_HEADER_LENGTH + msg_len]) {
+            start++;
+            continue;
+        }
+
+        handle_packet(pkt[5] | (pkt[6] << 8), pkt + ROS_HEADER_LENGTH, msg_len);
+        start += msg_len + ROS_PKG_LENGTH;
     }
-}
\ No newline at end of file
+    rx_buffer.erase(rx_buffer.begin(), rx_buffer.begin() + start);
+}
+
+void MBot::handle_packet(uint16_t topic, const uint8_t *data, size_t len) {
+    if (topic != MBOT_TIMESYNC || len != sizeof(serial_timestamp_t) || last_sync_mono_ns == 0) {
+        return;
+    }
+
+    // The board answers a timesync with its own clock. Assuming a symmetric
+    // link, the board sampled its clock halfway through the round trip.
+    serial_timestamp_t reply;
+    timestamp_t_deserialize(data, &reply);
+    int64_t rtt_ns = rix::util::SteadyTime::now().to_nanoseconds() - last_sync_mono_ns;
+    int64_t midpoint_us = last_sync_utime + rtt_ns / 2000;
+
+    round_trip_ns = rtt_ns;
+    offset_us = reply.utime - midpoint_us;
+    clock_synced = true;
+    last_sync_mono_ns = 0;
+}
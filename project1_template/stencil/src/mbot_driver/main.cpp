@@ -1,3 +1,5 @@
+#include <cerrno>
+#include <cstring>
 #include <iostream>
 
 #include "mbot/mbot.hpp"
@@ -7,21 +9,181 @@
 #include "rix/ipc/interfaces/io.hpp"
 #include "rix/ipc/interfaces/notification.hpp"
 #include "rix/ipc/signal.hpp"
+#include "rix/ipc/topic.hpp"
+#include "rix/ipc/unix_socket.hpp"
 #include "rix/msg/geometry/Twist2DStamped.hpp"
 #include "rix/msg/standard/UInt32.hpp"
+#include "rix/util/argument_parser.hpp"
+#include "rix/util/binary_log.hpp"
+#include "rix/util/log.hpp"
+#include "rix/util/realtime.hpp"
 
 using namespace rix::ipc;
 using namespace rix::msg;
+using namespace rix::util;
 
-int main() {
-    auto mbot = std::make_unique<MBot>();
+int main(int argc, char **argv) {
+    ArgumentParser parser("mbot_driver", "Forwards drive commands read from stdin to the MBot.");
+    parser.add<double>("timesync_rate", "Rate at which the MBot clock is synchronized (Hz)", 't', 2.0);
+    parser.add<double>("max_rate", "Maximum rate at which commands are sent to the MBot (Hz), 0 for unlimited", 'r',
+                       MBotDriver::default_max_rate);
+    parser.add<double>("timeout",
+                       "Stop the MBot if no command arrives within this many seconds (hold the key to keep driving), "
+                       "0 to disable",
+                       'w', 1.0);
+    parser.add<double>("report_period", "Period of the command summary log (s), 0 to disable", 'p', 1.0);
+    parser.add<bool>("trace", "Trace command latency, reported to stderr on SIGUSR1 and at exit", 'T', false);
+    parser.add<int>("priority", "SCHED_FIFO priority of the driver (1-99), 0 for the default scheduler", 'P', 0);
+    parser.add<int>("cpu", "CPU to pin the driver to, -1 for any", 'c', -1);
+    parser.add<std::string>("binary_log", "Record every command sent to a binary log at this path (see rix_log_decode)",
+                            'B', "");
+    parser.add<std::string>("socket", "Accept commands on a SEQPACKET socket at this path instead of stdin", 's', "");
+    parser.add<std::string>("topic", "Subscribe to commands published on this topic instead of reading stdin", 'n', "");
+    parser.add<int>("log_level", "Lowest level logged (0 debug - 4 fatal), SIGUSR2 toggles debug", 'L', Log::INFO);
+
+    if (!parser.parse(argc, argv)) {
+        std::cerr << parser.help() << std::endl;
+        return 1;
+    }
+
+    double timesync_rate;
+    if (!parser.get<double>("timesync_rate", timesync_rate)) {
+        std::cerr << "Failed to get timesync_rate argument." << std::endl;
+        return 1;
+    }
+
+    double max_rate;
+    if (!parser.get<double>("max_rate", max_rate)) {
+        std::cerr << "Failed to get max_rate argument." << std::endl;
+        return 1;
+    }
+
+    double timeout;
+    if (!parser.get<double>("timeout", timeout)) {
+        std::cerr << "Failed to get timeout argument." << std::endl;
+        return 1;
+    }
+
+    double report_period;
+    if (!parser.get<double>("report_period", report_period)) {
+        std::cerr << "Failed to get report_period argument." << std::endl;
+        return 1;
+    }
+
+    bool trace;
+    if (!parser.get<bool>("trace", trace)) {
+        std::cerr << "Failed to get trace argument." << std::endl;
+        return 1;
+    }
+
+    int priority;
+    if (!parser.get<int>("priority", priority)) {
+        std::cerr << "Failed to get priority argument." << std::endl;
+        return 1;
+    }
+
+    int cpu;
+    if (!parser.get<int>("cpu", cpu)) {
+        std::cerr << "Failed to get cpu argument." << std::endl;
+        return 1;
+    }
+
+    std::string binary_log;
+    if (!parser.get<std::string>("binary_log", binary_log)) {
+        std::cerr << "Failed to get binary_log argument." << std::endl;
+        return 1;
+    }
+
+    std::string socket;
+    if (!parser.get<std::string>("socket", socket)) {
+        std::cerr << "Failed to get socket argument." << std::endl;
+        return 1;
+    }
+
+    std::string topic;
+    if (!parser.get<std::string>("topic", topic)) {
+        std::cerr << "Failed to get topic argument." << std::endl;
+        return 1;
+    }
+    if (!socket.empty() && !topic.empty()) {
+        std::cerr << "Only one of socket and topic may be given." << std::endl;
+        return 1;
+    }
+
+    int log_level;
+    if (!parser.get<int>("log_level", log_level)) {
+        std::cerr << "Failed to get log_level argument." << std::endl;
+        return 1;
+    }
+
+    Log::init("mbot_driver");
+    Log::set_level(static_cast<Log::Level>(log_level));
+    if (!Log::toggle_level_on_signal(SIGUSR2, Log::DEBUG)) {
+        Log::warn << "Failed to install the SIGUSR2 handler: " << std::strerror(errno) << std::endl;
+    }
+    // Keep terminal and disk writes off the control loop
+    Log::start_async();
+    if (!binary_log.empty() && !BinaryLog::open(binary_log)) {
+        Log::warn << "Failed to open binary log " << binary_log << ": " << std::strerror(errno) << std::endl;
+    }
+
+    // Applied before the MBot is created so its timesync thread inherits them.
+    if (cpu >= 0 && !pin_to_cpu(cpu)) {
+        Log::warn << "Failed to pin to CPU " << cpu << ": " << std::strerror(errno) << std::endl;
+    }
+    if (priority > 0) {
+        if (!lock_memory()) {
+            Log::warn << "Failed to lock memory: " << std::strerror(errno) << std::endl;
+        }
+        if (!set_realtime_priority(priority)) {
+            Log::warn << "Failed to set real-time priority " << priority << ": " << std::strerror(errno) << std::endl;
+        }
+    }
+
+    auto mbot = std::make_unique<MBot>(timesync_rate);
     if (!mbot->ok()) {
         return 1;
     }
 
-    auto input = std::make_unique<File>(STDIN_FILENO);
+    std::unique_ptr<interfaces::IO> input;
+    if (!topic.empty()) {
+        auto reader = std::make_unique<TopicReader>(topic, geometry::Twist2DStamped().hash());
+        if (!reader->ok()) {
+            Log::error << "Failed to subscribe to " << topic << ": " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+        reader->set_nonblocking(true);
+        input = std::move(reader);
+    } else if (socket.empty()) {
+        input = std::make_unique<File>(STDIN_FILENO);
+    } else {
+        // Messages keep their boundaries on a SEQPACKET socket, so the teleop
+        // sends them without a size prefix
+        UnixSocket listener = UnixSocket::listen(socket, UnixSocket::Type::SEQPACKET, 1);
+        if (!listener.ok()) {
+            Log::error << "Failed to listen on " << socket << ": " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+        Log::info << "Waiting for a connection on " << socket << std::endl;
+        UnixSocket connection = listener.accept();
+        if (!connection.ok()) {
+            Log::error << "Failed to accept a connection on " << socket << ": " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+        File::remove(socket);
+        input = std::make_unique<UnixSocket>(std::move(connection));
+    }
     auto sig = std::make_unique<Signal>(SIGINT);
 
     MBotDriver driver(std::move(input), std::move(mbot));
-    driver.spin(std::move(sig)); 
-}
\ No newline at end of file
+    driver.set_size_prefixed(socket.empty() && topic.empty());
+    driver.set_max_rate(max_rate);
+    driver.set_command_timeout(timeout);
+    driver.set_report_period(report_period);
+    if (trace) {
+        driver.enable_trace(std::make_unique<Signal>(SIGUSR1));
+    }
+    driver.spin(std::move(sig));
+    BinaryLog::close();
+    Log::stop_async();
+}
@@ -1,81 +1,398 @@
 #include "mbot_driver/mbot_driver.hpp"
+#include "rix/util/binary_log.hpp"
+#include "rix/util/log.hpp"
+#include <cerrno>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 
 using namespace rix::ipc;
 using namespace rix::msg;
 
+namespace {
+
+// Frames larger than this are treated as a corrupted size prefix.
+constexpr uint32_t max_frame_size = 1 << 16;
+constexpr size_t read_chunk_size = 4096;
+
+// Deadlines are rounded up to this resolution, far below the send period.
+const rix::util::Duration timer_resolution(0, 100000);
+
+// Returns false if the input ended (EOF) or failed. A read that was
+// interrupted or found no data after all is retried on the next wakeup.
+bool input_ok(ssize_t bytes_read) {
+  if (bytes_read < 0) {
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+  }
+  return bytes_read != 0;
+}
+
+} // namespace
+
 MBotDriver::MBotDriver(std::unique_ptr<interfaces::IO> input,
                        std::unique_ptr<MBotBase> mbot)
-    : input(std::move(input)), mbot(std::move(mbot)) {}
+    : input(std::move(input)), mbot(std::move(mbot)),
+      report_period_(1.0), rx_offset(0), size_prefixed_(true),
+      timers(timer_resolution), timer_fd(true),
+      send_timer(rix::util::TimerWheel::invalid_id),
+      watchdog_timer(rix::util::TimerWheel::invalid_id),
+      report_timer(rix::util::TimerWheel::invalid_id), pending(false),
+      moving(false), trace_read(0), trace_decode(0), trace_write(0) {
+  set_max_rate(default_max_rate);
+}
+
+void MBotDriver::set_max_rate(double rate) {
+  send_period = (rate > 0.0) ? rix::util::Duration(1.0 / rate)
+                             : rix::util::Duration();
+}
+
+double MBotDriver::max_rate() const {
+  if (send_period <= rix::util::Duration()) {
+    return 0.0;
+  }
+  return 1.0 / (send_period.to_nanoseconds() * 1e-9);
+}
+
+void MBotDriver::set_report_period(const rix::util::Duration &period) {
+  report_period_ = period;
+}
+
+rix::util::Duration MBotDriver::report_period() const {
+  return report_period_;
+}
+
+void MBotDriver::set_size_prefixed(bool size_prefixed) {
+  size_prefixed_ = size_prefixed;
+  rx_buffer.clear();
+  rx_offset = 0;
+}
+
+bool MBotDriver::size_prefixed() const { return size_prefixed_; }
+
+void MBotDriver::enable_trace(
+    std::unique_ptr<interfaces::Notification> dump) {
+  trace_ = std::make_unique<rix::util::Trace>("mbot_driver");
+  trace_read = trace_->add_stage("driver_read");
+  trace_decode = trace_->add_stage("decode");
+  trace_write = trace_->add_stage("serial_write");
+  trace_dump = std::move(dump);
+}
+
+const rix::util::Trace *MBotDriver::trace() const { return trace_.get(); }
+
+const MBotDriver::Stats &MBotDriver::stats() const { return stats_; }
+
+void MBotDriver::set_command_timeout(const rix::util::Duration &timeout) {
+  command_timeout_ = timeout;
+}
+
+rix::util::Duration MBotDriver::command_timeout() const {
+  return command_timeout_;
+}
 
 void MBotDriver::spin(std::unique_ptr<interfaces::Notification> notif) {
-  rix::util::Duration timeout(0, 100000000); // 100ms timeout
-  std::vector<uint8_t> buffer;
+  // Wait on the input, SIGINT and the timers together when the input and
+  // SIGINT expose a file descriptor
+  Poller poller;
+  poller.add(input->fd());
+  poller.add(notif->fd());
+  poller.add(trace_dump ? trace_dump->fd() : -1);
+  poller.add(timer_fd.fd());
+  bool multiplexed = input->fd() >= 0 && notif->fd() >= 0 && timer_fd.ok();
+
+  next_send = rix::util::SteadyTime::now();
+  last_command = next_send;
+  pending = false;
+  moving = false;
+  rix::util::SteadyTime armed = rix::util::SteadyTime::max();
 
   while (true) {
-    // Check for SIGINT with short timeout
-    if (notif->wait(timeout)) {
+    // Send slots, the watchdog and the report window share one wakeup source,
+    // armed for the earliest deadline in the timer wheel.
+    rix::util::SteadyTime deadline = timers.next_deadline();
+    if (multiplexed && deadline != armed) {
+      if (deadline == rix::util::SteadyTime::max()) {
+        timer_fd.disarm();
+      } else {
+        timer_fd.set_at(deadline);
+      }
+      armed = deadline;
+    }
+
+    bool signaled = false;
+    bool readable = false;
+    wait(*notif, poller,
+         multiplexed ? rix::util::SteadyTime::max() : deadline, signaled,
+         readable);
+
+    if (signaled) {
       // SIGINT received, stop the mbot
-      geometry::Twist2DStamped stop_cmd;
-      stop_cmd.twist.vx = 0.0;
-      stop_cmd.twist.vy = 0.0;
-      stop_cmd.twist.wz = 0.0;
-      mbot->drive(stop_cmd);
+      stop();
       break;
     }
 
-    // Read size prefix (4-byte UInt32)
-    standard::UInt32 msg_size;
-    uint8_t size_buf[4];
-    ssize_t bytes_read = input->read(size_buf, 4);
-
-    if (bytes_read == 0) {
-      // EOF reached, stop the mbot
-      geometry::Twist2DStamped stop_cmd;
-      stop_cmd.twist.vx = 0.0;
-      stop_cmd.twist.vy = 0.0;
-      stop_cmd.twist.wz = 0.0;
-      mbot->drive(stop_cmd);
-      break;
+    if (trace_dump && (poller.ready(2) || !multiplexed) &&
+        trace_dump->is_ready()) {
+      trace_->report(std::cerr);
     }
 
-    if (bytes_read < 0) {
-      // Read error, continue
-      continue;
+    if (multiplexed && poller.ready(3)) {
+      // The one-shot timer expired and is disarmed
+      timer_fd.consume();
+      armed = rix::util::SteadyTime::max();
     }
 
-    if (bytes_read != 4) {
-      // Incomplete size read, continue
-      continue;
+    if (readable) {
+      if (!read_input()) {
+        // EOF reached or the input failed, stop the mbot
+        stop();
+        break;
+      }
+
+      // Keep only the newest command
+      geometry::Twist2DStamped cmd;
+      rix::util::Time received_at = rix::util::Time::now();
+      while (next_command(cmd)) {
+        // Costs one atomic load unless debug output is switched on, and is
+        // limited to 10 lines per second so it can stay on for a while
+        RIX_LOG_EVERY_T(debug, 0.1) << "Received Drive Command: "
+                                    << "vx=" << cmd.twist.vx
+                                    << ", vy=" << cmd.twist.vy
+                                    << ", wz=" << cmd.twist.wz << std::endl;
+
+        if (trace_) {
+          rix::util::Time stamp(cmd.header.stamp);
+          trace_->record(trace_read, received_at - stamp);
+          trace_->record(trace_decode, stamp);
+        }
+        if (report_period_ > rix::util::Duration()) {
+          report_latency.record(received_at -
+                                rix::util::Time(cmd.header.stamp));
+        }
+        stats_.received++;
+        if (pending) {
+          stats_.coalesced++;
+        }
+        latest = cmd;
+        pending = true;
+      }
+
+      if (pending) {
+        // The watchdog is not touched here: it checks the time of the last
+        // command when it expires and pushes itself back if needed, so a
+        // stream of commands costs no timer operations.
+        last_command = rix::util::SteadyTime::now();
+
+        if (report_period_ > rix::util::Duration() &&
+            !timers.pending(report_timer)) {
+          // Commands started arriving, open a new reporting window
+          report_start = last_command;
+          report_timer = timers.schedule(report_start + report_period_,
+                                         [this] { report(); });
+        }
+
+        if (!timers.pending(send_timer)) {
+          if (last_command >= next_send) {
+            send(last_command);
+          } else {
+            send_timer = timers.schedule(next_send, [this] {
+              send(rix::util::SteadyTime::now());
+            });
+          }
+        }
+      }
     }
 
-    // Deserialize the size
+    timers.advance(rix::util::SteadyTime::now());
+  }
+
+  if (trace_) {
+    trace_->report(std::cerr);
+  }
+}
+
+void MBotDriver::send(const rix::util::SteadyTime &now) {
+  if (!pending) {
+    return;
+  }
+
+  // Command the mbot with the full message
+  mbot->drive(latest);
+  stats_.sent++;
+  RIX_BLOG(rix::util::Log::INFO, "sent vx={} vy={} wz={} stamp_ns={}",
+           latest.twist.vx, latest.twist.vy, latest.twist.wz,
+           rix::util::Time(latest.header.stamp).to_nanoseconds());
+  if (trace_) {
+    trace_->record(trace_write, rix::util::Time(latest.header.stamp));
+  }
+  pending = false;
+  moving = latest.twist.vx != 0.0 || latest.twist.vy != 0.0 ||
+           latest.twist.wz != 0.0;
+
+  if (moving && command_timeout_ > rix::util::Duration() &&
+      !timers.pending(watchdog_timer)) {
+    watchdog_timer = timers.schedule(last_command + command_timeout_,
+                                     [this] { check_watchdog(); });
+  }
+
+  // Send slots stay on a fixed grid so commands line up with the board's
+  // control period. Slots that passed while idle are skipped.
+  if (send_period > rix::util::Duration()) {
+    next_send += send_period;
+    if (next_send <= now) {
+      next_send += rix::util::Duration(
+          send_period.get() *
+          ((now - next_send).get() / send_period.get() + 1));
+    }
+  }
+}
+
+void MBotDriver::check_watchdog() {
+  if (!moving || pending) {
+    // Stopped already, or a command is about to be sent and `send` re-arms
+    // the watchdog
+    return;
+  }
+
+  rix::util::SteadyTime deadline = last_command + command_timeout_;
+  if (rix::util::SteadyTime::now() < deadline) {
+    // Commands arrived since the watchdog was armed
+    watchdog_timer =
+        timers.schedule(deadline, [this] { check_watchdog(); });
+    return;
+  }
+
+  // Commands stopped arriving, stop the mbot
+  stop();
+  stats_.timeouts++;
+  moving = false;
+}
+
+void MBotDriver::wait(interfaces::Notification &notif, Poller &poller,
+                      const rix::util::SteadyTime &deadline,
+                      bool &signaled, bool &readable) {
+  rix::util::Duration timeout = rix::util::Duration::max();
+  if (deadline != rix::util::SteadyTime::max()) {
+    timeout = std::max(deadline - rix::util::SteadyTime::now(),
+                       rix::util::Duration());
+  }
+
+  if (input->fd() >= 0 && notif.fd() >= 0) {
+    poller.wait(timeout);
+    signaled = poller.ready(1) && notif.is_ready();
+    readable = poller.ready(0);
+    return;
+  }
+
+  // Without file descriptors, check for SIGINT and then wait on the input
+  // in short slices so SIGINT is still noticed while idle. Round up so a
+  // sub-millisecond wait does not turn into a busy loop.
+  signaled = notif.is_ready();
+  if (!signaled) {
+    timeout = std::min(timeout, rix::util::Duration(0, 100000000));
+    timeout = rix::util::Duration(
+        std::chrono::ceil<std::chrono::milliseconds>(timeout.get()));
+    readable = input->wait_for_readable(timeout);
+  }
+}
+
+bool MBotDriver::read_input() {
+  if (!size_prefixed_) {
+    // Each read returns one whole message. Messages larger than the buffer
+    // are truncated and fail to decode.
+    rx_buffer.resize(read_chunk_size);
+    ssize_t bytes_read = input->read(rx_buffer.data(), rx_buffer.size());
+    rx_buffer.resize(std::max<ssize_t>(bytes_read, 0));
+    rx_offset = 0;
+    return input_ok(bytes_read);
+  }
+
+  // Compact consumed bytes before growing the buffer
+  if (rx_offset > 0) {
+    rx_buffer.erase(rx_buffer.begin(), rx_buffer.begin() + rx_offset);
+    rx_offset = 0;
+  }
+
+  size_t size = rx_buffer.size();
+  rx_buffer.resize(size + read_chunk_size);
+  ssize_t bytes_read = input->read(rx_buffer.data() + size, read_chunk_size);
+  rx_buffer.resize(size + std::max<ssize_t>(bytes_read, 0));
+  return input_ok(bytes_read);
+}
+
+bool MBotDriver::next_command(geometry::Twist2DStamped &cmd) {
+  if (!size_prefixed_) {
+    if (rx_offset == rx_buffer.size()) {
+      return false;
+    }
     size_t offset = 0;
-    if (!rix::msg::detail::deserialize_number(msg_size.data, size_buf, 4,
-                                              offset)) {
-      continue;
+    rx_offset = rx_buffer.size();
+    if (cmd.deserialize(rx_buffer.data(), rx_buffer.size(), offset)) {
+      return true;
     }
+    stats_.dropped++;
+    return false;
+  }
+
+  while (rx_buffer.size() - rx_offset >= 4) {
+    // Deserialize the size prefix (4-byte UInt32)
+    standard::UInt32 msg_size;
+    size_t offset = rx_offset;
+    rix::msg::detail::deserialize_number(msg_size.data, rx_buffer.data(),
+                                         rx_buffer.size(), offset);
 
-    // Read the message data
-    buffer.resize(msg_size.data);
-    bytes_read = input->read(buffer.data(), msg_size.data);
+    if (msg_size.data > max_frame_size) {
+      // Corrupted prefix, there is no way to resynchronize the stream
+      stats_.dropped++;
+      rx_buffer.clear();
+      rx_offset = 0;
+      return false;
+    }
 
-    if (bytes_read != static_cast<ssize_t>(msg_size.data)) {
-      // Incomplete message read
-      continue;
+    if (rx_buffer.size() - offset < msg_size.data) {
+      // Incomplete message, wait for more data
+      return false;
     }
 
     // Deserialize the Twist2DStamped message
-    geometry::Twist2DStamped twist_msg;
-    offset = 0;
-    if (twist_msg.deserialize(buffer.data(), buffer.size(), offset)) {
-      // Log the received drive command
-      std::cout << "Received Drive Command: "
-                << "vx=" << twist_msg.twist.vx << ", vy=" << twist_msg.twist.vy
-                << ", wz=" << twist_msg.twist.wz << std::endl;
-
-      // Command the mbot with the full message
-      mbot->drive(twist_msg);
+    size_t end = offset + msg_size.data;
+    rx_offset = end;
+    if (cmd.deserialize(rx_buffer.data(), end, offset)) {
+      return true;
     }
+    stats_.dropped++;
   }
-}
\ No newline at end of file
+  return false;
+}
+
+void MBotDriver::report() {
+  rix::util::SteadyTime now = rix::util::SteadyTime::now();
+  double seconds = (now - report_start).to_nanoseconds() * 1e-9;
+  uint64_t received = stats_.received - report_stats.received;
+
+  std::ostringstream summary;
+  summary << std::fixed << std::setprecision(1) << "Commands: "
+          << received / seconds << "/s"
+          << ", sent " << stats_.sent - report_stats.sent << ", coalesced "
+          << stats_.coalesced - report_stats.coalesced << ", dropped "
+          << stats_.dropped - report_stats.dropped << ", timeouts "
+          << stats_.timeouts - report_stats.timeouts
+          << " | latency (us) p50=" << report_latency.percentile(50) / 1e3
+          << " p90=" << report_latency.percentile(90) / 1e3
+          << " p99=" << report_latency.percentile(99) / 1e3
+          << " max=" << report_latency.max() / 1e3;
+  rix::util::Log::info << summary.str() << std::endl;
+
+  // The next window opens when the next command arrives, so an idle driver
+  // does not wake up to report nothing.
+  report_stats = stats_;
+  report_latency.reset();
+}
+
+void MBotDriver::stop() {
+  geometry::Twist2DStamped stop_cmd;
+  stop_cmd.twist.vx = 0.0;
+  stop_cmd.twist.vy = 0.0;
+  stop_cmd.twist.wz = 0.0;
+  mbot->drive(stop_cmd);
+}
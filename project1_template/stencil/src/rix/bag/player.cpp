@@ -0,0 +1,151 @@
+#include "rix/bag/player.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include "rix/ipc/poller.hpp"
+#include "rix/msg/standard/UInt32.hpp"
+
+namespace rix {
+namespace bag {
+
+namespace {
+
+// Messages sent as fast as possible between checks of the stop notification
+constexpr uint64_t stop_check_interval = 256;
+
+}  // namespace
+
+Player::Player(std::unique_ptr<ipc::interfaces::IO> output)
+    : output_(std::move(output)), speed_(1.0), size_prefixed_(true), filter_(false), hash_{0, 0}, timer_(true) {}
+
+void Player::set_speed(double speed) { speed_ = speed > 0.0 ? speed : 0.0; }
+
+double Player::speed() const { return speed_; }
+
+void Player::set_size_prefixed(bool size_prefixed) { size_prefixed_ = size_prefixed; }
+
+bool Player::size_prefixed() const { return size_prefixed_; }
+
+void Player::set_type(const std::array<uint64_t, 2> &hash) {
+    filter_ = true;
+    hash_ = hash;
+}
+
+bool Player::play(Reader &reader, const ipc::interfaces::Notification *notif) {
+    stats_ = Stats();
+    View view;
+    bool started = false;
+    int64_t first = 0;
+    util::SteadyTime start;
+    bool stopped = false;
+    while (reader.next(view)) {
+        if (filter_ && view.hash != hash_) {
+            stats_.skipped++;
+            continue;
+        }
+
+        int64_t stamp = view.stamp.to_nanoseconds();
+        if (!started) {
+            started = true;
+            first = stamp;
+            start = util::SteadyTime::now();
+        }
+
+        if (speed_ > 0.0) {
+            // Offsets from the first message, so deadlines do not drift
+            util::Duration offset(util::Duration::Type(static_cast<int64_t>((stamp - first) / speed_)));
+            util::SteadyTime deadline = start + offset;
+            if (!wait_until(deadline, notif)) {
+                stopped = true;
+                break;
+            }
+            stats_.lateness.record(util::SteadyTime::now() - deadline);
+        } else if (notif != nullptr && (stats_.sent + stats_.failed) % stop_check_interval == 0 &&
+                   notif->is_ready()) {
+            stopped = true;
+            break;
+        }
+
+        if (send(view)) {
+            stats_.sent++;
+        } else {
+            stats_.failed++;
+        }
+    }
+    if (started) {
+        stats_.elapsed = util::SteadyTime::now() - start;
+    }
+    return !stopped;
+}
+
+const Player::Stats &Player::stats() const { return stats_; }
+
+bool Player::wait_until(const util::SteadyTime &deadline, const ipc::interfaces::Notification *notif) {
+    if (notif == nullptr) {
+        util::sleep_until(deadline);
+        return true;
+    }
+    if (notif->fd() < 0 || !timer_.ok()) {
+        util::sleep_until(deadline);
+        return !notif->is_ready();
+    }
+
+    ipc::Poller poller;
+    size_t stop_index = poller.add(notif->fd());
+    size_t timer_index = poller.add(timer_.fd());
+    timer_.set_at(deadline);
+    while (true) {
+        poller.wait(util::Duration::max());
+        if (poller.ready(stop_index) && notif->is_ready()) {
+            timer_.disarm();
+            return false;
+        }
+        if (poller.ready(timer_index) && timer_.consume() > 0) {
+            return true;
+        }
+    }
+}
+
+bool Player::send(const View &view) {
+    if (view.size > std::numeric_limits<uint32_t>::max()) {
+        return false;
+    }
+
+    const uint8_t *data = view.data;
+    size_t size = view.size;
+    if (size_prefixed_) {
+        // Prefix and message in one write, so a reader never sees half a frame
+        msg::standard::UInt32 prefix;
+        prefix.data = static_cast<uint32_t>(view.size);
+        frame_.resize(prefix.size() + view.size);
+        size_t offset = 0;
+        prefix.serialize(frame_.data(), offset);
+        std::memcpy(frame_.data() + offset, view.data, view.size);
+        data = frame_.data();
+        size = frame_.size();
+    }
+
+    size_t written = 0;
+    while (written < size) {
+        ssize_t n = output_->write(data + written, size - written);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                output_->wait_for_writable(util::Duration(0.1));
+                continue;
+            }
+            return false;
+        }
+        written += n;
+    }
+    return true;
+}
+
+}  // namespace bag
+}  // namespace rix
@@ -0,0 +1,283 @@
+#include "rix/bag/reader.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include "rix/util/lz.hpp"
+
+namespace rix {
+namespace bag {
+
+namespace {
+
+// Larger chunks are treated as a corrupted header
+constexpr uint64_t max_chunk_size = 1 << 30;
+
+util::Time to_time(int64_t nanoseconds) { return util::Time(util::Time::Type(std::chrono::nanoseconds(nanoseconds))); }
+
+}  // namespace
+
+bool View::deserialize(msg::Message &msg) const {
+    if (msg.hash() != hash) {
+        return false;
+    }
+    size_t offset = 0;
+    return msg.deserialize(data, size, offset);
+}
+
+Reader::Reader()
+    : map_(nullptr),
+      map_size_(0),
+      indexed_(false),
+      sorted_(true),
+      count_(0),
+      chunk_(0),
+      data_(nullptr),
+      data_size_(0),
+      position_(0) {}
+
+Reader::Reader(const std::string &path) : Reader() { open(path); }
+
+Reader::~Reader() { close(); }
+
+bool Reader::open(const std::string &path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) < 0) {
+        int error = errno;
+        ::close(fd);
+        errno = error;
+        return false;
+    }
+    size_t size = info.st_size;
+    if (size < sizeof(format::file_magic)) {
+        ::close(fd);
+        errno = EINVAL;
+        return false;
+    }
+    void *map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    int error = errno;
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        errno = error;
+        return false;
+    }
+    map_ = static_cast<const uint8_t *>(map);
+    map_size_ = size;
+    if (std::memcmp(map_, format::file_magic, sizeof(format::file_magic)) != 0) {
+        close();
+        errno = EINVAL;
+        return false;
+    }
+    // Messages are mostly read in order
+    ::madvise(map, size, MADV_SEQUENTIAL);
+
+    // Use the index if the bag was closed cleanly
+    size_t end = map_size_;
+    format::Footer footer;
+    if (map_size_ >= sizeof(format::file_magic) + sizeof(footer)) {
+        std::memcpy(&footer, map_ + map_size_ - sizeof(footer), sizeof(footer));
+        size_t index_end = map_size_ - sizeof(footer);
+        if (footer.magic == format::footer_magic && footer.index_offset <= index_end &&
+            footer.chunk_count == (index_end - footer.index_offset) / sizeof(format::ChunkInfo) &&
+            (index_end - footer.index_offset) % sizeof(format::ChunkInfo) == 0) {
+            index_.resize(footer.chunk_count);
+            std::memcpy(index_.data(), map_ + footer.index_offset, footer.chunk_count * sizeof(format::ChunkInfo));
+            indexed_ = true;
+            end = footer.index_offset;
+        }
+    }
+
+    if (!indexed_) {
+        // Walk the chunk headers up to the first one that is cut short
+        size_t offset = sizeof(format::file_magic);
+        format::ChunkHeader header;
+        while (end - offset >= sizeof(header)) {
+            std::memcpy(&header, map_ + offset, sizeof(header));
+            if (header.magic != format::chunk_magic || header.stored_size > end - offset - sizeof(header)) {
+                break;
+            }
+            index_.push_back({offset, header.start, header.end, header.count});
+            offset += sizeof(header) + header.stored_size;
+        }
+    }
+
+    for (size_t i = 0; i < index_.size(); i++) {
+        count_ += index_[i].count;
+        if (i > 0 && index_[i].end < index_[i - 1].end) {
+            sorted_ = false;
+        }
+    }
+    rewind();
+    return true;
+}
+
+void Reader::close() {
+    if (map_ != nullptr) {
+        ::munmap(const_cast<uint8_t *>(map_), map_size_);
+    }
+    map_ = nullptr;
+    map_size_ = 0;
+    indexed_ = false;
+    sorted_ = true;
+    index_.clear();
+    count_ = 0;
+    chunk_ = 0;
+    data_ = nullptr;
+    data_size_ = 0;
+    position_ = 0;
+}
+
+bool Reader::is_open() const { return map_ != nullptr; }
+
+bool Reader::indexed() const { return indexed_; }
+
+uint64_t Reader::size() const { return count_; }
+
+size_t Reader::chunks() const { return index_.size(); }
+
+util::Time Reader::start_time() const {
+    int64_t start = 0;
+    for (size_t i = 0; i < index_.size(); i++) {
+        if (i == 0 || index_[i].start < start) {
+            start = index_[i].start;
+        }
+    }
+    return to_time(start);
+}
+
+util::Time Reader::end_time() const {
+    int64_t end = 0;
+    for (size_t i = 0; i < index_.size(); i++) {
+        if (i == 0 || index_[i].end > end) {
+            end = index_[i].end;
+        }
+    }
+    return to_time(end);
+}
+
+bool Reader::seek(const util::Time &time) {
+    int64_t target = time.to_nanoseconds();
+    auto ends_before = [target](const format::ChunkInfo &info) { return info.end < target; };
+    // The first chunk that ends at or after `time`. When stamps went
+    // backwards across chunks, a later chunk may still end before `time`, so
+    // every chunk is checked instead
+    size_t first = 0;
+    if (sorted_) {
+        first = std::partition_point(index_.begin(), index_.end(), ends_before) - index_.begin();
+    }
+    for (size_t i = first; i < index_.size(); i++) {
+        if (ends_before(index_[i]) || !load(i)) {
+            continue;
+        }
+        View view;
+        while (peek(view)) {
+            if (view.stamp.to_nanoseconds() >= target) {
+                return true;
+            }
+            position_ += sizeof(format::RecordHeader) + view.size;
+        }
+    }
+    chunk_ = index_.size();
+    data_ = nullptr;
+    data_size_ = 0;
+    position_ = 0;
+    return false;
+}
+
+void Reader::rewind() {
+    chunk_ = 0;
+    data_ = nullptr;
+    data_size_ = 0;
+    position_ = 0;
+    if (!index_.empty()) {
+        load(0);
+    }
+}
+
+bool Reader::next(View &view) {
+    while (!peek(view)) {
+        // The current chunk is finished (or corrupted), move to the next one
+        if (chunk_ + 1 >= index_.size()) {
+            data_ = nullptr;
+            data_size_ = 0;
+            position_ = 0;
+            chunk_ = index_.size();
+            return false;
+        }
+        load(chunk_ + 1);
+    }
+    position_ += sizeof(format::RecordHeader) + view.size;
+    return true;
+}
+
+bool Reader::load(size_t index) {
+    chunk_ = index;
+    data_ = nullptr;
+    data_size_ = 0;
+    position_ = 0;
+
+    uint64_t offset = index_[index].offset;
+    format::ChunkHeader header;
+    if (offset > map_size_ || map_size_ - offset < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, map_ + offset, sizeof(header));
+    offset += sizeof(header);
+    if (header.magic != format::chunk_magic || header.stored_size > map_size_ - offset) {
+        return false;
+    }
+    switch (static_cast<Compression>(header.compression)) {
+        case Compression::NONE:
+            if (header.raw_size != header.stored_size) {
+                return false;
+            }
+            data_ = map_ + offset;
+            break;
+        case Compression::LZ:
+            if (header.raw_size > max_chunk_size) {
+                return false;
+            }
+            decompressed_.resize(header.raw_size);
+            if (!util::lz::decompress(map_ + offset, header.stored_size, decompressed_.data(), header.raw_size)) {
+                return false;
+            }
+            data_ = decompressed_.data();
+            break;
+        default:
+            return false;
+    }
+    data_size_ = header.raw_size;
+    return true;
+}
+
+bool Reader::peek(View &view) const {
+    format::RecordHeader header;
+    if (data_ == nullptr || data_size_ - position_ < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, data_ + position_, sizeof(header));
+    if (header.size > data_size_ - position_ - sizeof(header)) {
+        return false;
+    }
+    view.hash = {header.hash[0], header.hash[1]};
+    view.stamp = to_time(header.stamp);
+    view.data = data_ + position_ + sizeof(header);
+    view.size = header.size;
+    return true;
+}
+
+}  // namespace bag
+}  // namespace rix
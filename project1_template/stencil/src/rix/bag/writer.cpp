@@ -0,0 +1,298 @@
+#include "rix/bag/writer.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <limits>
+
+#include "rix/util/lz.hpp"
+
+namespace rix {
+namespace bag {
+
+namespace {
+
+// Buffers of written chunks kept for reuse
+constexpr size_t max_free_buffers = 4;
+
+}  // namespace
+
+Writer::Writer()
+    : fd_(-1),
+      chunk_size_(default_chunk_size),
+      max_pending_(default_max_pending),
+      current_{{}, 0, 0, 0},
+      busy_(false),
+      stopping_(false),
+      error_(0),
+      compression_(Compression::NONE),
+      offset_(0),
+      written_(0),
+      dropped_(0) {}
+
+Writer::Writer(const std::string &path, size_t chunk_size) : Writer() { open(path, chunk_size); }
+
+Writer::~Writer() { close(); }
+
+bool Writer::open(const std::string &path, size_t chunk_size) {
+    close();
+
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(mutex_);
+    fd_ = fd;
+    chunk_size_ = chunk_size;
+    current_ = {{}, 0, 0, 0};
+    current_.data.reserve(chunk_size_);
+    pending_.clear();
+    busy_ = false;
+    stopping_ = false;
+    error_ = 0;
+    index_.clear();
+    offset_ = 0;
+    written_ = 0;
+    dropped_ = 0;
+    if (!write_all(format::file_magic, sizeof(format::file_magic))) {
+        int error = errno;
+        ::close(fd_);
+        fd_ = -1;
+        errno = error;
+        return false;
+    }
+    offset_ = sizeof(format::file_magic);
+    thread_ = std::thread(&Writer::flush_loop, this);
+    return true;
+}
+
+bool Writer::close() {
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (fd_ < 0 || stopping_) {
+            return true;
+        }
+        seal(true);
+        stopping_ = true;
+    }
+    pending_cv_.notify_one();
+    thread_.join();
+
+    // The background thread is gone, so the index can be read without the lock
+    std::lock_guard<std::mutex> guard(mutex_);
+    format::Footer footer = {offset_.load(), index_.size(), format::footer_magic};
+    bool ok = error_ == 0 && write_all(index_.data(), index_.size() * sizeof(format::ChunkInfo)) &&
+              write_all(&footer, sizeof(footer));
+    int error = ok ? 0 : (error_ != 0 ? error_ : errno);
+    if (::close(fd_) < 0 && ok) {
+        ok = false;
+        error = errno;
+    }
+    fd_ = -1;
+    stopping_ = false;
+    if (!ok) {
+        errno = error;
+    }
+    return ok;
+}
+
+bool Writer::is_open() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return fd_ >= 0 && !stopping_;
+}
+
+bool Writer::write(const msg::Message &msg, const util::Time &stamp) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    size_t size = msg.size();
+    uint8_t *dst = append(msg.hash(), size, stamp.to_nanoseconds());
+    if (dst == nullptr) {
+        return false;
+    }
+    // Serialized in place, so a message is copied once
+    size_t offset = 0;
+    msg.serialize(dst, offset);
+    return true;
+}
+
+bool Writer::write(const std::array<uint64_t, 2> &hash, const uint8_t *data, size_t size, const util::Time &stamp) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    uint8_t *dst = append(hash, size, stamp.to_nanoseconds());
+    if (dst == nullptr) {
+        return false;
+    }
+    if (size > 0) {
+        std::memcpy(dst, data, size);
+    }
+    return true;
+}
+
+bool Writer::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (fd_ < 0 || stopping_) {
+        return true;
+    }
+    seal(true);
+    pending_cv_.notify_one();
+    done_cv_.wait(lock, [this] { return pending_.empty() && !busy_; });
+    if (error_ != 0) {
+        errno = error_;
+        return false;
+    }
+    return true;
+}
+
+void Writer::set_max_pending(size_t chunks) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    max_pending_ = chunks;
+}
+
+size_t Writer::max_pending() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return max_pending_;
+}
+
+void Writer::set_compression(Compression compression) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    compression_ = compression;
+}
+
+Compression Writer::compression() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return compression_;
+}
+
+uint64_t Writer::bytes_written() const { return offset_.load(std::memory_order_relaxed); }
+
+uint64_t Writer::written() const { return written_.load(std::memory_order_relaxed); }
+
+uint64_t Writer::dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+uint8_t *Writer::append(const std::array<uint64_t, 2> &hash, size_t size, int64_t stamp) {
+    if (fd_ < 0 || stopping_ || size > std::numeric_limits<uint32_t>::max()) {
+        return nullptr;
+    }
+
+    size_t record_size = sizeof(format::RecordHeader) + size;
+    if (current_.count > 0 && current_.data.size() + record_size > chunk_size_) {
+        seal(false);
+    }
+
+    format::RecordHeader header = {static_cast<uint32_t>(size), 0, {hash[0], hash[1]}, stamp};
+    size_t position = current_.data.size();
+    current_.data.resize(position + record_size);
+    std::memcpy(current_.data.data() + position, &header, sizeof(header));
+    if (current_.count == 0 || stamp < current_.start) {
+        current_.start = stamp;
+    }
+    if (current_.count == 0 || stamp > current_.end) {
+        current_.end = stamp;
+    }
+    current_.count++;
+    written_.fetch_add(1, std::memory_order_relaxed);
+    return current_.data.data() + position + sizeof(header);
+}
+
+void Writer::seal(bool force) {
+    if (current_.count == 0) {
+        return;
+    }
+    if (!force && pending_.size() >= max_pending_) {
+        // The disk is too slow. Dropping the chunk keeps the caller from
+        // blocking and the memory bounded.
+        written_.fetch_sub(current_.count, std::memory_order_relaxed);
+        dropped_.fetch_add(current_.count, std::memory_order_relaxed);
+        current_.data.clear();
+        current_.count = 0;
+        return;
+    }
+
+    pending_.push_back(std::move(current_));
+    current_ = {{}, 0, 0, 0};
+    if (!free_.empty()) {
+        current_.data = std::move(free_.back());
+        free_.pop_back();
+    } else {
+        current_.data.reserve(chunk_size_);
+    }
+    pending_cv_.notify_one();
+}
+
+void Writer::flush_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        pending_cv_.wait(lock, [this] { return !pending_.empty() || stopping_; });
+        if (pending_.empty()) {
+            break;
+        }
+
+        Chunk chunk = std::move(pending_.front());
+        pending_.pop_front();
+        // After a failed write the end of the file is unknown, so later
+        // chunks are not written either
+        bool skip = error_ != 0;
+        Compression compression = compression_;
+        busy_ = true;
+        lock.unlock();
+        bool ok = skip || write_chunk(chunk, compression);
+        int error = errno;
+        lock.lock();
+        busy_ = false;
+        if (!ok && error_ == 0) {
+            error_ = error;
+        }
+        if (free_.size() < max_free_buffers) {
+            chunk.data.clear();
+            free_.push_back(std::move(chunk.data));
+        }
+        done_cv_.notify_all();
+    }
+}
+
+bool Writer::write_chunk(const Chunk &chunk, Compression compression) {
+    const uint8_t *data = chunk.data.data();
+    size_t size = chunk.data.size();
+    if (compression == Compression::LZ) {
+        compressed_.resize(util::lz::compress_bound(size));
+        size_t compressed_size = util::lz::compress(data, size, compressed_.data());
+        if (compressed_size < size) {
+            data = compressed_.data();
+            size = compressed_size;
+        } else {
+            compression = Compression::NONE;
+        }
+    }
+
+    format::ChunkHeader header = {format::chunk_magic, static_cast<uint32_t>(compression),
+                                  size,                chunk.data.size(),
+                                  chunk.start,         chunk.end,
+                                  chunk.count};
+    if (!write_all(&header, sizeof(header)) || !write_all(data, size)) {
+        return false;
+    }
+    uint64_t offset = offset_.load(std::memory_order_relaxed);
+    index_.push_back({offset, chunk.start, chunk.end, chunk.count});
+    offset_.store(offset + sizeof(header) + size, std::memory_order_relaxed);
+    return true;
+}
+
+bool Writer::write_all(const void *data, size_t size) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    size_t written = 0;
+    while (written < size) {
+        ssize_t n = ::write(fd_, bytes + written, size - written);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        written += n;
+    }
+    return true;
+}
+
+}  // namespace bag
+}  // namespace rix
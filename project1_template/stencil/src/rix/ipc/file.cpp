@@ -145,7 +145,9 @@ bool File::wait_for_readable(const util::Duration &duration) const {
   int timeout_ms =
       (duration == util::Duration::max()) ? -1 : duration.to_milliseconds();
   int ret = ::poll(&pfd, 1, timeout_ms);
-  return ret > 0 && (pfd.revents & POLLIN);
+  // A hang-up means read will not block (it returns EOF), so it counts as
+  // readable even when no data is pending.
+  return ret > 0 && (pfd.revents & (POLLIN | POLLHUP));
 }
 
 } // namespace ipc
@@ -0,0 +1,54 @@
+#include "rix/ipc/poller.hpp"
+#include <cerrno>
+
+namespace rix {
+namespace ipc {
+
+Poller::Poller() {}
+
+size_t Poller::add(int fd, short events) {
+  fds_.push_back({fd, events, 0});
+  return fds_.size() - 1;
+}
+
+void Poller::disable(size_t index) {
+  // poll ignores entries with a negative file descriptor
+  if (fds_[index].fd >= 0) {
+    fds_[index].fd = ~fds_[index].fd;
+  }
+  fds_[index].revents = 0;
+}
+
+int Poller::wait(const util::Duration &timeout) {
+  struct timespec ts;
+  struct timespec *tsp = nullptr;
+  if (timeout != util::Duration::max()) {
+    int64_t ns = timeout.to_nanoseconds();
+    if (ns < 0) {
+      ns = 0;
+    }
+    ts.tv_sec = ns / 1'000'000'000;
+    ts.tv_nsec = ns % 1'000'000'000;
+    tsp = &ts;
+  }
+
+  int ret = ::ppoll(fds_.data(), fds_.size(), tsp, nullptr);
+  if (ret < 0) {
+    for (auto &pfd : fds_) {
+      pfd.revents = 0;
+    }
+    return errno == EINTR ? 0 : -1;
+  }
+  return ret;
+}
+
+bool Poller::ready(size_t index) const {
+  const struct pollfd &pfd = fds_[index];
+  return pfd.fd >= 0 &&
+         (pfd.revents & (pfd.events | POLLHUP | POLLERR | POLLNVAL));
+}
+
+size_t Poller::size() const { return fds_.size(); }
+
+} // namespace ipc
+} // namespace rix
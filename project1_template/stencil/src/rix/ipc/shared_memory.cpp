@@ -0,0 +1,104 @@
+#include "rix/ipc/shared_memory.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <utility>
+
+namespace rix {
+namespace ipc {
+
+SharedMemory SharedMemory::create(const std::string &name, size_t size) {
+  int fd = ::memfd_create(name.c_str(), MFD_CLOEXEC);
+  if (fd < 0) {
+    return {};
+  }
+  if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    int error = errno;
+    ::close(fd);
+    errno = error;
+    return {};
+  }
+  return SharedMemory(fd);
+}
+
+SharedMemory::SharedMemory() : File(), data_(nullptr), size_(0) {}
+
+SharedMemory::SharedMemory(int fd) : File(fd), data_(nullptr), size_(0) {
+  map();
+}
+
+SharedMemory::SharedMemory(const SharedMemory &other)
+    : File(other), data_(nullptr), size_(0) {
+  map();
+}
+
+SharedMemory &SharedMemory::operator=(const SharedMemory &other) {
+  if (this != &other) {
+    unmap();
+    File::operator=(other);
+    map();
+  }
+  return *this;
+}
+
+SharedMemory::~SharedMemory() { unmap(); }
+
+SharedMemory::SharedMemory(SharedMemory &&other)
+    : File(std::move(other)), data_(other.data_), size_(other.size_) {
+  other.data_ = nullptr;
+  other.size_ = 0;
+}
+
+SharedMemory &SharedMemory::operator=(SharedMemory &&other) {
+  if (this != &other) {
+    unmap();
+    File::operator=(std::move(other));
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+  }
+  return *this;
+}
+
+uint8_t *SharedMemory::data() const { return data_; }
+
+size_t SharedMemory::size() const { return size_; }
+
+void SharedMemory::map() {
+  if (fd_ < 0) {
+    return;
+  }
+
+  struct stat info;
+  void *data = MAP_FAILED;
+  if (::fstat(fd_, &info) == 0) {
+    if (info.st_size == 0) {
+      errno = EINVAL;
+    } else {
+      data = ::mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    fd_, 0);
+    }
+  }
+  if (data == MAP_FAILED) {
+    int error = errno;
+    ::close(fd_);
+    fd_ = -1;
+    errno = error;
+    return;
+  }
+  data_ = static_cast<uint8_t *>(data);
+  size_ = info.st_size;
+}
+
+void SharedMemory::unmap() {
+  if (data_ != nullptr) {
+    ::munmap(data_, size_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
+
+} // namespace ipc
+} // namespace rix
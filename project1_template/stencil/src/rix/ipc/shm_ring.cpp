@@ -0,0 +1,233 @@
+#include "rix/ipc/shm_ring.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <utility>
+
+namespace rix {
+namespace ipc {
+
+// Shared by both processes, so every field has a fixed size and the atomics
+// must not depend on a lock in either address space.
+struct ShmRing::Header {
+  uint64_t magic;
+  uint64_t capacity;
+  alignas(64) std::atomic<uint64_t> head; //< Written by the producer.
+  alignas(64) std::atomic<uint64_t> tail; //< Advanced by both sides.
+  alignas(64) std::atomic<uint64_t> dropped;
+  std::atomic<uint32_t> waiting; //< Set while the consumer is blocked.
+  std::atomic<uint32_t> closed;
+};
+
+namespace {
+
+constexpr uint64_t ring_magic = 0x31474e4952584952; // "RIXRING1"
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free &&
+                  std::atomic<uint32_t>::is_always_lock_free,
+              "ShmRing needs lock-free atomics");
+
+size_t round_up_pow2(size_t value) {
+  size_t result = 64;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+} // namespace
+
+ShmRing ShmRing::create(size_t capacity) {
+  capacity = round_up_pow2(capacity);
+  SharedMemory memory =
+      SharedMemory::create("rix_ring", sizeof(Header) + capacity);
+  if (!memory.ok()) {
+    return {};
+  }
+  // The memory is zero-filled, so only the constants need to be set
+  Header *header = new (memory.data()) Header();
+  header->magic = ring_magic;
+  header->capacity = capacity;
+  return ShmRing(std::move(memory));
+}
+
+ShmRing::ShmRing()
+    : memory_(), header_(nullptr), buffer_(nullptr), capacity_(0) {}
+
+ShmRing::ShmRing(SharedMemory memory)
+    : memory_(std::move(memory)), header_(nullptr), buffer_(nullptr),
+      capacity_(0) {
+  if (!memory_.ok()) {
+    return;
+  }
+  Header *header = reinterpret_cast<Header *>(memory_.data());
+  size_t capacity = memory_.size() >= sizeof(Header) ? header->capacity : 0;
+  if (memory_.size() < sizeof(Header) || header->magic != ring_magic ||
+      capacity < 64 || (capacity & (capacity - 1)) != 0 ||
+      memory_.size() - sizeof(Header) < capacity) {
+    memory_ = SharedMemory();
+    errno = EINVAL;
+    return;
+  }
+  header_ = header;
+  buffer_ = memory_.data() + sizeof(Header);
+  capacity_ = capacity;
+}
+
+ShmRing::ShmRing(ShmRing &&other)
+    : memory_(std::move(other.memory_)), header_(other.header_),
+      buffer_(other.buffer_), capacity_(other.capacity_) {
+  other.header_ = nullptr;
+  other.buffer_ = nullptr;
+  other.capacity_ = 0;
+}
+
+ShmRing &ShmRing::operator=(ShmRing &&other) {
+  if (this != &other) {
+    memory_ = std::move(other.memory_);
+    header_ = std::exchange(other.header_, nullptr);
+    buffer_ = std::exchange(other.buffer_, nullptr);
+    capacity_ = std::exchange(other.capacity_, 0);
+  }
+  return *this;
+}
+
+bool ShmRing::ok() const { return header_ != nullptr; }
+
+const SharedMemory &ShmRing::memory() const { return memory_; }
+
+bool ShmRing::push(const void *data, size_t size, bool overwrite) const {
+  if (size > max_record_size()) {
+    return false;
+  }
+
+  uint64_t head = header_->head.load(std::memory_order_relaxed);
+  size_t position = head & (capacity_ - 1);
+  size_t needed = header_size + align(size);
+  size_t contiguous = capacity_ - position;
+  size_t skip = (needed > contiguous) ? contiguous : 0;
+  uint64_t end = head + skip + needed;
+
+  uint64_t tail = header_->tail.load(std::memory_order_acquire);
+  while (end - tail > capacity_) {
+    if (!overwrite) {
+      header_->dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    // Claim the oldest record (or padding) so its space can be reused. The
+    // consumer may claim it first, in which case `tail` is reloaded.
+    uint32_t record[2];
+    size_t oldest = tail & (capacity_ - 1);
+    std::memcpy(record, buffer_ + oldest, sizeof(record));
+    bool is_padding = record[1] == padding;
+    uint64_t next = is_padding ? tail + (capacity_ - oldest)
+                               : tail + header_size + align(record[0]);
+    if (header_->tail.compare_exchange_weak(tail, next,
+                                            std::memory_order_acq_rel,
+                                            std::memory_order_acquire)) {
+      if (!is_padding) {
+        header_->dropped.fetch_add(1, std::memory_order_relaxed);
+      }
+      tail = next;
+    }
+  }
+
+  if (skip > 0) {
+    // Mark the end of the buffer as padding and start at the beginning
+    uint32_t marker[2] = {0, padding};
+    std::memcpy(buffer_ + position, marker, sizeof(marker));
+    position = 0;
+  }
+
+  uint32_t record[2] = {static_cast<uint32_t>(size), 0};
+  std::memcpy(buffer_ + position, record, sizeof(record));
+  if (size > 0) {
+    std::memcpy(buffer_ + position + header_size, data, size);
+  }
+  header_->head.store(end, std::memory_order_release);
+  return true;
+}
+
+bool ShmRing::pop(std::vector<uint8_t> &record) const {
+  uint64_t tail = header_->tail.load(std::memory_order_acquire);
+  while (true) {
+    if (tail == header_->head.load(std::memory_order_acquire)) {
+      return false;
+    }
+
+    size_t position = tail & (capacity_ - 1);
+    uint32_t header[2];
+    std::memcpy(header, buffer_ + position, sizeof(header));
+    bool is_padding = header[1] == padding;
+    uint64_t next;
+    if (is_padding) {
+      next = tail + (capacity_ - position);
+    } else {
+      if (header[0] > max_record_size() ||
+          position + header_size + header[0] > capacity_) {
+        // Overwritten while being read, the producer has moved the tail
+        tail = header_->tail.load(std::memory_order_acquire);
+        continue;
+      }
+      record.assign(buffer_ + position + header_size,
+                    buffer_ + position + header_size + header[0]);
+      next = tail + header_size + align(header[0]);
+    }
+
+    // Only keep the copy if the producer did not drop the record meanwhile.
+    // On failure `tail` is reloaded.
+    if (header_->tail.compare_exchange_strong(tail, next,
+                                              std::memory_order_acq_rel,
+                                              std::memory_order_acquire)) {
+      if (!is_padding) {
+        return true;
+      }
+      tail = next;
+    }
+  }
+}
+
+bool ShmRing::empty() const {
+  return header_->head.load(std::memory_order_acquire) ==
+         header_->tail.load(std::memory_order_acquire);
+}
+
+uint64_t ShmRing::dropped() const {
+  return header_->dropped.load(std::memory_order_relaxed);
+}
+
+bool ShmRing::arm() const {
+  // Pairs with the fence in `disarm`: either the producer sees the flag, or
+  // the consumer sees the record.
+  header_->waiting.store(1, std::memory_order_seq_cst);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!empty() || closed()) {
+    header_->waiting.store(0, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+bool ShmRing::disarm() const {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  return header_->waiting.load(std::memory_order_relaxed) != 0 &&
+         header_->waiting.exchange(0, std::memory_order_acq_rel) != 0;
+}
+
+void ShmRing::close() const {
+  header_->closed.store(1, std::memory_order_release);
+}
+
+bool ShmRing::closed() const {
+  return header_->closed.load(std::memory_order_acquire) != 0;
+}
+
+size_t ShmRing::capacity() const { return capacity_; }
+
+size_t ShmRing::max_record_size() const {
+  return capacity_ / 2 - header_size;
+}
+
+} // namespace ipc
+} // namespace rix
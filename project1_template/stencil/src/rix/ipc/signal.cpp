@@ -113,6 +113,12 @@ bool Signal::wait(const rix::util::Duration &d) const {
   return false;
 }
 
+int Signal::fd() const {
+  if (signum_ < 0 || signum_ >= 32 || !notifier[signum_].is_init)
+    return -1;
+  return notifier[signum_].pipe[0].fd();
+}
+
 /**
  * The async-signal-safe handler that writes to the pipe[cite: 75, 76].
  */
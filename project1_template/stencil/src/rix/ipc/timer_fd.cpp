@@ -0,0 +1,104 @@
+#include "rix/ipc/timer_fd.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+namespace rix {
+namespace ipc {
+
+namespace {
+
+struct timespec to_timespec(const util::Duration &d) {
+  int64_t ns = d.to_nanoseconds();
+  if (ns < 0) {
+    ns = 0;
+  }
+  struct timespec ts;
+  ts.tv_sec = ns / 1'000'000'000;
+  ts.tv_nsec = ns % 1'000'000'000;
+  return ts;
+}
+
+} // namespace
+
+TimerFd::TimerFd(bool nonblocking)
+    : File(::timerfd_create(CLOCK_MONOTONIC,
+                            TFD_CLOEXEC | (nonblocking ? TFD_NONBLOCK : 0))) {
+  if (fd_ == -1) {
+    perror("timerfd_create");
+  }
+}
+
+TimerFd::TimerFd(const TimerFd &src) : File(src) {}
+
+TimerFd &TimerFd::operator=(const TimerFd &src) {
+  if (this != &src) {
+    File::operator=(src);
+  }
+  return *this;
+}
+
+TimerFd::TimerFd(TimerFd &&src) : File(std::move(src)) {}
+
+TimerFd &TimerFd::operator=(TimerFd &&src) {
+  if (this != &src) {
+    File::operator=(std::move(src));
+  }
+  return *this;
+}
+
+TimerFd::~TimerFd() {
+  // File destructor handles close(fd_).
+}
+
+bool TimerFd::set(const util::Duration &initial,
+                  const util::Duration &interval) const {
+  struct itimerspec spec;
+  spec.it_value = to_timespec(initial);
+  spec.it_interval = to_timespec(interval);
+  // An all-zero it_value disarms the timer, so expire as soon as possible
+  // instead.
+  if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+    spec.it_value.tv_nsec = 1;
+  }
+  return ::timerfd_settime(fd_, 0, &spec, nullptr) == 0;
+}
+
+bool TimerFd::set_at(const util::SteadyTime &deadline) const {
+  // SteadyTime is on CLOCK_MONOTONIC, the clock of the timer. Past deadlines
+  // expire immediately, but an all-zero it_value would disarm the timer.
+  struct itimerspec spec = {};
+  int64_t ns = std::max<int64_t>(deadline.to_nanoseconds(), 1);
+  spec.it_value.tv_sec = ns / 1'000'000'000;
+  spec.it_value.tv_nsec = ns % 1'000'000'000;
+  return ::timerfd_settime(fd_, TFD_TIMER_ABSTIME, &spec, nullptr) == 0;
+}
+
+bool TimerFd::set_periodic(const util::Duration &period) const {
+  return set(period, period);
+}
+
+bool TimerFd::disarm() const {
+  struct itimerspec spec = {};
+  return ::timerfd_settime(fd_, 0, &spec, nullptr) == 0;
+}
+
+bool TimerFd::armed() const {
+  struct itimerspec spec;
+  if (::timerfd_gettime(fd_, &spec) != 0) {
+    return false;
+  }
+  return spec.it_value.tv_sec != 0 || spec.it_value.tv_nsec != 0;
+}
+
+uint64_t TimerFd::consume() const {
+  uint64_t expirations = 0;
+  if (::read(fd_, &expirations, sizeof(expirations)) !=
+      static_cast<ssize_t>(sizeof(expirations))) {
+    return 0;
+  }
+  return expirations;
+}
+
+} // namespace ipc
+} // namespace rix
@@ -0,0 +1,383 @@
+#include "rix/ipc/topic.hpp"
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "rix/ipc/poller.hpp"
+
+namespace rix {
+namespace ipc {
+
+namespace {
+
+constexpr uint32_t protocol_version = 1;
+constexpr uint64_t max_capacity = 1 << 30;
+
+// Sent by a subscriber right after connecting
+struct Request {
+  uint32_t version;
+  uint32_t policy;
+  uint64_t capacity;
+  uint64_t hash[2];
+};
+
+// Sent back by the writer, with the ring and eventfd on success
+struct Reply {
+  int32_t status;
+};
+
+bool valid_topic(const std::string &topic) {
+  return !topic.empty() && topic.find('/') == std::string::npos;
+}
+
+void wake(const File &wakeup) {
+  uint64_t one = 1;
+  wakeup.write(reinterpret_cast<const uint8_t *>(&one), sizeof(one));
+}
+
+} // namespace
+
+std::string topic_path(const std::string &topic) {
+  return "/tmp/rix_topic_" + topic;
+}
+
+struct TopicWriter::Subscription {
+  UnixSocket connection;
+  ShmRing ring;
+  File wakeup;
+  DropPolicy policy;
+};
+
+TopicWriter::TopicWriter(const std::string &topic,
+                         const std::array<uint64_t, 2> &hash)
+    : hash_(hash) {
+  if (!valid_topic(topic)) {
+    errno = EINVAL;
+    return;
+  }
+  std::string path = topic_path(topic);
+
+  // Fails with EADDRINUSE while another writer listens on the topic, and
+  // replaces the socket file of a writer that exited
+  listener_ = UnixSocket::listen(path, UnixSocket::Type::SEQPACKET);
+  if (!listener_.ok()) {
+    return;
+  }
+  stop_ = File(::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK));
+  if (!stop_.ok()) {
+    int error = errno;
+    listener_ = UnixSocket();
+    File::remove(path);
+    errno = error;
+    return;
+  }
+
+  path_ = path;
+  thread_ = std::thread([this] { accept_loop(); });
+}
+
+TopicWriter::~TopicWriter() {
+  if (thread_.joinable()) {
+    wake(stop_);
+    thread_.join();
+  }
+
+  std::lock_guard<std::mutex> guard(mutex_);
+  for (auto &subscription : subscriptions_) {
+    subscription->ring.close();
+    wake(subscription->wakeup);
+  }
+  subscriptions_.clear();
+  if (!path_.empty()) {
+    File::remove(path_);
+  }
+}
+
+bool TopicWriter::ok() const { return !path_.empty(); }
+
+ssize_t TopicWriter::write(const uint8_t *src, size_t size) const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  for (auto it = subscriptions_.begin(); it != subscriptions_.end();) {
+    Subscription &subscription = **it;
+    bool pushed = subscription.ring.push(
+        src, size, subscription.policy == DropPolicy::DROP_OLDEST);
+    if (!pushed && subscription.policy == DropPolicy::DISCONNECT) {
+      subscription.ring.close();
+      wake(subscription.wakeup);
+      it = subscriptions_.erase(it);
+      continue;
+    }
+    // Only a subscriber that caught up and is blocked needs a system call
+    if (subscription.ring.disarm()) {
+      wake(subscription.wakeup);
+    }
+    ++it;
+  }
+  return size;
+}
+
+ssize_t TopicWriter::read(uint8_t * /*dst*/, size_t /*size*/) const {
+  errno = EBADF;
+  return -1;
+}
+
+bool TopicWriter::wait_for_writable(
+    const rix::util::Duration & /*duration*/) const {
+  return ok();
+}
+
+bool TopicWriter::wait_for_readable(
+    const rix::util::Duration & /*duration*/) const {
+  return false;
+}
+
+// Publishing never blocks
+void TopicWriter::set_nonblocking(bool /*status*/) {}
+
+bool TopicWriter::is_nonblocking() const { return true; }
+
+size_t TopicWriter::subscribers() const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return subscriptions_.size();
+}
+
+void TopicWriter::accept_loop() {
+  // Accepted connections whose request has not arrived yet. Requests are read
+  // here once they arrive, so a slow client does not hold up the others.
+  std::vector<UnixSocket> handshakes;
+  while (true) {
+    Poller poller;
+    size_t stop_index = poller.add(stop_.fd());
+    size_t listener_index = poller.add(listener_.fd());
+    size_t handshake_index = poller.size();
+    for (const UnixSocket &connection : handshakes) {
+      poller.add(connection.fd());
+    }
+    size_t watched_index = poller.size();
+    std::vector<std::shared_ptr<Subscription>> watched;
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      for (auto &subscription : subscriptions_) {
+        poller.add(subscription->connection.fd());
+        watched.push_back(subscription);
+      }
+    }
+
+    if (poller.wait(rix::util::Duration::max()) < 0) {
+      return;
+    }
+    if (poller.ready(stop_index)) {
+      return;
+    }
+
+    // A readable handshake has its request, or was closed
+    for (size_t i = handshakes.size(); i-- > 0;) {
+      if (poller.ready(handshake_index + i)) {
+        add_subscriber(handshakes[i]);
+        handshakes.erase(handshakes.begin() + i);
+      }
+    }
+    if (poller.ready(listener_index)) {
+      UnixSocket connection = listener_.accept();
+      if (connection.ok()) {
+        handshakes.push_back(std::move(connection));
+      }
+    }
+
+    // Subscribers never write after the handshake, so a readable connection
+    // has been closed
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (size_t i = 0; i < watched.size(); i++) {
+      if (poller.ready(watched_index + i)) {
+        auto it = std::find(subscriptions_.begin(), subscriptions_.end(),
+                            watched[i]);
+        if (it != subscriptions_.end()) {
+          subscriptions_.erase(it);
+        }
+      }
+    }
+  }
+}
+
+void TopicWriter::add_subscriber(UnixSocket &connection) {
+  Request request;
+  if (connection.read(reinterpret_cast<uint8_t *>(&request),
+                      sizeof(request)) != sizeof(request)) {
+    return;
+  }
+
+  Reply reply{0};
+  auto subscription = std::make_shared<Subscription>();
+  if (request.version != protocol_version) {
+    reply.status = EPROTO;
+  } else if (request.hash[0] != hash_[0] || request.hash[1] != hash_[1]) {
+    reply.status = EPROTOTYPE;
+  } else if (request.capacity == 0 || request.capacity > max_capacity ||
+             request.policy > static_cast<uint32_t>(DropPolicy::DISCONNECT)) {
+    reply.status = EINVAL;
+  } else {
+    subscription->ring = ShmRing::create(request.capacity);
+    subscription->wakeup = File(::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK));
+    if (!subscription->ring.ok() || !subscription->wakeup.ok()) {
+      reply.status = errno;
+    }
+  }
+
+  const uint8_t *data = reinterpret_cast<const uint8_t *>(&reply);
+  if (reply.status != 0) {
+    connection.write(data, sizeof(reply));
+    return;
+  }
+
+  // Replying under the lock means every message published after the
+  // subscriber is created reaches it
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (connection.send_fds(data, sizeof(reply),
+                          {subscription->ring.memory().fd(),
+                           subscription->wakeup.fd()}) != sizeof(reply)) {
+    return;
+  }
+  subscription->connection = std::move(connection);
+  subscription->policy = static_cast<DropPolicy>(request.policy);
+  subscriptions_.push_back(std::move(subscription));
+}
+
+TopicReader::TopicReader(const std::string &topic,
+                         const std::array<uint64_t, 2> &hash, size_t capacity,
+                         DropPolicy policy)
+    : nonblocking_(false) {
+  if (!valid_topic(topic)) {
+    errno = EINVAL;
+    return;
+  }
+  UnixSocket connection =
+      UnixSocket::connect(topic_path(topic), UnixSocket::Type::SEQPACKET);
+  if (!connection.ok()) {
+    return;
+  }
+
+  Request request{protocol_version, static_cast<uint32_t>(policy), capacity,
+                  {hash[0], hash[1]}};
+  if (connection.write(reinterpret_cast<const uint8_t *>(&request),
+                       sizeof(request)) != sizeof(request)) {
+    return;
+  }
+
+  Reply reply;
+  std::vector<int> fds;
+  ssize_t bytes_read = connection.receive_fds(
+      reinterpret_cast<uint8_t *>(&reply), sizeof(reply), fds, 2);
+  if (bytes_read != sizeof(reply) || reply.status != 0 || fds.size() != 2) {
+    for (int fd : fds) {
+      ::close(fd);
+    }
+    errno = (bytes_read == sizeof(reply) && reply.status != 0) ? reply.status
+                                                               : EPROTO;
+    return;
+  }
+
+  ShmRing ring{SharedMemory(fds[0])};
+  File wakeup(fds[1]);
+  if (!ring.ok()) {
+    return;
+  }
+  connection_ = std::move(connection);
+  ring_ = std::move(ring);
+  wakeup_ = std::move(wakeup);
+
+  // Arm the ring right away, so `fd` is readable for the messages pushed
+  // before the first read, and wake ourselves for those already there
+  if (!ring_.arm()) {
+    wake(wakeup_);
+  }
+}
+
+bool TopicReader::ok() const { return ring_.ok(); }
+
+ssize_t TopicReader::read(uint8_t *dst, size_t size) const {
+  if (!ok()) {
+    errno = EBADF;
+    return -1;
+  }
+  while (!pop()) {
+    if (!connected()) {
+      // The last messages may have been pushed just before the writer left
+      if (!pop()) {
+        return 0;
+      }
+      break;
+    }
+    if (nonblocking_) {
+      errno = EAGAIN;
+      return -1;
+    }
+    wait_for_readable(rix::util::Duration::max());
+  }
+  size_t bytes = std::min(size, message_.size());
+  std::memcpy(dst, message_.data(), bytes);
+  return bytes;
+}
+
+ssize_t TopicReader::write(const uint8_t * /*src*/, size_t /*size*/) const {
+  errno = EBADF;
+  return -1;
+}
+
+bool TopicReader::wait_for_writable(
+    const rix::util::Duration & /*duration*/) const {
+  return false;
+}
+
+bool TopicReader::wait_for_readable(const rix::util::Duration &duration) const {
+  if (!ok()) {
+    return false;
+  }
+  if (!ring_.empty() || !connected()) {
+    return true;
+  }
+  if (ring_.arm() && !consume_wakeup()) {
+    Poller poller;
+    poller.add(wakeup_.fd());
+    poller.add(connection_.fd());
+    poller.wait(duration);
+  }
+  return !ring_.empty() || !connected();
+}
+
+void TopicReader::set_nonblocking(bool status) { nonblocking_ = status; }
+
+bool TopicReader::is_nonblocking() const { return nonblocking_; }
+
+int TopicReader::fd() const { return wakeup_.fd(); }
+
+bool TopicReader::connected() const {
+  // The connection is only readable once the writer has closed it
+  return ok() && !ring_.closed() &&
+         !connection_.wait_for_readable(rix::util::Duration());
+}
+
+uint64_t TopicReader::dropped() const { return ok() ? ring_.dropped() : 0; }
+
+bool TopicReader::pop() const {
+  if (ring_.pop(message_)) {
+    return true;
+  }
+  ring_.arm();
+  consume_wakeup();
+  return ring_.pop(message_);
+}
+
+bool TopicReader::consume_wakeup() const {
+  // Called after arming, so a message pushed meanwhile is either seen below
+  // or writes the eventfd again
+  uint64_t count;
+  wakeup_.read(reinterpret_cast<uint8_t *>(&count), sizeof(count));
+  return !ring_.empty();
+}
+
+} // namespace ipc
+} // namespace rix
@@ -0,0 +1,241 @@
+#include "rix/ipc/unix_socket.hpp"
+
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+namespace rix {
+namespace ipc {
+
+namespace {
+
+// Fills `address` with `path`. Fails with ENAMETOOLONG if it does not fit.
+bool make_address(const std::string &path, sockaddr_un &address) {
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    errno = ENAMETOOLONG;
+    return false;
+  }
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+  return true;
+}
+
+// Removes the socket file at `path` if the listener that created it is gone.
+// Fails with EADDRINUSE if `path` is not a socket or a listener still accepts
+// connections on it.
+bool remove_stale_socket(const std::string &path, const sockaddr_un &address,
+                         int type) {
+  struct stat info;
+  if (::lstat(path.c_str(), &info) != 0) {
+    return errno == ENOENT;
+  }
+  if (!S_ISSOCK(info.st_mode)) {
+    errno = EADDRINUSE;
+    return false;
+  }
+
+  // Only a socket without a listener refuses connections. Non-blocking, so
+  // a listener with a full backlog does not block the probe.
+  int probe = ::socket(AF_UNIX, type | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+  if (probe < 0) {
+    return false;
+  }
+  int result;
+  do {
+    result = ::connect(probe, reinterpret_cast<const sockaddr *>(&address),
+                       sizeof(address));
+  } while (result != 0 && errno == EINTR);
+  int error = errno;
+  ::close(probe);
+  if (result == 0 || error != ECONNREFUSED) {
+    errno = EADDRINUSE;
+    return false;
+  }
+  return ::unlink(path.c_str()) == 0 || errno == ENOENT;
+}
+
+} // namespace
+
+std::array<UnixSocket, 2> UnixSocket::pair(Type type) {
+  int fds[2];
+  if (::socketpair(AF_UNIX, static_cast<int>(type) | SOCK_CLOEXEC, 0, fds) !=
+      0) {
+    return {};
+  }
+  return {UnixSocket(fds[0], type), UnixSocket(fds[1], type)};
+}
+
+UnixSocket UnixSocket::listen(const std::string &path, Type type,
+                              int backlog) {
+  sockaddr_un address;
+  if (!make_address(path, address)) {
+    return {};
+  }
+  UnixSocket socket(
+      ::socket(AF_UNIX, static_cast<int>(type) | SOCK_CLOEXEC, 0), type);
+  if (!socket.ok()) {
+    return {};
+  }
+
+  // A socket file is not removed when its listener exits
+  if (!remove_stale_socket(path, address, static_cast<int>(type))) {
+    return {};
+  }
+  if (::bind(socket.fd_, reinterpret_cast<sockaddr *>(&address),
+             sizeof(address)) != 0 ||
+      ::listen(socket.fd_, backlog) != 0) {
+    return {};
+  }
+  return socket;
+}
+
+UnixSocket UnixSocket::connect(const std::string &path, Type type) {
+  sockaddr_un address;
+  if (!make_address(path, address)) {
+    return {};
+  }
+  UnixSocket socket(
+      ::socket(AF_UNIX, static_cast<int>(type) | SOCK_CLOEXEC, 0), type);
+  if (!socket.ok()) {
+    return {};
+  }
+  int result;
+  do {
+    result = ::connect(socket.fd_, reinterpret_cast<sockaddr *>(&address),
+                       sizeof(address));
+  } while (result != 0 && errno == EINTR);
+  if (result != 0) {
+    return {};
+  }
+  return socket;
+}
+
+UnixSocket::UnixSocket() : File(), type_(Type::STREAM) {}
+
+UnixSocket::UnixSocket(const UnixSocket &other)
+    : File(other), type_(other.type_) {}
+
+UnixSocket &UnixSocket::operator=(const UnixSocket &other) {
+  if (this != &other) {
+    File::operator=(other);
+    type_ = other.type_;
+  }
+  return *this;
+}
+
+UnixSocket::UnixSocket(UnixSocket &&other)
+    : File(std::move(other)), type_(other.type_) {}
+
+UnixSocket &UnixSocket::operator=(UnixSocket &&other) {
+  if (this != &other) {
+    File::operator=(std::move(other));
+    type_ = other.type_;
+  }
+  return *this;
+}
+
+UnixSocket::~UnixSocket() {}
+
+UnixSocket UnixSocket::accept() const {
+  int fd;
+  do {
+    fd = ::accept4(fd_, nullptr, nullptr, SOCK_CLOEXEC);
+  } while (fd < 0 && errno == EINTR);
+  if (fd < 0) {
+    return {};
+  }
+  return UnixSocket(fd, type_);
+}
+
+ssize_t UnixSocket::write(const uint8_t *src, size_t size) const {
+  return ::send(fd_, src, size, MSG_NOSIGNAL);
+}
+
+ssize_t UnixSocket::send_fds(const uint8_t *src, size_t size,
+                             const std::vector<int> &fds) const {
+  iovec iov{const_cast<uint8_t *>(src), size};
+  msghdr message{};
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+
+  std::vector<uint8_t> control;
+  if (!fds.empty()) {
+    size_t fds_size = fds.size() * sizeof(int);
+    control.resize(CMSG_SPACE(fds_size));
+    message.msg_control = control.data();
+    message.msg_controllen = control.size();
+    cmsghdr *header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(fds_size);
+    std::memcpy(CMSG_DATA(header), fds.data(), fds_size);
+  }
+  return ::sendmsg(fd_, &message, MSG_NOSIGNAL);
+}
+
+ssize_t UnixSocket::receive_fds(uint8_t *dst, size_t size,
+                                std::vector<int> &fds, size_t max_fds) const {
+  fds.clear();
+  iovec iov{dst, size};
+  msghdr message{};
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+
+  std::vector<uint8_t> control(CMSG_SPACE(max_fds * sizeof(int)));
+  message.msg_control = control.data();
+  message.msg_controllen = control.size();
+  ssize_t bytes_read = ::recvmsg(fd_, &message, MSG_CMSG_CLOEXEC);
+  if (bytes_read < 0) {
+    return bytes_read;
+  }
+
+  for (cmsghdr *header = CMSG_FIRSTHDR(&message); header != nullptr;
+       header = CMSG_NXTHDR(&message, header)) {
+    if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS) {
+      continue;
+    }
+    size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    size_t offset = fds.size();
+    fds.resize(offset + count);
+    std::memcpy(fds.data() + offset, CMSG_DATA(header), count * sizeof(int));
+  }
+  return bytes_read;
+}
+
+bool UnixSocket::set_send_buffer_size(int size) {
+  return ::setsockopt(fd_, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size)) == 0;
+}
+
+bool UnixSocket::set_receive_buffer_size(int size) {
+  return ::setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size)) == 0;
+}
+
+int UnixSocket::send_buffer_size() const {
+  int size;
+  socklen_t length = sizeof(size);
+  if (::getsockopt(fd_, SOL_SOCKET, SO_SNDBUF, &size, &length) != 0) {
+    return -1;
+  }
+  return size;
+}
+
+int UnixSocket::receive_buffer_size() const {
+  int size;
+  socklen_t length = sizeof(size);
+  if (::getsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &size, &length) != 0) {
+    return -1;
+  }
+  return size;
+}
+
+UnixSocket::Type UnixSocket::type() const { return type_; }
+
+UnixSocket::UnixSocket(int fd, Type type) : File(fd), type_(type) {}
+
+} // namespace ipc
+} // namespace rix
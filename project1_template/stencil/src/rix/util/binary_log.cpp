@@ -0,0 +1,416 @@
+#include "rix/util/binary_log.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace rix {
+namespace util {
+
+namespace {
+
+constexpr char magic[8] = {'R', 'I', 'X', 'B', 'L', 'O', 'G', '1'};
+constexpr uint32_t site_entry = 0;
+
+// Entries larger than this are treated as a corrupted size
+constexpr uint32_t max_entry_size = 1 << 24;
+
+// Buffers of written records kept for reuse
+constexpr size_t max_free_buffers = 4;
+
+struct Site {
+    std::string file;
+    int32_t line;
+    int32_t level;
+    std::string format;
+    std::string types;
+};
+
+std::mutex mutex;
+int fd = -1;
+std::vector<uint8_t> buffer;
+std::vector<Site> sites;
+
+// Full buffers are written by a background thread, so logging never waits on
+// the disk
+std::condition_variable pending_cv;  // Signals the background thread
+std::condition_variable done_cv;     // Signals `flush`
+std::deque<std::vector<uint8_t>> pending;
+std::vector<std::vector<uint8_t>> free_buffers;
+std::thread writer;
+bool busy = false;      // The background thread is writing a buffer
+bool stopping = false;  // The background thread exits once `pending` is empty
+int write_error = 0;    // errno of the first failed write
+
+template <typename T>
+void append(std::vector<uint8_t> &out, const T &value) {
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(value));
+}
+
+void append_string(std::vector<uint8_t> &out, const std::string &value) {
+    append(out, static_cast<uint32_t>(value.size()));
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+void append_site(uint32_t id, const Site &site) {
+    uint32_t size = 3 * sizeof(int32_t) + 3 * sizeof(uint32_t) + site.file.size() + site.format.size() +
+                    site.types.size();
+    append(buffer, site_entry);
+    append(buffer, size);
+    append(buffer, id);
+    append(buffer, site.line);
+    append(buffer, site.level);
+    append_string(buffer, site.file);
+    append_string(buffer, site.format);
+    append_string(buffer, site.types);
+}
+
+bool write_all(int out, const std::vector<uint8_t> &data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = ::write(out, data.data() + written, data.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        written += n;
+    }
+    return true;
+}
+
+// Hands the buffer to the background thread. Unless `force` is set, fails if
+// `BinaryLog::max_pending` buffers are waiting already.
+bool seal(bool force) {
+    if (buffer.empty()) {
+        return true;
+    }
+    if (!force && pending.size() >= BinaryLog::max_pending) {
+        return false;
+    }
+    pending.push_back(std::move(buffer));
+    buffer = {};
+    if (!free_buffers.empty()) {
+        buffer = std::move(free_buffers.back());
+        free_buffers.pop_back();
+    } else {
+        buffer.reserve(BinaryLog::buffer_size + 4096);
+    }
+    pending_cv.notify_one();
+    return true;
+}
+
+void write_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        pending_cv.wait(lock, [] { return !pending.empty() || stopping; });
+        if (pending.empty()) {
+            break;
+        }
+
+        std::vector<uint8_t> data = std::move(pending.front());
+        pending.pop_front();
+        // After a failed write the end of the file is unknown, so later
+        // buffers are not written either
+        bool skip = write_error != 0;
+        busy = true;
+        lock.unlock();
+        bool ok = skip || write_all(fd, data);
+        int error = errno;
+        lock.lock();
+        busy = false;
+        if (!ok && write_error == 0) {
+            write_error = error;
+        }
+        if (free_buffers.size() < max_free_buffers) {
+            data.clear();
+            free_buffers.push_back(std::move(data));
+        }
+        done_cv.notify_all();
+    }
+}
+
+// Writes the buffered records, stops the background thread and closes the
+// file. `lock` holds `mutex` and is released while the thread finishes.
+bool close_file(std::unique_lock<std::mutex> &lock) {
+    // Another thread may be closing the file already
+    done_cv.wait(lock, [] { return !stopping; });
+    if (fd < 0) {
+        return true;
+    }
+    seal(true);
+    stopping = true;
+    pending_cv.notify_one();
+    lock.unlock();
+    writer.join();
+    lock.lock();
+    stopping = false;
+    done_cv.notify_all();
+
+    bool ok = write_error == 0;
+    int error = write_error;
+    if (::close(fd) < 0 && ok) {
+        ok = false;
+        error = errno;
+    }
+    fd = -1;
+    write_error = 0;
+    if (!ok) {
+        errno = error;
+    }
+    return ok;
+}
+
+// Closes a log left open, so the background thread is not destroyed while
+// it runs
+void close_at_exit() { BinaryLog::close(); }
+
+// Reads exactly `size` bytes, returns false at the end of the stream
+bool read_exact(std::istream &is, void *data, size_t size) {
+    is.read(static_cast<char *>(data), size);
+    return static_cast<size_t>(is.gcount()) == size;
+}
+
+template <typename T>
+bool read_value(const std::vector<uint8_t> &payload, size_t &offset, T &value) {
+    if (payload.size() - offset < sizeof(value)) {
+        return false;
+    }
+    std::memcpy(&value, payload.data() + offset, sizeof(value));
+    offset += sizeof(value);
+    return true;
+}
+
+bool read_string(const std::vector<uint8_t> &payload, size_t &offset, std::string &value) {
+    uint32_t size;
+    if (!read_value(payload, offset, size) || payload.size() - offset < size) {
+        return false;
+    }
+    value.assign(reinterpret_cast<const char *>(payload.data() + offset), size);
+    offset += size;
+    return true;
+}
+
+// Writes the argument of type `type` at `offset` in the payload
+bool format_argument(const std::vector<uint8_t> &payload, size_t &offset, char type, std::ostream &os) {
+    switch (type) {
+        case 'b':
+        case 'c': {
+            uint8_t v;
+            if (!read_value(payload, offset, v)) {
+                return false;
+            }
+            if (type == 'b') {
+                os << (v ? "true" : "false");
+            } else {
+                os << static_cast<char>(v);
+            }
+            return true;
+        }
+        case 'i': {
+            int64_t v;
+            if (!read_value(payload, offset, v)) {
+                return false;
+            }
+            os << v;
+            return true;
+        }
+        case 'u': {
+            uint64_t v;
+            if (!read_value(payload, offset, v)) {
+                return false;
+            }
+            os << v;
+            return true;
+        }
+        case 'd': {
+            double v;
+            if (!read_value(payload, offset, v)) {
+                return false;
+            }
+            os << v;
+            return true;
+        }
+        case 's': {
+            std::string v;
+            if (!read_string(payload, offset, v)) {
+                return false;
+            }
+            os << v;
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+const char *level_string(int32_t level) {
+    static const char *levels[] = {"DEBUG", "INFO", "WARN", "ERROR", "FATAL"};
+    return (level >= 0 && level <= Log::FATAL) ? levels[level] : "UNKNOWN";
+}
+
+const char *file_name(const std::string &path) {
+    size_t slash = path.rfind('/');
+    return path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+}
+
+}  // namespace
+
+bool BinaryLog::open(const std::string &path) {
+    std::unique_lock<std::mutex> lock(mutex);
+    open_.store(false, std::memory_order_release);
+    if (!close_file(lock)) {
+        return false;
+    }
+
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    static bool registered = (std::atexit(close_at_exit), true);
+    (void)registered;
+
+    // Sites registered while a previous file was open are described again
+    buffer.clear();
+    buffer.reserve(buffer_size + 4096);
+    buffer.insert(buffer.end(), magic, magic + sizeof(magic));
+    for (size_t i = 0; i < sites.size(); i++) {
+        append_site(static_cast<uint32_t>(i + 1), sites[i]);
+    }
+    dropped_.store(0, std::memory_order_relaxed);
+    writer = std::thread(write_loop);
+    open_.store(true, std::memory_order_release);
+    return true;
+}
+
+bool BinaryLog::close() {
+    std::unique_lock<std::mutex> lock(mutex);
+    open_.store(false, std::memory_order_release);
+    return close_file(lock);
+}
+
+bool BinaryLog::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (fd < 0) {
+        return true;
+    }
+    seal(true);
+    done_cv.wait(lock, [] { return pending.empty() && !busy; });
+    if (write_error != 0) {
+        errno = write_error;
+        return false;
+    }
+    return true;
+}
+
+uint32_t BinaryLog::register_site(const char *file, int line, Log::Level level, const char *format,
+                                  const char *types) {
+    std::lock_guard<std::mutex> guard(mutex);
+    sites.push_back(Site{file, line, level, format, types});
+    uint32_t id = static_cast<uint32_t>(sites.size());
+    if (fd >= 0) {
+        append_site(id, sites.back());
+    }
+    return id;
+}
+
+void BinaryLog::write(uint32_t site, int64_t stamp, const uint8_t *data, size_t size) {
+    std::lock_guard<std::mutex> guard(mutex);
+    if (fd < 0 || stopping) {
+        return;
+    }
+    if (buffer.size() >= buffer_size && !seal(false)) {
+        // The disk is too slow. Dropping the record keeps the caller from
+        // blocking and the memory bounded; site descriptors are never dropped.
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    append(buffer, site);
+    append(buffer, static_cast<uint32_t>(sizeof(stamp) + size));
+    append(buffer, stamp);
+    buffer.insert(buffer.end(), data, data + size);
+    if (buffer.size() >= buffer_size) {
+        seal(false);
+    }
+}
+
+bool BinaryLog::decode(std::istream &is, std::ostream &os, bool local_time) {
+    char header[sizeof(magic)];
+    if (!read_exact(is, header, sizeof(header)) || std::memcmp(header, magic, sizeof(magic)) != 0) {
+        return false;
+    }
+
+    std::vector<Site> decoded;
+    std::vector<uint8_t> payload;
+    char stamp_text[Time::format_size];
+    while (true) {
+        uint32_t entry[2];
+        if (!read_exact(is, entry, sizeof(entry))) {
+            return true;
+        }
+        if (entry[1] > max_entry_size) {
+            return false;
+        }
+        payload.resize(entry[1]);
+        if (!read_exact(is, payload.data(), payload.size())) {
+            return true;
+        }
+
+        size_t offset = 0;
+        if (entry[0] == site_entry) {
+            uint32_t id;
+            Site site;
+            if (!read_value(payload, offset, id) || !read_value(payload, offset, site.line) ||
+                !read_value(payload, offset, site.level) || !read_string(payload, offset, site.file) ||
+                !read_string(payload, offset, site.format) || !read_string(payload, offset, site.types) || id == 0) {
+                return false;
+            }
+            if (decoded.size() < id) {
+                decoded.resize(id);
+            }
+            decoded[id - 1] = std::move(site);
+            continue;
+        }
+
+        int64_t stamp;
+        if (entry[0] > decoded.size() || !read_value(payload, offset, stamp)) {
+            return false;
+        }
+        const Site &site = decoded[entry[0] - 1];
+        Time(Time::Type(std::chrono::nanoseconds(stamp))).format(stamp_text, sizeof(stamp_text), local_time);
+        os << "[" << stamp_text << "] [" << level_string(site.level) << "] " << file_name(site.file) << ":"
+           << site.line << ": ";
+
+        // Substitute the arguments for the `{}` placeholders in order. Extra
+        // arguments are appended.
+        size_t arg = 0;
+        const std::string &format = site.format;
+        for (size_t i = 0; i < format.size(); i++) {
+            if (format[i] == '{' && i + 1 < format.size() && format[i + 1] == '}' && arg < site.types.size()) {
+                if (!format_argument(payload, offset, site.types[arg++], os)) {
+                    return false;
+                }
+                i++;
+            } else {
+                os << format[i];
+            }
+        }
+        for (; arg < site.types.size(); arg++) {
+            os << " ";
+            if (!format_argument(payload, offset, site.types[arg], os)) {
+                return false;
+            }
+        }
+        os << "\n";
+    }
+}
+
+}  // namespace util
+}  // namespace rix
@@ -0,0 +1,92 @@
+#include "rix/util/fast_clock.hpp"
+
+#if RIX_UTIL_FAST_CLOCK_TSC
+#include <cpuid.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+namespace rix {
+namespace util {
+
+namespace {
+
+// Length of the calibration window. Longer windows reduce the error of the
+// calibrated frequency; 10 ms gives an error well below 0.01%.
+constexpr int64_t calibration_window_ns = 10'000'000;
+
+}  // namespace
+
+bool FastClock::invariant_tsc() {
+#if RIX_UTIL_FAST_CLOCK_TSC
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007) {
+        return false;
+    }
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return (edx & (1u << 8)) != 0;
+#else
+    return false;
+#endif
+}
+
+FastClock::Calibration FastClock::calibrate() {
+    Calibration c{false, uint64_t(1) << 32, 0, 0};
+#if RIX_UTIL_FAST_CLOCK_TSC
+    if (invariant_tsc()) {
+        // Take the TSC reading that is closest to each clock_gettime call by
+        // bracketing the call and keeping the tightest of a few attempts.
+        auto sample = [](Ticks &ticks, int64_t &ns) {
+            Ticks best = ~Ticks(0);
+            for (int i = 0; i < 5; i++) {
+                Ticks before = __rdtsc();
+                int64_t t = static_cast<int64_t>(monotonic_ns());
+                Ticks after = __rdtsc();
+                if (after - before < best) {
+                    best = after - before;
+                    ticks = before + (after - before) / 2;
+                    ns = t;
+                }
+            }
+        };
+
+        Ticks start_ticks, end_ticks;
+        int64_t start_ns, end_ns;
+        sample(start_ticks, start_ns);
+        sleep_for(Duration(Duration::Type(calibration_window_ns)));
+        sample(end_ticks, end_ns);
+
+        if (end_ticks > start_ticks && end_ns > start_ns) {
+            double ns_per_tick = static_cast<double>(end_ns - start_ns) / static_cast<double>(end_ticks - start_ticks);
+            c.tsc = true;
+            c.mult = static_cast<uint64_t>(std::llround(ns_per_tick * 4294967296.0));
+            c.base_ticks = end_ticks;
+            c.base_ns = end_ns;
+        }
+    }
+#endif
+    return c;
+}
+
+SteadyTime FastClock::to_steady_time(Ticks ticks) {
+    const Calibration &c = calibration();
+    int64_t ns;
+    if (!c.tsc) {
+        ns = static_cast<int64_t>(ticks);
+    } else if (ticks >= c.base_ticks) {
+        ns = c.base_ns + to_nanoseconds(ticks - c.base_ticks);
+    } else {
+        ns = c.base_ns - to_nanoseconds(c.base_ticks - ticks);
+    }
+    return SteadyTime(SteadyTime::Type(std::chrono::nanoseconds(ns)));
+}
+
+bool FastClock::uses_tsc() { return calibration().tsc; }
+
+double FastClock::frequency() { return 1e9 * 4294967296.0 / static_cast<double>(calibration().mult); }
+
+}  // namespace util
+}  // namespace rix
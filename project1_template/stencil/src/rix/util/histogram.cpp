@@ -0,0 +1,119 @@
+#include "rix/util/histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "rix/util/time.hpp"
+
+namespace rix {
+namespace util {
+
+Histogram::Histogram()
+    : counts_(index_of(std::numeric_limits<int64_t>::max()) + 1, 0),
+      total_(0),
+      min_(std::numeric_limits<int64_t>::max()),
+      max_(0),
+      sum_(0.0) {}
+
+Histogram::Histogram(const Histogram &other)
+    : counts_(other.counts_), total_(other.total_), min_(other.min_), max_(other.max_), sum_(other.sum_) {}
+
+Histogram &Histogram::operator=(const Histogram &other) {
+    if (this == &other) {
+        return *this;
+    }
+    Histogram tmp(other);
+    std::swap(counts_, tmp.counts_);
+    std::swap(total_, tmp.total_);
+    std::swap(min_, tmp.min_);
+    std::swap(max_, tmp.max_);
+    std::swap(sum_, tmp.sum_);
+    return *this;
+}
+
+size_t Histogram::index_of(int64_t value) {
+    if (value < sub_bucket_count) {
+        return static_cast<size_t>(value);
+    }
+    // Keep the top sub_bucket_bits + 1 bits of the value. The leading bit
+    // selects the power of two and the remaining bits the sub-bucket.
+    int shift = (63 - __builtin_clzll(static_cast<uint64_t>(value))) - sub_bucket_bits;
+    int64_t mantissa = value >> shift;
+    return static_cast<size_t>((shift + 1) * sub_bucket_count + (mantissa - sub_bucket_count));
+}
+
+int64_t Histogram::highest_value_of(size_t index) {
+    if (index < static_cast<size_t>(sub_bucket_count)) {
+        return static_cast<int64_t>(index);
+    }
+    int shift = static_cast<int>(index / sub_bucket_count) - 1;
+    uint64_t mantissa = index % sub_bucket_count + sub_bucket_count;
+    return static_cast<int64_t>(((mantissa + 1) << shift) - 1);
+}
+
+void Histogram::record(int64_t value, uint64_t count) {
+    if (count == 0) {
+        return;
+    }
+    if (value < 0) {
+        value = 0;
+    }
+    counts_[index_of(value)] += count;
+    total_ += count;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+    sum_ += static_cast<double>(value) * count;
+}
+
+void Histogram::record(const Duration &duration) { record(duration.to_nanoseconds()); }
+
+void Histogram::merge(const Histogram &other) {
+    if (other.total_ == 0) {
+        return;
+    }
+    for (size_t i = 0; i < counts_.size(); i++) {
+        counts_[i] += other.counts_[i];
+    }
+    total_ += other.total_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    sum_ += other.sum_;
+}
+
+void Histogram::reset() {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    total_ = 0;
+    min_ = std::numeric_limits<int64_t>::max();
+    max_ = 0;
+    sum_ = 0.0;
+}
+
+uint64_t Histogram::count() const { return total_; }
+
+int64_t Histogram::min() const { return total_ == 0 ? 0 : min_; }
+
+int64_t Histogram::max() const { return max_; }
+
+double Histogram::mean() const { return total_ == 0 ? 0.0 : sum_ / total_; }
+
+int64_t Histogram::percentile(double percentile) const {
+    if (total_ == 0) {
+        return 0;
+    }
+    percentile = std::clamp(percentile, 0.0, 100.0);
+    uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * total_));
+    rank = std::max<uint64_t>(rank, 1);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts_.size(); i++) {
+        seen += counts_[i];
+        if (seen >= rank) {
+            return std::clamp(highest_value_of(i), min_, max_);
+        }
+    }
+    return max_;
+}
+
+}  // namespace util
+}  // namespace rix
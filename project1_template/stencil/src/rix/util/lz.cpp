@@ -0,0 +1,204 @@
+#include "rix/util/lz.hpp"
+
+#include <bit>
+#include <cstring>
+
+namespace rix {
+namespace util {
+namespace lz {
+
+namespace {
+
+// Constraints of the LZ4 block format
+constexpr size_t min_match = 4;
+constexpr size_t last_literals = 5;  // The block ends with at least 5 literals
+constexpr size_t match_limit = 12;   // No match starts in the last 12 bytes
+constexpr size_t max_offset = 65535;
+
+constexpr int hash_bits = 12;
+
+uint32_t read32(const uint8_t *p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint64_t read64(const uint8_t *p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// Returns the length of the common prefix of `a` and `b`, up to `limit`
+size_t common_length(const uint8_t *a, const uint8_t *b, size_t limit) {
+    size_t length = 0;
+    while (length + 8 <= limit) {
+        uint64_t diff = read64(a + length) ^ read64(b + length);
+        if (diff != 0) {
+            // The first differing byte is the lowest one on little-endian
+            // machines, the highest one on big-endian ones
+            if constexpr (std::endian::native == std::endian::little) {
+                return length + (std::countr_zero(diff) >> 3);
+            } else {
+                return length + (std::countl_zero(diff) >> 3);
+            }
+        }
+        length += 8;
+    }
+    while (length < limit && a[length] == b[length]) {
+        length++;
+    }
+    return length;
+}
+
+uint32_t hash(uint32_t sequence) { return (sequence * 2654435761u) >> (32 - hash_bits); }
+
+// Writes the part of a length that does not fit in the token
+uint8_t *write_length(uint8_t *op, size_t length) {
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = static_cast<uint8_t>(length);
+    return op;
+}
+
+uint8_t *write_literals(uint8_t *op, uint8_t *token, const uint8_t *literals, size_t length) {
+    if (length >= 15) {
+        *token = 15 << 4;
+        op = write_length(op, length - 15);
+    } else {
+        *token = static_cast<uint8_t>(length << 4);
+    }
+    std::memcpy(op, literals, length);
+    return op + length;
+}
+
+// Reads the part of a length that does not fit in the token
+bool read_length(const uint8_t *&ip, const uint8_t *end, size_t &length) {
+    uint8_t byte;
+    do {
+        if (ip == end) {
+            return false;
+        }
+        byte = *ip++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+}  // namespace
+
+size_t compress_bound(size_t size) { return size + size / 255 + 16; }
+
+size_t compress(const uint8_t *src, size_t size, uint8_t *dst) {
+    uint8_t *op = dst;
+    size_t anchor = 0;
+
+    if (size > match_limit) {
+        uint32_t table[1 << hash_bits] = {};
+        size_t limit = size - match_limit;
+        size_t match_end = size - last_literals;
+        size_t ip = 1;
+        while (ip < limit) {
+            uint32_t sequence = read32(src + ip);
+            uint32_t h = hash(sequence);
+            size_t ref = table[h];
+            table[h] = static_cast<uint32_t>(ip);
+            if (ref >= ip || ip - ref > max_offset || read32(src + ref) != sequence) {
+                // Skip faster through data that does not compress
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+
+            // Extend the match backwards over pending literals, then forwards
+            while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+                ip--;
+                ref--;
+            }
+            size_t length =
+                min_match + common_length(src + ip + min_match, src + ref + min_match, match_end - ip - min_match);
+
+            uint8_t *token = op++;
+            op = write_literals(op, token, src + anchor, ip - anchor);
+            size_t offset = ip - ref;
+            *op++ = static_cast<uint8_t>(offset);
+            *op++ = static_cast<uint8_t>(offset >> 8);
+            if (length - min_match >= 15) {
+                *token |= 15;
+                op = write_length(op, length - min_match - 15);
+            } else {
+                *token |= static_cast<uint8_t>(length - min_match);
+            }
+
+            ip += length;
+            anchor = ip;
+            if (ip < limit) {
+                // Index a position inside the match, so repeats of it are found
+                table[hash(read32(src + ip - 2))] = static_cast<uint32_t>(ip - 2);
+            }
+        }
+    }
+
+    uint8_t *token = op++;
+    op = write_literals(op, token, src + anchor, size - anchor);
+    return op - dst;
+}
+
+bool decompress(const uint8_t *src, size_t size, uint8_t *dst, size_t raw_size) {
+    const uint8_t *ip = src;
+    const uint8_t *end = src + size;
+    uint8_t *op = dst;
+    uint8_t *op_end = dst + raw_size;
+
+    while (ip < end) {
+        uint8_t token = *ip++;
+
+        size_t literals = token >> 4;
+        if (literals == 15 && !read_length(ip, end, literals)) {
+            return false;
+        }
+        if (literals > static_cast<size_t>(end - ip) || literals > static_cast<size_t>(op_end - op)) {
+            return false;
+        }
+        std::memcpy(op, ip, literals);
+        ip += literals;
+        op += literals;
+        if (ip == end) {
+            // The last sequence has no match
+            break;
+        }
+
+        if (end - ip < 2) {
+            return false;
+        }
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - dst)) {
+            return false;
+        }
+        size_t length = token & 15;
+        if (length == 15 && !read_length(ip, end, length)) {
+            return false;
+        }
+        length += min_match;
+        if (length > static_cast<size_t>(op_end - op)) {
+            return false;
+        }
+        const uint8_t *match = op - offset;
+        if (offset >= length) {
+            std::memcpy(op, match, length);
+            op += length;
+        } else {
+            // The match overlaps the output, it repeats the last `offset` bytes
+            for (size_t i = 0; i < length; i++) {
+                *op++ = match[i];
+            }
+        }
+    }
+    return op == op_end;
+}
+
+}  // namespace lz
+}  // namespace util
+}  // namespace rix
@@ -0,0 +1,47 @@
+#include "rix/util/realtime.hpp"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+namespace rix {
+namespace util {
+
+bool set_realtime_priority(int priority) {
+    int min = sched_get_priority_min(SCHED_FIFO);
+    int max = sched_get_priority_max(SCHED_FIFO);
+    if (priority < min || priority > max) {
+        errno = EINVAL;
+        return false;
+    }
+    sched_param param{};
+    param.sched_priority = priority;
+    int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (err != 0) {
+        errno = err;
+        return false;
+    }
+    return true;
+}
+
+bool pin_to_cpu(int cpu) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        errno = EINVAL;
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (err != 0) {
+        errno = err;
+        return false;
+    }
+    return true;
+}
+
+bool lock_memory() { return mlockall(MCL_CURRENT | MCL_FUTURE) == 0; }
+
+}  // namespace util
+}  // namespace rix
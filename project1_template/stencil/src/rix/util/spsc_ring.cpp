@@ -0,0 +1,111 @@
+#include "rix/util/spsc_ring.hpp"
+
+#include <cstring>
+
+namespace rix {
+namespace util {
+
+namespace {
+
+size_t round_up_pow2(size_t value) {
+    size_t result = 64;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+}  // namespace
+
+SpscRing::SpscRing(size_t capacity)
+    : buffer_(round_up_pow2(capacity)),
+      mask_(buffer_.size() - 1),
+      head_(0),
+      cached_tail_(0),
+      tail_(0),
+      cached_head_(0),
+      front_size_(0) {}
+
+bool SpscRing::push(const void *data, size_t size) { return push(data, size, nullptr, 0); }
+
+bool SpscRing::push(const void *first, size_t first_size, const void *second, size_t second_size) {
+    size_t size = first_size + second_size;
+    if (size > max_record_size()) {
+        return false;
+    }
+
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    size_t position = head & mask_;
+    size_t needed = header_size + align(size);
+    size_t contiguous = buffer_.size() - position;
+    size_t skip = (needed > contiguous) ? contiguous : 0;
+
+    if (head + skip + needed - cached_tail_ > buffer_.size()) {
+        cached_tail_ = tail_.load(std::memory_order_acquire);
+        if (head + skip + needed - cached_tail_ > buffer_.size()) {
+            return false;
+        }
+    }
+
+    if (skip > 0) {
+        // Mark the end of the buffer as padding and start at the beginning
+        uint32_t marker[2] = {0, padding};
+        std::memcpy(&buffer_[position], marker, sizeof(marker));
+        position = 0;
+    }
+
+    uint32_t header[2] = {static_cast<uint32_t>(size), 0};
+    std::memcpy(&buffer_[position], header, sizeof(header));
+    if (first_size > 0) {
+        std::memcpy(&buffer_[position + header_size], first, first_size);
+    }
+    if (second_size > 0) {
+        std::memcpy(&buffer_[position + header_size + first_size], second, second_size);
+    }
+
+    head_.store(head + skip + needed, std::memory_order_release);
+    return true;
+}
+
+bool SpscRing::front(const uint8_t *&data, size_t &size) {
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    while (true) {
+        if (tail == cached_head_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail == cached_head_) {
+                return false;
+            }
+        }
+
+        size_t position = tail & mask_;
+        uint32_t header[2];
+        std::memcpy(header, &buffer_[position], sizeof(header));
+        if (header[1] == padding) {
+            // Skip to the beginning of the buffer
+            tail += buffer_.size() - position;
+            tail_.store(tail, std::memory_order_release);
+            continue;
+        }
+
+        data = &buffer_[position + header_size];
+        size = header[0];
+        front_size_ = size;
+        return true;
+    }
+}
+
+void SpscRing::pop() {
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    tail_.store(tail + header_size + align(front_size_), std::memory_order_release);
+}
+
+bool SpscRing::empty() const {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+}
+
+size_t SpscRing::capacity() const { return buffer_.size(); }
+
+size_t SpscRing::max_record_size() const { return buffer_.size() / 2 - header_size; }
+
+}  // namespace util
+}  // namespace rix
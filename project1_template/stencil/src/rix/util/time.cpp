@@ -1,37 +1,95 @@
 #include "rix/util/time.hpp"
 
+#include <errno.h>
+#include <time.h>
+
 #include <chrono>
-#include <iomanip>
-#include <sstream>
+#include <cstring>
+#include <ctime>
+#include <limits>
 #include <thread>
 
 namespace rix {
 namespace util {
 
+namespace {
+
+// Hints the CPU that this is a spin-wait loop, which saves power and frees
+// execution resources for a sibling hyperthread.
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+}  // namespace
+
+namespace {
+
+// The formatted date, time of day and zone of the last second formatted by
+// this thread, for GMT and local time.
+struct FormatCache {
+    int64_t seconds = std::numeric_limits<int64_t>::min();
+    char prefix[32];
+    size_t prefix_size = 0;
+    char zone[16];
+    size_t zone_size = 0;
+};
+
+thread_local FormatCache format_cache[2];
+
+}  // namespace
+
 std::string Time::to_string(bool local_time) const {
-    auto time = Clock::to_time_t(std::chrono::time_point_cast<std::chrono::seconds>(tp));
-    std::stringstream ss;
-    std::tm *timeinfo;
-    if (local_time) {
-        timeinfo = std::localtime(&time);
-    } else {
-        timeinfo = std::gmtime(&time);
+    char buffer[format_size];
+    return std::string(buffer, format(buffer, sizeof(buffer), local_time));
+}
+
+size_t Time::format(char *buffer, size_t size, bool local_time) const {
+    int64_t ns = to_nanoseconds();
+    int64_t seconds = ns / 1'000'000'000;
+    int64_t sub_ns = ns % 1'000'000'000;
+    if (sub_ns < 0) {
+        seconds--;
+        sub_ns += 1'000'000'000;
     }
 
-    ss << std::put_time(timeinfo, "%D %T");
-    int64_t us = to_microseconds() % 1'000'000;
-    if (us == 0) {
-        ss << ".000000";
-    } else {
-        ss << "." << us;
+    FormatCache &cache = format_cache[local_time ? 1 : 0];
+    if (cache.seconds != seconds) {
+        std::time_t time = static_cast<std::time_t>(seconds);
+        std::tm timeinfo;
+        if (local_time) {
+            localtime_r(&time, &timeinfo);
+            cache.zone_size = std::strftime(cache.zone, sizeof(cache.zone), " %Z", &timeinfo);
+        } else {
+            gmtime_r(&time, &timeinfo);
+            cache.zone_size = std::strftime(cache.zone, sizeof(cache.zone), " GMT", &timeinfo);
+        }
+        cache.prefix_size = std::strftime(cache.prefix, sizeof(cache.prefix), "%D %T", &timeinfo);
+        cache.seconds = seconds;
     }
 
-    if (local_time) {
-        ss << " " << std::put_time(timeinfo, "%Z");
-    } else {
-        ss << " GMT";
+    size_t length = cache.prefix_size + 7 + cache.zone_size;
+    if (size < length + 1) {
+        return 0;
     }
-    return ss.str();
+
+    char *out = buffer;
+    std::memcpy(out, cache.prefix, cache.prefix_size);
+    out += cache.prefix_size;
+    *out++ = '.';
+    int64_t us = sub_ns / 1000;
+    for (int i = 5; i >= 0; i--) {
+        out[i] = static_cast<char>('0' + us % 10);
+        us /= 10;
+    }
+    out += 6;
+    std::memcpy(out, cache.zone, cache.zone_size);
+    out += cache.zone_size;
+    *out = '\0';
+    return length;
 }
 
 rix::msg::standard::Time Time::to_msg() {
@@ -144,6 +202,61 @@ const Time::Type &Time::get() const { return tp; }
 
 Time::Type &Time::get() { return tp; }
 
+SteadyTime SteadyTime::now() {
+    SteadyTime time;
+    time.tp = SteadyClock::now();
+    return time;
+}
+
+SteadyTime::SteadyTime() : tp{} {}
+
+SteadyTime::SteadyTime(const Type &time_point) : tp(time_point) {}
+
+SteadyTime::SteadyTime(const SteadyTime &other) : tp(other.tp) {}
+
+SteadyTime &SteadyTime::operator=(const SteadyTime &other) {
+    if (this == &other) {
+        return *this;
+    }
+    SteadyTime tmp(other);
+    std::swap(tp, tmp.tp);
+    return *this;
+}
+
+SteadyTime SteadyTime::operator+(const Duration &other) const { return SteadyTime(tp + other.get()); }
+
+SteadyTime SteadyTime::operator-(const Duration &other) const { return SteadyTime(tp - other.get()); }
+
+Duration SteadyTime::operator-(const SteadyTime &other) const { return Duration(tp - other.get()); }
+
+SteadyTime &SteadyTime::operator+=(const Duration &other) {
+    tp += other.get();
+    return *this;
+}
+
+SteadyTime &SteadyTime::operator-=(const Duration &other) {
+    tp -= other.get();
+    return *this;
+}
+
+bool SteadyTime::operator==(const SteadyTime &other) const { return tp == other.tp; }
+
+bool SteadyTime::operator!=(const SteadyTime &other) const { return tp != other.tp; }
+
+bool SteadyTime::operator<(const SteadyTime &other) const { return tp < other.tp; }
+
+bool SteadyTime::operator<=(const SteadyTime &other) const { return tp <= other.tp; }
+
+bool SteadyTime::operator>(const SteadyTime &other) const { return tp > other.tp; }
+
+bool SteadyTime::operator>=(const SteadyTime &other) const { return tp >= other.tp; }
+
+int64_t SteadyTime::to_nanoseconds() const { return (tp.time_since_epoch()).count(); }
+
+const SteadyTime::Type &SteadyTime::get() const { return tp; }
+
+SteadyTime::Type &SteadyTime::get() { return tp; }
+
 Duration::Duration() : d{} {}
 
 Duration::Duration(const rix::msg::standard::Duration &msg) : Duration(msg.sec, msg.nsec) {}
@@ -282,6 +395,20 @@ void sleep_for(const Duration &duration) { std::this_thread::sleep_for(duration.
 
 void sleep_until(const Time &time) { std::this_thread::sleep_until(time.get()); }
 
+void sleep_until(const SteadyTime &time) {
+    // std::chrono::steady_clock is CLOCK_MONOTONIC in libstdc++, so the
+    // deadline can be handed to the kernel as an absolute time.
+    int64_t ns = time.to_nanoseconds();
+    if (ns <= 0) {
+        return;
+    }
+    struct timespec ts;
+    ts.tv_sec = ns / 1'000'000'000;
+    ts.tv_nsec = ns % 1'000'000'000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+    }
+}
+
 Timer::Timer() {}
 
 Timer::Timer(const Timer &other) : start_(other.start_), end_(other.end_) {}
@@ -296,20 +423,35 @@ Timer &Timer::operator=(const Timer &other) {
     return *this;
 }
 
-void Timer::start() { start_ = Time::now(); }
+void Timer::start() { start_ = SteadyTime::now(); }
 
-void Timer::stop() { end_ = Time::now(); }
+void Timer::stop() { end_ = SteadyTime::now(); }
 
 Duration Timer::get() const { return end_ - start_; }
 
-Rate::Rate() : period_(0), start_(Time::now()) {}
+Rate::Rate() : period_(min_period()), start_(SteadyTime::now()), spin_margin_(0), policy_(REALIGN), lateness_(0) {}
 
 Rate::Rate(double frequency)
-    : period_((frequency <= min_frequency()) ? max_period() : Duration(1.0 / frequency)), start_(Time::now()) {}
-
-Rate::Rate(Duration period) : period_((period <= min_period()) ? min_period() : period), start_(Time::now()) {}
-
-Rate::Rate(const Rate &other) : period_(other.period_), start_(other.start_) {}
+    : period_((frequency <= min_frequency()) ? max_period() : Duration(1.0 / frequency)),
+      start_(SteadyTime::now()),
+      spin_margin_(0),
+      policy_(REALIGN),
+      lateness_(0) {}
+
+Rate::Rate(Duration period)
+    : period_((period <= min_period()) ? min_period() : period),
+      start_(SteadyTime::now()),
+      spin_margin_(0),
+      policy_(REALIGN),
+      lateness_(0) {}
+
+Rate::Rate(const Rate &other)
+    : period_(other.period_),
+      start_(other.start_),
+      spin_margin_(other.spin_margin_),
+      policy_(other.policy_),
+      stats_(other.stats_),
+      lateness_(other.lateness_) {}
 
 Rate &Rate::operator=(const Rate &other) {
     if (this == &other) {
@@ -318,23 +460,67 @@ Rate &Rate::operator=(const Rate &other) {
     Rate tmp(other);
     std::swap(period_, tmp.period_);
     std::swap(start_, tmp.start_);
+    std::swap(spin_margin_, tmp.spin_margin_);
+    std::swap(policy_, tmp.policy_);
+    std::swap(stats_, tmp.stats_);
+    std::swap(lateness_, tmp.lateness_);
     return *this;
 }
 
 bool Rate::sleep() {
-    auto now = Time::now();
-    if (start_ + period_ > now) {
-        sleep_until(start_ + period_);
-        start_ = Time::now();
-        return true;
-    } else {
-        start_ = now;
+    SteadyTime deadline = start_ + period_;
+    SteadyTime now = SteadyTime::now();
+    if (now >= deadline) {
+        Duration late = now - deadline;
+        stats_.overruns++;
+        record(late);
+        switch (policy_) {
+            case SKIP: {
+                int64_t missed = late.to_nanoseconds() / period_.to_nanoseconds();
+                stats_.missed += missed;
+                start_ = deadline + Duration(Duration::Type(period_.to_nanoseconds() * missed));
+                break;
+            }
+            case CATCH_UP:
+                start_ = deadline;
+                break;
+            case REALIGN:
+                start_ = now;
+                break;
+        }
         return false;
     }
+
+    if (spin_margin_ > Duration()) {
+        if (deadline - now > spin_margin_) {
+            sleep_until(deadline - spin_margin_);
+        }
+        while ((now = SteadyTime::now()) < deadline) {
+            cpu_relax();
+        }
+    } else {
+        sleep_until(deadline);
+        now = SteadyTime::now();
+    }
+    record(now - deadline);
+    start_ = deadline;
+    return true;
 }
+
+void Rate::record(const Duration &lateness) {
+    lateness_ = lateness;
+    stats_.cycles++;
+    stats_.jitter.record(lateness);
+    if (lateness > stats_.max_lateness) {
+        stats_.max_lateness = lateness;
+    }
+}
+
+void Rate::reset() { start_ = SteadyTime::now(); }
+
 Duration Rate::period() const { return period_; }
 
-void Rate::set_period(const Duration &period) { period_ = period; }
+void Rate::set_period(const Duration &period) { period_ = (period <= min_period()) ? min_period() : period; }
 
 double Rate::frequency() const {
     auto ns = period_.to_nanoseconds();
@@ -352,5 +538,19 @@ void Rate::set_frequency(double frequency) {
     }
 }
 
+void Rate::set_spin_margin(const Duration &margin) { spin_margin_ = margin < Duration() ? Duration() : margin; }
+
+Duration Rate::spin_margin() const { return spin_margin_; }
+
+void Rate::set_overrun_policy(OverrunPolicy policy) { policy_ = policy; }
+
+Rate::OverrunPolicy Rate::overrun_policy() const { return policy_; }
+
+const Rate::Stats &Rate::stats() const { return stats_; }
+
+void Rate::reset_stats() { stats_ = Stats(); }
+
+Duration Rate::lateness() const { return lateness_; }
+
 }  // namespace util
 }  // namespace rix
\ No newline at end of file
@@ -0,0 +1,272 @@
+#include "rix/util/timer_wheel.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace rix {
+namespace util {
+
+TimerWheel::TimerWheel(const Duration &resolution, const SteadyTime &start)
+    : resolution_ns_(std::max<int64_t>(resolution.to_nanoseconds(), 1)),
+      start_(start),
+      current_(0),
+      size_(0),
+      free_(npos),
+      heads_(levels * slots + 1, npos),
+      occupied_{} {}
+
+TimerWheel::Id TimerWheel::schedule(const SteadyTime &deadline, Callback callback) {
+    uint32_t index;
+    if (free_ != npos) {
+        index = free_;
+        free_ = nodes_[index].next;
+    } else {
+        index = static_cast<uint32_t>(nodes_.size());
+        nodes_.push_back(Node{npos, npos, npos, 0, 0, nullptr});
+    }
+
+    Node &node = nodes_[index];
+    node.tick = std::max(tick_of(deadline), current_ + 1);
+    node.callback = std::move(callback);
+    place(index);
+    size_++;
+    return (static_cast<Id>(node.generation) << 32) | (index + 1);
+}
+
+bool TimerWheel::reschedule(Id id, const SteadyTime &deadline) {
+    Node *node = find(id);
+    if (node == nullptr) {
+        return false;
+    }
+    uint32_t index = static_cast<uint32_t>(node - nodes_.data());
+    unlink(index);
+    node->tick = std::max(tick_of(deadline), current_ + 1);
+    place(index);
+    return true;
+}
+
+bool TimerWheel::cancel(Id id) {
+    Node *node = find(id);
+    if (node == nullptr) {
+        return false;
+    }
+    uint32_t index = static_cast<uint32_t>(node - nodes_.data());
+    unlink(index);
+    release(index);
+    return true;
+}
+
+bool TimerWheel::pending(Id id) const { return find(id) != nullptr; }
+
+size_t TimerWheel::advance(const SteadyTime &now) {
+    int64_t elapsed = (now - start_).to_nanoseconds();
+    uint64_t target = elapsed > 0 ? static_cast<uint64_t>(elapsed / resolution_ns_) : 0;
+
+    size_t ran = 0;
+    while (current_ < target) {
+        // Jump straight to the next tick with work to do, skipping empty slots
+        // and cascades of empty slots.
+        uint64_t step = next_tick();
+        if (step > target) {
+            current_ = target;
+            break;
+        }
+        current_ = step;
+
+        if ((current_ & (slots - 1)) == 0) {
+            // Cascade from the highest level whose block also starts here, so
+            // timers can fall through several levels in one step.
+            int top = 1;
+            while (top < levels - 1 && ((current_ >> (slot_bits * top)) & (slots - 1)) == 0) {
+                top++;
+            }
+            for (int level = top; level >= 1; level--) {
+                cascade(level);
+            }
+        }
+
+        // Move the due slot to the expired list and run it. Callbacks may
+        // schedule, reschedule or cancel timers, including expired ones.
+        uint32_t list = current_ & (slots - 1);
+        while (heads_[list] != npos) {
+            uint32_t index = heads_[list];
+            unlink(index);
+            link(index, expired_list);
+        }
+        while (heads_[expired_list] != npos) {
+            uint32_t index = heads_[expired_list];
+            Callback callback = std::move(nodes_[index].callback);
+            unlink(index);
+            release(index);
+            if (callback) {
+                callback();
+            }
+            ran++;
+        }
+    }
+    return ran;
+}
+
+SteadyTime TimerWheel::next_deadline() const { return size_ == 0 ? SteadyTime::max() : time_of(next_tick()); }
+
+size_t TimerWheel::size() const { return size_; }
+
+Duration TimerWheel::resolution() const { return Duration(Duration::Type(resolution_ns_)); }
+
+uint64_t TimerWheel::next_tick() const {
+    uint64_t best = std::numeric_limits<uint64_t>::max();
+
+    // Level 0 holds the ticks after the current one, wrapping into the next
+    // block.
+    uint32_t position = current_ & (slots - 1);
+    uint64_t block = current_ & ~uint64_t(slots - 1);
+    int slot = next_slot(0, position + 1);
+    if (slot >= 0) {
+        best = block + slot;
+    } else {
+        slot = next_slot(0, 0);
+        if (slot >= 0 && static_cast<uint32_t>(slot) <= position) {
+            best = block + slots + slot;
+        }
+    }
+
+    // Higher levels need a wakeup when their next occupied slot cascades
+    for (int level = 1; level < levels; level++) {
+        uint64_t index = current_ >> (slot_bits * level);
+        uint32_t current_slot = index & (slots - 1);
+        int next = next_slot(level, current_slot + 1);
+        uint64_t distance;
+        if (next >= 0) {
+            distance = next - current_slot;
+        } else {
+            next = next_slot(level, 0);
+            if (next < 0) {
+                continue;
+            }
+            distance = next + slots - current_slot;
+        }
+        best = std::min(best, (index + distance) << (slot_bits * level));
+    }
+    return best;
+}
+
+uint64_t TimerWheel::tick_of(const SteadyTime &time) const {
+    int64_t elapsed = (time - start_).to_nanoseconds();
+    if (elapsed <= 0) {
+        return 0;
+    }
+    // Round up so a timer never fires before its deadline
+    return static_cast<uint64_t>(elapsed / resolution_ns_) + (elapsed % resolution_ns_ != 0 ? 1 : 0);
+}
+
+SteadyTime TimerWheel::time_of(uint64_t tick) const {
+    if (tick > static_cast<uint64_t>(std::numeric_limits<int64_t>::max() / resolution_ns_)) {
+        return SteadyTime::max();
+    }
+    return start_ + Duration(Duration::Type(static_cast<int64_t>(tick) * resolution_ns_));
+}
+
+TimerWheel::Node *TimerWheel::find(Id id) {
+    return const_cast<Node *>(static_cast<const TimerWheel *>(this)->find(id));
+}
+
+const TimerWheel::Node *TimerWheel::find(Id id) const {
+    uint64_t index = (id & 0xffffffff) - 1;
+    if (id == invalid_id || index >= nodes_.size()) {
+        return nullptr;
+    }
+    const Node &node = nodes_[index];
+    if (node.generation != static_cast<uint32_t>(id >> 32) || node.list == npos) {
+        return nullptr;
+    }
+    return &node;
+}
+
+void TimerWheel::place(uint32_t index) {
+    Node &node = nodes_[index];
+
+    // Use the lowest level whose span still reaches the deadline. Distances
+    // are measured in blocks of that level, so a timer is never placed in a
+    // slot of a higher level that has already been cascaded. A timer cascaded
+    // onto the current tick lands in the level 0 slot that is expired next.
+    for (int level = 0; level < levels; level++) {
+        int shift = slot_bits * level;
+        uint64_t distance = (node.tick >> shift) - (current_ >> shift);
+        if (distance < slots) {
+            link(index, level * slots + ((node.tick >> shift) & (slots - 1)));
+            return;
+        }
+    }
+
+    // Beyond the range of the wheel: park in the farthest slot of the top
+    // level, which places the timer again when it cascades.
+    int shift = slot_bits * (levels - 1);
+    uint64_t farthest = (current_ >> shift) + slots - 1;
+    link(index, (levels - 1) * slots + (farthest & (slots - 1)));
+}
+
+void TimerWheel::link(uint32_t index, uint32_t list) {
+    Node &node = nodes_[index];
+    node.list = list;
+    node.prev = npos;
+    node.next = heads_[list];
+    if (node.next != npos) {
+        nodes_[node.next].prev = index;
+    }
+    heads_[list] = index;
+    if (list < expired_list) {
+        occupied_[list / slots][(list % slots) / 64] |= uint64_t(1) << (list % 64);
+    }
+}
+
+void TimerWheel::unlink(uint32_t index) {
+    Node &node = nodes_[index];
+    if (node.prev != npos) {
+        nodes_[node.prev].next = node.next;
+    } else {
+        heads_[node.list] = node.next;
+    }
+    if (node.next != npos) {
+        nodes_[node.next].prev = node.prev;
+    }
+    if (heads_[node.list] == npos && node.list < expired_list) {
+        occupied_[node.list / slots][(node.list % slots) / 64] &= ~(uint64_t(1) << (node.list % 64));
+    }
+    node.prev = npos;
+    node.next = npos;
+}
+
+void TimerWheel::release(uint32_t index) {
+    Node &node = nodes_[index];
+    node.callback = nullptr;
+    node.list = npos;
+    node.generation++;
+    node.next = free_;
+    free_ = index;
+    size_--;
+}
+
+void TimerWheel::cascade(int level) {
+    uint32_t list = level * slots + ((current_ >> (slot_bits * level)) & (slots - 1));
+    while (heads_[list] != npos) {
+        uint32_t index = heads_[list];
+        unlink(index);
+        place(index);
+    }
+}
+
+int TimerWheel::next_slot(int level, uint32_t from) const {
+    for (uint32_t word = from / 64; word < slots / 64; word++) {
+        uint64_t bits = occupied_[level][word];
+        if (word == from / 64) {
+            bits &= ~uint64_t(0) << (from % 64);
+        }
+        if (bits != 0) {
+            return static_cast<int>(word * 64 + __builtin_ctzll(bits));
+        }
+    }
+    return -1;
+}
+
+}  // namespace util
+}  // namespace rix
@@ -0,0 +1,53 @@
+#include "rix/util/trace.hpp"
+
+#include <iomanip>
+
+namespace rix {
+namespace util {
+
+Trace::Trace(const std::string &name) : name_(name) {}
+
+size_t Trace::add_stage(const std::string &name) {
+    stage_names_.push_back(name);
+    stages_.emplace_back();
+    return stages_.size() - 1;
+}
+
+void Trace::record(size_t stage, const Duration &latency) { stages_[stage].record(latency); }
+
+void Trace::record(size_t stage, const Time &origin) { stages_[stage].record(Time::now() - origin); }
+
+void Trace::report(std::ostream &os) const {
+    auto flags = os.flags();
+    auto precision = os.precision();
+
+    os << "Trace: " << name_ << " (latency since origin, us)\n";
+    os << std::left << std::setw(16) << "stage" << std::right;
+    for (const char *column : {"count", "p50", "p90", "p99", "p99.9", "max"}) {
+        os << std::setw(12) << column;
+    }
+    os << "\n" << std::fixed << std::setprecision(1);
+    for (size_t i = 0; i < stages_.size(); i++) {
+        const Histogram &h = stages_[i];
+        os << std::left << std::setw(16) << stage_names_[i] << std::right << std::setw(12) << h.count();
+        for (double p : {50.0, 90.0, 99.0, 99.9}) {
+            os << std::setw(12) << h.percentile(p) / 1e3;
+        }
+        os << std::setw(12) << h.max() / 1e3 << "\n";
+    }
+    os.flush();
+
+    os.flags(flags);
+    os.precision(precision);
+}
+
+void Trace::reset() {
+    for (auto &h : stages_) {
+        h.reset();
+    }
+}
+
+const Histogram &Trace::stage(size_t stage) const { return stages_[stage]; }
+
+}  // namespace util
+}  // namespace rix
@@ -0,0 +1,42 @@
+#include <fstream>
+#include <iostream>
+
+#include "rix/util/argument_parser.hpp"
+#include "rix/util/binary_log.hpp"
+
+using namespace rix::util;
+
+int main(int argc, char **argv) {
+    ArgumentParser parser("rix_log_decode", "Converts a binary log written with RIX_BLOG to text on stdout.");
+    parser.add<std::string>("input", "Path of the binary log");
+    parser.add<bool>("local_time", "Print timestamps in local time instead of GMT", 'L', false);
+
+    if (!parser.parse(argc, argv)) {
+        std::cerr << parser.help() << std::endl;
+        return 1;
+    }
+
+    std::string input;
+    if (!parser.get<std::string>("input", input)) {
+        std::cerr << "Failed to get input argument." << std::endl;
+        return 1;
+    }
+
+    bool local_time;
+    if (!parser.get<bool>("local_time", local_time)) {
+        std::cerr << "Failed to get local_time argument." << std::endl;
+        return 1;
+    }
+
+    std::ifstream file(input, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open " << input << "." << std::endl;
+        return 1;
+    }
+
+    if (!BinaryLog::decode(file, std::cout, local_time)) {
+        std::cout.flush();
+        std::cerr << input << " is not a binary log or is corrupted." << std::endl;
+        return 1;
+    }
+}
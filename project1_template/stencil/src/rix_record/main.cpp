@@ -0,0 +1,215 @@
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "rix/bag/writer.hpp"
+#include "rix/ipc/file.hpp"
+#include "rix/ipc/poller.hpp"
+#include "rix/ipc/signal.hpp"
+#include "rix/ipc/topic.hpp"
+#include "rix/msg/geometry/Twist2DStamped.hpp"
+#include "rix/msg/standard/UInt32.hpp"
+#include "rix/util/argument_parser.hpp"
+#include "rix/util/time.hpp"
+
+using namespace rix::ipc;
+using namespace rix::msg;
+using namespace rix::util;
+
+namespace {
+
+// Frames larger than this are treated as a corrupted size prefix
+constexpr uint32_t max_frame_size = 1 << 20;
+
+/**
+ * @brief Writes all of `data` to `out`.
+ */
+bool write_all(const File &out, const uint8_t *data, size_t size) {
+    while (size > 0) {
+        ssize_t n = out.write(data, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    ArgumentParser parser("rix_record",
+                          "Records the size-prefixed drive commands read from stdin (or a topic) to a bag file.");
+    parser.add<std::string>("output", "Path of the bag");
+    parser.add<std::string>("topic", "Record commands published on this topic instead of reading stdin", 'n', "");
+    parser.add<bool>("passthrough", "Copy the recorded commands to stdout (size-prefixed)", 'p', false);
+    parser.add<int>("chunk_size", "Size of the chunks written to disk (KiB)", 'c',
+                    static_cast<int>(rix::bag::Writer::default_chunk_size / 1024));
+    parser.add<bool>("compress", "Compress the chunks (LZ), for slow disks", 'z', false);
+
+    if (!parser.parse(argc, argv)) {
+        std::cerr << parser.help() << std::endl;
+        return 1;
+    }
+
+    std::string output;
+    if (!parser.get<std::string>("output", output)) {
+        std::cerr << "Failed to get output argument." << std::endl;
+        return 1;
+    }
+
+    std::string topic;
+    if (!parser.get<std::string>("topic", topic)) {
+        std::cerr << "Failed to get topic argument." << std::endl;
+        return 1;
+    }
+
+    bool passthrough;
+    if (!parser.get<bool>("passthrough", passthrough)) {
+        std::cerr << "Failed to get passthrough argument." << std::endl;
+        return 1;
+    }
+
+    int chunk_size;
+    if (!parser.get<int>("chunk_size", chunk_size)) {
+        std::cerr << "Failed to get chunk_size argument." << std::endl;
+        return 1;
+    }
+    if (chunk_size <= 0) {
+        std::cerr << "chunk_size must be positive." << std::endl;
+        return 1;
+    }
+
+    bool compress;
+    if (!parser.get<bool>("compress", compress)) {
+        std::cerr << "Failed to get compress argument." << std::endl;
+        return 1;
+    }
+
+    const std::array<uint64_t, 2> hash = geometry::Twist2DStamped().hash();
+    std::unique_ptr<TopicReader> reader;
+    if (!topic.empty()) {
+        reader = std::make_unique<TopicReader>(topic, hash);
+        if (!reader->ok()) {
+            std::cerr << "Failed to subscribe to " << topic << ": " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+        reader->set_nonblocking(true);
+    }
+
+    rix::bag::Writer bag;
+    if (!bag.open(output, static_cast<size_t>(chunk_size) * 1024)) {
+        std::cerr << "Failed to create " << output << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    if (compress) {
+        bag.set_compression(rix::bag::Compression::LZ);
+    }
+
+    File in(STDIN_FILENO);
+    File out(STDOUT_FILENO);
+    Signal sig(SIGINT);
+    Poller poller;
+    size_t input_index = poller.add(reader ? reader->fd() : in.fd());
+    size_t sig_index = poller.add(sig.fd());
+
+    std::vector<uint8_t> buffer(reader ? TopicReader::default_capacity : 1 << 16);
+    size_t buffered = 0;
+    bool running = true;
+    // Drain the topic once before the first wait, so the messages queued
+    // while subscribing are recorded right away
+    bool wait = !reader;
+    while (running) {
+        if (wait) {
+            if (poller.wait(Duration::max()) < 0 && errno != EINTR) {
+                std::cerr << "Failed to wait for input: " << std::strerror(errno) << std::endl;
+                break;
+            }
+            if (poller.ready(sig_index)) {
+                break;
+            }
+            if (!poller.ready(input_index)) {
+                continue;
+            }
+        }
+        wait = true;
+
+        if (reader) {
+            // One message per read, until the ring is empty
+            ssize_t size;
+            while ((size = reader->read(buffer.data(), buffer.size())) > 0) {
+                Time now = Time::now();
+                bag.write(hash, buffer.data(), size, now);
+                if (passthrough) {
+                    standard::UInt32 prefix;
+                    prefix.data = size;
+                    uint8_t bytes[4];
+                    size_t offset = 0;
+                    prefix.serialize(bytes, offset);
+                    write_all(out, bytes, sizeof(bytes));
+                    write_all(out, buffer.data(), size);
+                }
+            }
+            if (size == 0) {
+                // The publisher is gone
+                break;
+            }
+            continue;
+        }
+
+        ssize_t size = in.read(buffer.data() + buffered, buffer.size() - buffered);
+        if (size == 0) {
+            running = false;
+        }
+        if (size <= 0) {
+            continue;
+        }
+        Time now = Time::now();
+        if (passthrough) {
+            write_all(out, buffer.data() + buffered, size);
+        }
+        buffered += size;
+
+        // Record every complete frame, keeping a partial one for the next read
+        size_t offset = 0;
+        while (buffered - offset >= 4) {
+            standard::UInt32 frame_size;
+            size_t end = offset;
+            frame_size.deserialize(buffer.data(), buffered, end);
+            if (frame_size.data > max_frame_size) {
+                std::cerr << "Corrupted size prefix, stopping." << std::endl;
+                running = false;
+                break;
+            }
+            if (buffered - end < frame_size.data) {
+                break;
+            }
+            bag.write(hash, buffer.data() + end, frame_size.data, now);
+            offset = end + frame_size.data;
+        }
+        std::memmove(buffer.data(), buffer.data() + offset, buffered - offset);
+        buffered -= offset;
+        if (buffered == buffer.size()) {
+            // A frame larger than the buffer, bounded by max_frame_size
+            buffer.resize(buffer.size() * 2);
+        }
+    }
+
+    if (!bag.close()) {
+        std::cerr << "Failed to write " << output << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    std::cerr << "Recorded " << bag.written() << " messages to " << output << " (" << bag.bytes_written()
+              << " bytes)";
+    if (bag.dropped() > 0) {
+        std::cerr << ", dropped " << bag.dropped();
+    }
+    std::cerr << "." << std::endl;
+}
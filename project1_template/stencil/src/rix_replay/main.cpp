@@ -0,0 +1,139 @@
+#include <fcntl.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+#include "rix/bag/player.hpp"
+#include "rix/bag/reader.hpp"
+#include "rix/ipc/file.hpp"
+#include "rix/ipc/signal.hpp"
+#include "rix/ipc/unix_socket.hpp"
+#include "rix/msg/geometry/Twist2DStamped.hpp"
+#include "rix/util/argument_parser.hpp"
+#include "rix/util/time.hpp"
+
+using namespace rix::ipc;
+using namespace rix::msg;
+using namespace rix::util;
+
+int main(int argc, char **argv) {
+    ArgumentParser parser("rix_replay",
+                          "Replays the drive commands of a bag to stdout (size-prefixed) with their original timing.");
+    parser.add<std::string>("input", "Path of the bag (see rix_record)");
+    parser.add<double>("speed", "Playback speed, 2 replays twice as fast", 's', 1.0);
+    parser.add<bool>("fast", "Replay as fast as possible, for throughput tests", 'f', false);
+    parser.add<double>("start", "Start this many seconds after the beginning of the bag", 't', 0.0);
+    parser.add<std::string>("output", "Write to this file (a FIFO read by mbot_driver) instead of stdout", 'o', "");
+    parser.add<std::string>("socket", "Send to the driver's SEQPACKET socket at this path instead of stdout", 'S', "");
+
+    if (!parser.parse(argc, argv)) {
+        std::cerr << parser.help() << std::endl;
+        return 1;
+    }
+
+    std::string input;
+    if (!parser.get<std::string>("input", input)) {
+        std::cerr << "Failed to get input argument." << std::endl;
+        return 1;
+    }
+
+    double speed;
+    if (!parser.get<double>("speed", speed)) {
+        std::cerr << "Failed to get speed argument." << std::endl;
+        return 1;
+    }
+    if (speed <= 0.0) {
+        std::cerr << "speed must be positive, use --fast to replay as fast as possible." << std::endl;
+        return 1;
+    }
+
+    bool fast;
+    if (!parser.get<bool>("fast", fast)) {
+        std::cerr << "Failed to get fast argument." << std::endl;
+        return 1;
+    }
+
+    double start;
+    if (!parser.get<double>("start", start)) {
+        std::cerr << "Failed to get start argument." << std::endl;
+        return 1;
+    }
+
+    std::string output;
+    if (!parser.get<std::string>("output", output)) {
+        std::cerr << "Failed to get output argument." << std::endl;
+        return 1;
+    }
+
+    std::string socket;
+    if (!parser.get<std::string>("socket", socket)) {
+        std::cerr << "Failed to get socket argument." << std::endl;
+        return 1;
+    }
+    if (!output.empty() && !socket.empty()) {
+        std::cerr << "Only one of output and socket may be given." << std::endl;
+        return 1;
+    }
+
+    rix::bag::Reader reader;
+    if (!reader.open(input)) {
+        std::cerr << "Failed to open " << input << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    if (!reader.indexed()) {
+        std::cerr << input << " has no index (recording interrupted), replaying the complete chunks." << std::endl;
+    }
+    if (start > 0.0 && !reader.seek(reader.start_time() + Duration(start))) {
+        std::cerr << input << " ends before " << start << " s." << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<interfaces::IO> out;
+    if (!socket.empty()) {
+        UnixSocket connection = UnixSocket::connect(socket, UnixSocket::Type::SEQPACKET);
+        if (!connection.ok()) {
+            std::cerr << "Failed to connect to " << socket << ": " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+        out = std::make_unique<UnixSocket>(std::move(connection));
+    } else if (!output.empty()) {
+        auto file = std::make_unique<File>(output, O_WRONLY);
+        if (!file->ok()) {
+            std::cerr << "Failed to open " << output << ": " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+        out = std::move(file);
+    } else {
+        out = std::make_unique<File>(STDOUT_FILENO);
+    }
+
+    rix::bag::Player player(std::move(out));
+    player.set_speed(fast ? 0.0 : speed);
+    // Messages keep their boundaries on a SEQPACKET socket
+    player.set_size_prefixed(socket.empty());
+    player.set_type(geometry::Twist2DStamped().hash());
+
+    Signal sig(SIGINT);
+    player.play(reader, &sig);
+
+    const rix::bag::Player::Stats &stats = player.stats();
+    double elapsed = stats.elapsed.to_nanoseconds() / 1e9;
+    std::cerr << "Replayed " << stats.sent << " commands in " << elapsed << " s";
+    if (elapsed > 0.0) {
+        std::cerr << " (" << stats.sent / elapsed << " /s)";
+    }
+    if (stats.lateness.count() > 0) {
+        std::cerr << ", lateness (us) p50=" << stats.lateness.percentile(50) / 1e3
+                  << " p99=" << stats.lateness.percentile(99) / 1e3 << " max=" << stats.lateness.max() / 1e3;
+    }
+    std::cerr << "." << std::endl;
+    if (stats.failed > 0) {
+        std::cerr << stats.failed << " commands could not be written: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    if (stats.skipped > 0) {
+        std::cerr << "Skipped " << stats.skipped << " messages of other types." << std::endl;
+    }
+}
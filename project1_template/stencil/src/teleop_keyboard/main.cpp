@@ -1,6 +1,12 @@
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
 #include "rix/ipc/fifo.hpp"
 #include "rix/ipc/file.hpp"
 #include "rix/ipc/signal.hpp"
+#include "rix/ipc/topic.hpp"
+#include "rix/ipc/unix_socket.hpp"
 #include "rix/msg/geometry/Twist2DStamped.hpp"
 #include "rix/msg/standard/UInt32.hpp"
 #include "rix/util/argument_parser.hpp"
@@ -16,6 +22,15 @@ int main(int argc, char **argv) {
                           "Sends drive commands to stdout corresponding to characters written to FIFO.");
     parser.add<double>("linear_speed", "Linear speed to drive the MBot (m/s)", 'l', 0.25);
     parser.add<double>("angular_speed", "Angular speed to drive the MBot (rad/s)", 'a', 1.570796);
+    parser.add<double>("stream_rate", "Send the current command at this rate (Hz), 0 to send on keys only", 'r', 0.0);
+    parser.add<double>("linear_acceleration", "Linear acceleration of the stream (m/s^2), 0 for no limit", 'x', 0.0);
+    parser.add<double>("angular_acceleration", "Angular acceleration of the stream (rad/s^2), 0 for no limit", 'z',
+                       0.0);
+    parser.add<bool>("sequence", "Send every key of a batch instead of only the last one", 'S', false);
+    parser.add<std::string>("socket", "Send commands to the driver's SEQPACKET socket at this path instead of stdout",
+                            's', "");
+    parser.add<std::string>("topic", "Publish commands on this topic instead of writing them to stdout", 'n', "");
+    parser.add<bool>("trace", "Trace command latency, reported to stderr on SIGUSR1 and at exit", 'T', false);
 
     if (!parser.parse(argc, argv)) {
         std::cerr << parser.help() << std::endl;
@@ -34,9 +49,82 @@ int main(int argc, char **argv) {
         return 1;
     }
 
-    auto input = std::make_unique<Fifo>("teleop", Fifo::Mode::READ);
-    auto output = std::make_unique<File>(STDOUT_FILENO);
+    double stream_rate;
+    if (!parser.get<double>("stream_rate", stream_rate)) {
+        std::cerr << "Failed to get stream_rate argument." << std::endl;
+        return 1;
+    }
+
+    double linear_acceleration;
+    if (!parser.get<double>("linear_acceleration", linear_acceleration)) {
+        std::cerr << "Failed to get linear_acceleration argument." << std::endl;
+        return 1;
+    }
+
+    double angular_acceleration;
+    if (!parser.get<double>("angular_acceleration", angular_acceleration)) {
+        std::cerr << "Failed to get angular_acceleration argument." << std::endl;
+        return 1;
+    }
+
+    bool sequence;
+    if (!parser.get<bool>("sequence", sequence)) {
+        std::cerr << "Failed to get sequence argument." << std::endl;
+        return 1;
+    }
+
+    std::string socket;
+    if (!parser.get<std::string>("socket", socket)) {
+        std::cerr << "Failed to get socket argument." << std::endl;
+        return 1;
+    }
+
+    std::string topic;
+    if (!parser.get<std::string>("topic", topic)) {
+        std::cerr << "Failed to get topic argument." << std::endl;
+        return 1;
+    }
+    if (!socket.empty() && !topic.empty()) {
+        std::cerr << "Only one of socket and topic may be given." << std::endl;
+        return 1;
+    }
+
+    bool trace;
+    if (!parser.get<bool>("trace", trace)) {
+        std::cerr << "Failed to get trace argument." << std::endl;
+        return 1;
+    }
+
+    auto input = std::make_unique<Fifo>("teleop", Fifo::Mode::READ, true);
+    // Holding a writer keeps the FIFO open while no keyboard is connected, so
+    // the reader never sees EOF and the wait does not return on a hang-up.
+    Fifo keepalive("teleop", Fifo::Mode::WRITE, true);
+    std::unique_ptr<interfaces::IO> output;
+    if (!topic.empty()) {
+        auto writer = std::make_unique<TopicWriter>(topic, geometry::Twist2DStamped().hash());
+        if (!writer->ok()) {
+            std::cerr << "Failed to publish " << topic << ": " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+        output = std::move(writer);
+    } else if (socket.empty()) {
+        output = std::make_unique<File>(STDOUT_FILENO);
+    } else {
+        UnixSocket connection = UnixSocket::connect(socket, UnixSocket::Type::SEQPACKET);
+        if (!connection.ok()) {
+            std::cerr << "Failed to connect to " << socket << ": " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+        output = std::make_unique<UnixSocket>(std::move(connection));
+    }
     TeleopKeyboard teleop_keyboard(std::move(input), std::move(output), linear_speed, angular_speed);
+    teleop_keyboard.set_coalesce(!sequence);
+    teleop_keyboard.set_size_prefixed(socket.empty() && topic.empty());
+    teleop_keyboard.set_stream_rate(stream_rate);
+    teleop_keyboard.set_acceleration(linear_acceleration, angular_acceleration);
+    if (trace) {
+        teleop_keyboard.enable_trace(std::make_unique<Signal>(SIGUSR1));
+    }
 
     auto notif = std::make_unique<Signal>(SIGINT);
     teleop_keyboard.spin(std::move(notif));
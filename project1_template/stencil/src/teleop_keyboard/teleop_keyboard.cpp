@@ -1,82 +1,313 @@
 #include <teleop_keyboard/teleop_keyboard.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+// Moves `value` towards `target` by at most `step`, or jumps to it when
+// there is no limit.
+double ramp(double value, double target, double step) {
+  if (step <= 0.0) {
+    return target;
+  }
+  return value + std::clamp(target - value, -step, step);
+}
+
+// Keys read per read call. A held key repeats at ~30 Hz, so a batch rarely
+// holds more than a few keys.
+constexpr size_t read_chunk_size = 256;
+
+} // namespace
 
 TeleopKeyboard::TeleopKeyboard(std::unique_ptr<rix::ipc::interfaces::IO> input,
                                std::unique_ptr<rix::ipc::interfaces::IO> output,
                                double linear_speed, double angular_speed)
     : input(std::move(input)), output(std::move(output)),
-      linear_speed(linear_speed), angular_speed(angular_speed) {}
+      linear_speed(linear_speed), angular_speed(angular_speed),
+      coalesce_(true), size_prefixed_(true), stream_rate_(0.0), linear_acceleration_(0.0),
+      angular_acceleration_(0.0), seq(0), streaming(false),
+      trace_serialize(0), trace_write(0) {
+  build_templates();
+}
+
+void TeleopKeyboard::enable_trace(
+    std::unique_ptr<rix::ipc::interfaces::Notification> dump) {
+  trace_ = std::make_unique<rix::util::Trace>("teleop_keyboard");
+  trace_serialize = trace_->add_stage("serialize");
+  trace_write = trace_->add_stage("pipe_write");
+  trace_dump = std::move(dump);
+}
+
+const rix::util::Trace *TeleopKeyboard::trace() const { return trace_.get(); }
+
+void TeleopKeyboard::set_coalesce(bool coalesce) { coalesce_ = coalesce; }
+
+bool TeleopKeyboard::coalesce() const { return coalesce_; }
+
+void TeleopKeyboard::set_size_prefixed(bool size_prefixed) {
+  size_prefixed_ = size_prefixed;
+  build_templates();
+}
+
+bool TeleopKeyboard::size_prefixed() const { return size_prefixed_; }
+
+void TeleopKeyboard::set_stream_rate(double rate) {
+  stream_rate_ = std::max(rate, 0.0);
+}
+
+double TeleopKeyboard::stream_rate() const { return stream_rate_; }
+
+void TeleopKeyboard::set_acceleration(double linear, double angular) {
+  linear_acceleration_ = std::max(linear, 0.0);
+  angular_acceleration_ = std::max(angular, 0.0);
+}
+
+double TeleopKeyboard::linear_acceleration() const {
+  return linear_acceleration_;
+}
+
+double TeleopKeyboard::angular_acceleration() const {
+  return angular_acceleration_;
+}
+
+bool TeleopKeyboard::map_key(char key, geometry::Twist2D &twist) const {
+  twist.vx = 0.0;
+  twist.vy = 0.0;
+  twist.wz = 0.0;
+
+  switch (key) {
+  case 'w': // Forward
+    twist.vx = linear_speed;
+    return true;
+  case 's': // Backward
+    twist.vx = -linear_speed;
+    return true;
+  case 'a': // Rotate left
+    twist.wz = angular_speed;
+    return true;
+  case 'd': // Rotate right
+    twist.wz = -angular_speed;
+    return true;
+  case ' ': // Stop (already initialized to 0)
+    return true;
+  default:
+    // Unknown key, ignore
+    return false;
+  }
+}
+
+void TeleopKeyboard::build_templates() {
+  geometry::Twist2DStamped twist_msg;
+  size_t msg_size = twist_msg.size();
+  size_t prefix_size = size_prefixed_ ? sizeof(uint32_t) : 0;
+  seq_offset = prefix_size;
+  stamp_offset = seq_offset + sizeof(twist_msg.header.seq);
+  twist_offset = prefix_size + twist_msg.header.size();
+
+  // Size prefix (UInt32) followed by the message with a zero stamp
+  auto build = [&](const geometry::Twist2D &twist,
+                   std::vector<uint8_t> &frame) {
+    twist_msg.twist = twist;
+    frame.resize(prefix_size + msg_size);
+    size_t offset = 0;
+    if (size_prefixed_) {
+      standard::UInt32 size_msg;
+      size_msg.data = static_cast<uint32_t>(msg_size);
+      size_msg.serialize(frame.data(), offset);
+    }
+    twist_msg.serialize(frame.data(), offset);
+  };
+
+  for (int key = 0; key < 256; key++) {
+    geometry::Twist2D twist;
+    if (map_key(static_cast<char>(key), twist)) {
+      build(twist, key_frames[key]);
+    }
+  }
+  build(geometry::Twist2D(), stream_frame);
+}
+
+void TeleopKeyboard::stamp_frame(uint8_t *frame,
+                                 const standard::Time &stamp) {
+  size_t offset = seq_offset;
+  rix::msg::detail::serialize_number(frame, offset, seq++);
+  offset = stamp_offset;
+  rix::msg::detail::serialize_number(frame, offset, stamp.sec);
+  rix::msg::detail::serialize_number(frame, offset, stamp.nsec);
+}
+
+void TeleopKeyboard::set_frame_twist(uint8_t *frame,
+                                     const geometry::Twist2D &twist) const {
+  size_t offset = twist_offset;
+  rix::msg::detail::serialize_number(frame, offset, twist.vx);
+  rix::msg::detail::serialize_number(frame, offset, twist.vy);
+  rix::msg::detail::serialize_number(frame, offset, twist.wz);
+}
 
 void TeleopKeyboard::spin(
     std::unique_ptr<rix::ipc::interfaces::Notification> notif) {
   // Set input to non-blocking mode
   input->set_nonblocking(true);
 
-  rix::util::Duration timeout(0, 100000000); // 100ms timeout
+  // Sleep until a key or SIGINT arrives when both expose a file descriptor
+  Poller poller;
+  poller.add(input->fd());
+  poller.add(notif->fd());
+  poller.add(trace_dump ? trace_dump->fd() : -1);
+  bool multiplexed = input->fd() >= 0 && notif->fd() >= 0;
+
+  const rix::util::Duration idle_timeout(0, 100000000); // 100ms timeout
+  rix::util::Duration timeout = idle_timeout;
+  uint8_t keys[read_chunk_size];
   std::vector<uint8_t> buffer;
 
+  if (stream_rate_ > 0.0) {
+    target = geometry::Twist2D();
+    streaming = true;
+    publisher = std::thread([this] { stream(); });
+  }
+
   while (true) {
-    // Check for SIGINT with short timeout
-    if (notif->wait(timeout)) {
-      // SIGINT received, exit
+    bool readable = true;
+    if (multiplexed) {
+      // Level-triggered, so keys left after a full read wake it up again
+      poller.wait(rix::util::Duration::max());
+      if (poller.ready(1) && notif->is_ready()) {
+        // SIGINT received, exit
+        break;
+      }
+      readable = poller.ready(0);
+    } else if (notif->wait(timeout)) {
+      // Without file descriptors, check for SIGINT with a short timeout and
+      // then poll the input. SIGINT received, exit
       break;
     }
 
-    // Read single character from teleop FIFO
-    char key;
-    ssize_t bytes_read = input->read(reinterpret_cast<uint8_t *>(&key), 1);
+    if (trace_dump && (poller.ready(2) || !multiplexed) &&
+        trace_dump->is_ready()) {
+      trace_->report(std::cerr);
+    }
+
+    if (!readable) {
+      continue;
+    }
 
-    if (bytes_read != 1) {
+    // Drain every key available in one read. A full read means more keys
+    // may be waiting, so the next wait does not block.
+    ssize_t bytes_read = input->read(keys, sizeof(keys));
+    timeout = bytes_read == static_cast<ssize_t>(sizeof(keys))
+                  ? rix::util::Duration()
+                  : idle_timeout;
+    if (bytes_read < 0 && errno != EAGAIN && errno != EWOULDBLOCK &&
+        errno != EINTR) {
+      // The input failed. It would stay ready and fail again on every wait,
+      // so stop like the driver does.
+      std::cerr << "Failed to read keys: " << std::strerror(errno)
+                << std::endl;
+      break;
+    }
+    if (bytes_read == 0 && multiplexed) {
+      // Every writer closed the input. It would be reported as hung up on
+      // every wait, so stop watching it and only wait for SIGINT.
+      poller.disable(0);
+      continue;
+    }
+    if (bytes_read <= 0) {
       // No data available or error, continue
       continue;
     }
 
-    // Map key to Twist command
-    geometry::Twist2D twist_cmd;
-    twist_cmd.vx = 0.0;
-    twist_cmd.vy = 0.0;
-    twist_cmd.wz = 0.0;
+    // Create the frames with the current timestamp. The stamp is the origin
+    // of the latency trace.
+    rix::util::Time key_time = rix::util::Time::now();
+    standard::Time stamp = key_time.to_msg();
+    buffer.clear();
+    int last_key = -1;
+    for (ssize_t i = 0; i < bytes_read; i++) {
+      std::vector<uint8_t> &frame = key_frames[keys[i]];
+      if (frame.empty()) {
+        // Not a command key, ignore
+        continue;
+      }
+      if (!coalesce_ && !streaming) {
+        size_t offset = buffer.size();
+        buffer.insert(buffer.end(), frame.begin(), frame.end());
+        stamp_frame(buffer.data() + offset, stamp);
+      }
+      last_key = keys[i];
+    }
+    if (last_key < 0) {
+      continue;
+    }
 
-    switch (key) {
-    case 'w': // Forward
-      twist_cmd.vx = linear_speed;
-      break;
-    case 's': // Backward
-      twist_cmd.vx = -linear_speed;
-      break;
-    case 'a': // Rotate left
-      twist_cmd.wz = angular_speed;
-      break;
-    case 'd': // Rotate right
-      twist_cmd.wz = -angular_speed;
-      break;
-    case ' ': // Stop (already initialized to 0)
-      break;
-    default:
-      // Unknown key, ignore
+    if (streaming) {
+      // The publisher picks the new target up at its next deadline
+      geometry::Twist2D twist_cmd;
+      map_key(static_cast<char>(last_key), twist_cmd);
+      std::lock_guard<std::mutex> guard(target_mutex);
+      target = twist_cmd;
       continue;
     }
 
-    // Create Twist2DStamped with current timestamp
-    geometry::Twist2DStamped twist_msg;
-    twist_msg.header.stamp = rix::util::Time::now().to_msg();
-    twist_msg.twist = twist_cmd;
+    // Only the last key of the batch matters to the mbot, earlier ones would
+    // be overridden before it could act on them. Its template is sent as is
+    // once the seq and stamp are patched.
+    const uint8_t *data = buffer.data();
+    size_t size = buffer.size();
+    if (coalesce_) {
+      std::vector<uint8_t> &frame = key_frames[last_key];
+      stamp_frame(frame.data(), stamp);
+      data = frame.data();
+      size = frame.size();
+    }
+
+    if (trace_) {
+      trace_->record(trace_serialize, key_time);
+    }
+
+    // Write the whole batch to the output at once. Without a size prefix
+    // each frame is its own message; every frame has the same size.
+    size_t message_size = size_prefixed_ ? size : stream_frame.size();
+    for (size_t offset = 0; offset < size; offset += message_size) {
+      output->write(data + offset, message_size);
+    }
+    if (trace_) {
+      trace_->record(trace_write, key_time);
+    }
+  }
 
-    // Compute message size
-    size_t msg_size = twist_msg.size();
+  if (publisher.joinable()) {
+    streaming = false;
+    publisher.join();
+  }
 
-    // Create buffer for size prefix + message
-    buffer.resize(4 + msg_size);
+  if (trace_) {
+    trace_->report(std::cerr);
+  }
+}
 
-    // Serialize size prefix (UInt32)
-    standard::UInt32 size_msg;
-    size_msg.data = static_cast<uint32_t>(msg_size);
-    size_t offset = 0;
-    size_msg.serialize(buffer.data(), offset);
+void TeleopKeyboard::stream() {
+  rix::util::Rate rate(stream_rate_);
+  // After a stall, resume on the grid instead of sending a burst of frames
+  rate.set_overrun_policy(rix::util::Rate::SKIP);
+  double dt = rate.period().to_nanoseconds() * 1e-9;
 
-    // Serialize the Twist2DStamped message
-    twist_msg.serialize(buffer.data(), offset);
+  geometry::Twist2D command;
+  while (streaming) {
+    geometry::Twist2D goal;
+    {
+      std::lock_guard<std::mutex> guard(target_mutex);
+      goal = target;
+    }
+    command.vx = ramp(command.vx, goal.vx, linear_acceleration_ * dt);
+    command.vy = ramp(command.vy, goal.vy, linear_acceleration_ * dt);
+    command.wz = ramp(command.wz, goal.wz, angular_acceleration_ * dt);
 
-    // Write to stdout
-    output->write(buffer.data(), buffer.size());
+    set_frame_twist(stream_frame.data(), command);
+    stamp_frame(stream_frame.data(), rix::util::Time::now().to_msg());
+    output->write(stream_frame.data(), stream_frame.size());
+    rate.sleep();
   }
-}
\ No newline at end of file
+}
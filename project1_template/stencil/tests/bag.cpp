@@ -0,0 +1,395 @@
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rix/bag/format.hpp"
+#include "rix/bag/player.hpp"
+#include "rix/bag/reader.hpp"
+#include "rix/bag/writer.hpp"
+#include "rix/ipc/pipe.hpp"
+#include "rix/ipc/signal.hpp"
+#include "rix/msg/geometry/Twist2DStamped.hpp"
+#include "rix/msg/standard/UInt32.hpp"
+
+using namespace rix::bag;
+using namespace rix::msg;
+using rix::util::Time;
+
+namespace {
+
+std::string temp_path() { return "/tmp/rix_bag_test_" + std::to_string(getpid()) + ".bag"; }
+
+Time at(int64_t milliseconds) { return Time(Time::Type(std::chrono::milliseconds(milliseconds))); }
+
+geometry::Twist2DStamped make_command(uint32_t seq) {
+    geometry::Twist2DStamped cmd;
+    cmd.header.seq = seq;
+    cmd.twist.vx = 0.25f * seq;
+    cmd.twist.wz = -0.5f;
+    return cmd;
+}
+
+// Writes `count` commands stamped 1 ms apart, starting at 1000 ms
+void record(const std::string &path, uint32_t count, size_t chunk_size) {
+    Writer writer(path, chunk_size);
+    ASSERT_TRUE(writer.is_open());
+    for (uint32_t i = 0; i < count; i++) {
+        ASSERT_TRUE(writer.write(make_command(i), at(1000 + i)));
+    }
+    EXPECT_EQ(writer.written(), count);
+    ASSERT_TRUE(writer.close());
+}
+
+// Reads `count` size-prefixed commands from `pipe`
+std::vector<uint32_t> read_frames(const rix::ipc::Pipe &pipe, size_t count) {
+    std::vector<uint32_t> seqs;
+    std::vector<uint8_t> buffer;
+    uint8_t chunk[4096];
+    size_t offset = 0;
+    while (seqs.size() < count) {
+        if (buffer.size() - offset >= 4) {
+            standard::UInt32 size;
+            size_t end = offset;
+            EXPECT_TRUE(size.deserialize(buffer.data(), buffer.size(), end));
+            if (buffer.size() - end >= size.data) {
+                geometry::Twist2DStamped cmd;
+                EXPECT_TRUE(cmd.deserialize(buffer.data(), end + size.data, end));
+                seqs.push_back(cmd.header.seq);
+                offset = end;
+                continue;
+            }
+        }
+        ssize_t n = pipe.read(chunk, sizeof(chunk));
+        if (n <= 0) {
+            break;
+        }
+        buffer.insert(buffer.end(), chunk, chunk + n);
+    }
+    return seqs;
+}
+
+}  // namespace
+
+TEST(BagTest, WriteRead) {
+    std::string path = temp_path();
+    record(path, 1000, 4096);
+
+    Reader reader(path);
+    ASSERT_TRUE(reader.is_open());
+    EXPECT_TRUE(reader.indexed());
+    EXPECT_EQ(reader.size(), 1000u);
+    EXPECT_GT(reader.chunks(), 1u);
+    EXPECT_EQ(reader.start_time(), at(1000));
+    EXPECT_EQ(reader.end_time(), at(1999));
+
+    View view;
+    for (uint32_t i = 0; i < 1000; i++) {
+        ASSERT_TRUE(reader.next(view));
+        EXPECT_EQ(view.stamp, at(1000 + i));
+        geometry::Twist2DStamped cmd;
+        ASSERT_TRUE(view.deserialize(cmd));
+        EXPECT_EQ(cmd.header.seq, i);
+        EXPECT_FLOAT_EQ(cmd.twist.vx, 0.25f * i);
+    }
+    EXPECT_FALSE(reader.next(view));
+
+    reader.rewind();
+    ASSERT_TRUE(reader.next(view));
+    EXPECT_EQ(view.stamp, at(1000));
+    std::remove(path.c_str());
+}
+
+TEST(BagTest, Seek) {
+    std::string path = temp_path();
+    record(path, 1000, 4096);
+
+    Reader reader(path);
+    ASSERT_TRUE(reader.is_open());
+    View view;
+    geometry::Twist2DStamped cmd;
+
+    ASSERT_TRUE(reader.seek(at(1500)));
+    ASSERT_TRUE(reader.next(view));
+    ASSERT_TRUE(view.deserialize(cmd));
+    EXPECT_EQ(cmd.header.seq, 500u);
+
+    // Between two stamps, the later one is found
+    ASSERT_TRUE(reader.seek(at(1700) - rix::util::Duration(0.0005)));
+    ASSERT_TRUE(reader.next(view));
+    EXPECT_EQ(view.stamp, at(1700));
+
+    ASSERT_TRUE(reader.seek(at(0)));
+    ASSERT_TRUE(reader.next(view));
+    EXPECT_EQ(view.stamp, at(1000));
+
+    EXPECT_FALSE(reader.seek(at(2000)));
+    EXPECT_FALSE(reader.next(view));
+    std::remove(path.c_str());
+}
+
+TEST(BagTest, SeekStampsBackwards) {
+    std::string path = temp_path();
+    {
+        // The clock stepped back by 4 s early in the recording, so the chunks
+        // are not sorted by their latest stamp
+        Writer writer(path, 4096);
+        for (uint32_t i = 0; i < 800; i++) {
+            ASSERT_TRUE(writer.write(make_command(i), at(i < 200 ? 5000 + i : 1000 + i)));
+        }
+        ASSERT_TRUE(writer.close());
+    }
+
+    Reader reader(path);
+    ASSERT_TRUE(reader.is_open());
+    ASSERT_GT(reader.chunks(), 4u);
+    View view;
+    geometry::Twist2DStamped cmd;
+
+    ASSERT_TRUE(reader.seek(at(5100)));
+    ASSERT_TRUE(reader.next(view));
+    ASSERT_TRUE(view.deserialize(cmd));
+    EXPECT_EQ(cmd.header.seq, 100u);
+
+    ASSERT_TRUE(reader.seek(at(5199)));
+    ASSERT_TRUE(reader.next(view));
+    ASSERT_TRUE(view.deserialize(cmd));
+    EXPECT_EQ(cmd.header.seq, 199u);
+
+    // The first message in the order of the bag
+    ASSERT_TRUE(reader.seek(at(1400)));
+    ASSERT_TRUE(reader.next(view));
+    ASSERT_TRUE(view.deserialize(cmd));
+    EXPECT_EQ(cmd.header.seq, 0u);
+
+    EXPECT_FALSE(reader.seek(at(5200)));
+    std::remove(path.c_str());
+}
+
+TEST(BagTest, TypeMismatch) {
+    std::string path = temp_path();
+    {
+        Writer writer(path);
+        standard::UInt32 value;
+        value.data = 7;
+        ASSERT_TRUE(writer.write(value, at(1)));
+        ASSERT_TRUE(writer.close());
+    }
+
+    Reader reader(path);
+    View view;
+    ASSERT_TRUE(reader.next(view));
+    EXPECT_EQ(view.hash, standard::UInt32().hash());
+    geometry::Twist2DStamped cmd;
+    EXPECT_FALSE(view.deserialize(cmd));
+    standard::UInt32 value;
+    ASSERT_TRUE(view.deserialize(value));
+    EXPECT_EQ(value.data, 7u);
+    std::remove(path.c_str());
+}
+
+TEST(BagTest, Unindexed) {
+    std::string path = temp_path();
+    {
+        Writer writer(path, 4096);
+        for (uint32_t i = 0; i < 500; i++) {
+            ASSERT_TRUE(writer.write(make_command(i), at(1000 + i)));
+        }
+        ASSERT_TRUE(writer.flush());
+
+        // A recorder killed now leaves a bag without index
+        Reader reader(path);
+        ASSERT_TRUE(reader.is_open());
+        EXPECT_FALSE(reader.indexed());
+        EXPECT_EQ(reader.size(), 500u);
+        ASSERT_TRUE(reader.seek(at(1250)));
+        View view;
+        ASSERT_TRUE(reader.next(view));
+        EXPECT_EQ(view.stamp, at(1250));
+    }
+    std::remove(path.c_str());
+}
+
+TEST(BagTest, Truncated) {
+    std::string path = temp_path();
+    record(path, 1000, 4096);
+    size_t chunks;
+    {
+        Reader reader(path);
+        chunks = reader.chunks();
+    }
+
+    // Cut the index and half of the second chunk
+    ASSERT_EQ(truncate(path.c_str(), sizeof(format::file_magic) + sizeof(format::ChunkHeader) + 4096 * 3 / 2), 0);
+    Reader reader(path);
+    ASSERT_TRUE(reader.is_open());
+    EXPECT_FALSE(reader.indexed());
+    EXPECT_EQ(reader.chunks(), 1u);
+    EXPECT_LT(reader.chunks(), chunks);
+
+    uint64_t count = 0;
+    View view;
+    while (reader.next(view)) {
+        count++;
+    }
+    EXPECT_EQ(count, reader.size());
+    EXPECT_GT(count, 0u);
+    std::remove(path.c_str());
+}
+
+TEST(BagTest, DropsWhenBehind) {
+    std::string path = temp_path();
+    Writer writer(path, 256);
+    // Every full chunk is dropped unless written by flush
+    writer.set_max_pending(0);
+    for (uint32_t i = 0; i < 100; i++) {
+        ASSERT_TRUE(writer.write(make_command(i), at(1000 + i)));
+    }
+    EXPECT_GT(writer.dropped(), 0u);
+    EXPECT_EQ(writer.written() + writer.dropped(), 100u);
+    uint64_t written = writer.written();
+    ASSERT_TRUE(writer.close());
+
+    Reader reader(path);
+    EXPECT_EQ(reader.size(), written);
+    std::remove(path.c_str());
+}
+
+TEST(BagTest, Compressed) {
+    std::string path = temp_path();
+    uint64_t bytes_written;
+    {
+        Writer writer(path, 4096);
+        writer.set_compression(Compression::LZ);
+        for (uint32_t i = 0; i < 1000; i++) {
+            ASSERT_TRUE(writer.write(make_command(i), at(1000 + i)));
+        }
+        ASSERT_TRUE(writer.flush());
+        bytes_written = writer.bytes_written();
+        ASSERT_TRUE(writer.close());
+    }
+    // Records repeat their type hash and most of the command
+    uint64_t raw_size = 1000 * (sizeof(format::RecordHeader) + make_command(0).size());
+    EXPECT_LT(bytes_written, raw_size / 2);
+
+    Reader reader(path);
+    ASSERT_TRUE(reader.is_open());
+    EXPECT_EQ(reader.size(), 1000u);
+    ASSERT_TRUE(reader.seek(at(1600)));
+    View view;
+    geometry::Twist2DStamped cmd;
+    for (uint32_t i = 600; i < 1000; i++) {
+        ASSERT_TRUE(reader.next(view));
+        ASSERT_TRUE(view.deserialize(cmd));
+        EXPECT_EQ(cmd.header.seq, i);
+        EXPECT_EQ(view.stamp, at(1000 + i));
+    }
+    EXPECT_FALSE(reader.next(view));
+    std::remove(path.c_str());
+}
+
+TEST(BagTest, NotABag) {
+    std::string path = temp_path();
+    FILE *file = std::fopen(path.c_str(), "w");
+    ASSERT_NE(file, nullptr);
+    std::fputs("not a bag file", file);
+    std::fclose(file);
+
+    Reader reader;
+    EXPECT_FALSE(reader.open(path));
+    EXPECT_EQ(errno, EINVAL);
+    EXPECT_FALSE(reader.is_open());
+    std::remove(path.c_str());
+
+    EXPECT_FALSE(reader.open(path));
+    EXPECT_EQ(errno, ENOENT);
+}
+
+TEST(PlayerTest, KeepsTiming) {
+    std::string path = temp_path();
+    {
+        // 5 commands 20 ms apart
+        Writer writer(path);
+        for (uint32_t i = 0; i < 5; i++) {
+            ASSERT_TRUE(writer.write(make_command(i), at(1000 + 20 * i)));
+        }
+        ASSERT_TRUE(writer.close());
+    }
+
+    for (double speed : {1.0, 2.0}) {
+        auto [read_end, write_end] = rix::ipc::Pipe::create();
+        Reader reader(path);
+        Player player(std::make_unique<rix::ipc::Pipe>(write_end));
+        player.set_speed(speed);
+        ASSERT_TRUE(player.play(reader));
+
+        EXPECT_EQ(player.stats().sent, 5u);
+        EXPECT_EQ(player.stats().lateness.count(), 5u);
+        double elapsed = player.stats().elapsed.to_nanoseconds() / 1e6;
+        EXPECT_GE(elapsed, 80.0 / speed);
+        EXPECT_LT(elapsed, 80.0 / speed + 20.0);
+        EXPECT_EQ(read_frames(read_end, 5), (std::vector<uint32_t>{0, 1, 2, 3, 4}));
+    }
+    std::remove(path.c_str());
+}
+
+TEST(PlayerTest, AsFastAsPossible) {
+    std::string path = temp_path();
+    {
+        // 10 s of commands
+        Writer writer(path);
+        for (uint32_t i = 0; i < 100; i++) {
+            ASSERT_TRUE(writer.write(make_command(i), at(1000 + 100 * i)));
+        }
+        standard::UInt32 other;
+        ASSERT_TRUE(writer.write(other, at(20000)));
+        ASSERT_TRUE(writer.close());
+    }
+
+    auto [read_end, write_end] = rix::ipc::Pipe::create();
+    Reader reader(path);
+    ASSERT_TRUE(reader.seek(at(6000)));
+    Player player(std::make_unique<rix::ipc::Pipe>(write_end));
+    player.set_speed(0.0);
+    player.set_type(geometry::Twist2DStamped().hash());
+    ASSERT_TRUE(player.play(reader));
+
+    EXPECT_EQ(player.stats().sent, 50u);
+    EXPECT_EQ(player.stats().skipped, 1u);
+    EXPECT_LT(player.stats().elapsed.to_nanoseconds(), 1'000'000'000);
+    std::vector<uint32_t> seqs = read_frames(read_end, 50);
+    ASSERT_EQ(seqs.size(), 50u);
+    EXPECT_EQ(seqs.front(), 50u);
+    EXPECT_EQ(seqs.back(), 99u);
+    std::remove(path.c_str());
+}
+
+TEST(PlayerTest, Stops) {
+    std::string path = temp_path();
+    {
+        Writer writer(path);
+        ASSERT_TRUE(writer.write(make_command(0), at(1000)));
+        ASSERT_TRUE(writer.write(make_command(1), at(61000)));
+        ASSERT_TRUE(writer.close());
+    }
+
+    auto [read_end, write_end] = rix::ipc::Pipe::create();
+    Reader reader(path);
+    Player player(std::make_unique<rix::ipc::Pipe>(write_end));
+    rix::ipc::Signal sig(SIGUSR1);
+    std::thread stopper([&sig] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        sig.raise();
+    });
+    // Stopped while waiting a minute for the second command
+    EXPECT_FALSE(player.play(reader, &sig));
+    stopper.join();
+    EXPECT_EQ(player.stats().sent, 1u);
+    EXPECT_LT(player.stats().elapsed.to_nanoseconds(), 1'000'000'000);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rix/util/binary_log.hpp"
+
+using rix::util::BinaryLog;
+using rix::util::Log;
+
+namespace {
+
+std::string temp_path() { return "/tmp/rix_binary_log_test_" + std::to_string(getpid()) + ".blog"; }
+
+std::vector<std::string> decode(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    std::ostringstream text;
+    EXPECT_TRUE(BinaryLog::decode(file, text));
+
+    std::vector<std::string> lines;
+    std::istringstream stream(text.str());
+    std::string line;
+    while (std::getline(stream, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+// Returns the part of a decoded line after the header
+std::string message(const std::string &line) {
+    size_t position = line.find(": ");
+    return position == std::string::npos ? line : line.substr(position + 2);
+}
+
+}  // namespace
+
+// Test records are decoded with their arguments substituted in order
+TEST(BinaryLogTest, RoundTrip) {
+    std::string path = temp_path();
+    ASSERT_TRUE(BinaryLog::open(path));
+    EXPECT_TRUE(BinaryLog::is_open());
+
+    std::string name = "mbot";
+    for (int i = 0; i < 3; i++) {
+        RIX_BLOG(Log::INFO, "cmd {} vx={} wz={} ok={} name={}", i, 0.25 * i, -1.5, i != 1, name);
+    }
+    RIX_BLOG(Log::WARN, "no arguments");
+    RIX_BLOG(Log::ERROR, "extra", 7u, 'x', "text");
+    ASSERT_TRUE(BinaryLog::close());
+    EXPECT_FALSE(BinaryLog::is_open());
+
+    std::vector<std::string> lines = decode(path);
+    ASSERT_EQ(lines.size(), 5);
+    EXPECT_EQ(message(lines[0]), "cmd 0 vx=0 wz=-1.5 ok=true name=mbot");
+    EXPECT_EQ(message(lines[1]), "cmd 1 vx=0.25 wz=-1.5 ok=false name=mbot");
+    EXPECT_EQ(message(lines[2]), "cmd 2 vx=0.5 wz=-1.5 ok=true name=mbot");
+    EXPECT_NE(lines[0].find("[INFO] binary_log.cpp:"), std::string::npos);
+    EXPECT_EQ(message(lines[3]), "no arguments");
+    EXPECT_NE(lines[3].find("[WARN]"), std::string::npos);
+    EXPECT_EQ(message(lines[4]), "extra 7 x text");
+    unlink(path.c_str());
+}
+
+// Test nothing is written while the log is closed, and sites registered
+// earlier are described again in a new file
+TEST(BinaryLogTest, Reopen) {
+    std::string path = temp_path();
+    auto site = [](int i) { RIX_BLOG(Log::INFO, "value {}", i); };
+
+    site(1);
+    ASSERT_TRUE(BinaryLog::open(path));
+    site(2);
+    ASSERT_TRUE(BinaryLog::open(path));
+    site(3);
+    ASSERT_TRUE(BinaryLog::close());
+    site(4);
+
+    std::vector<std::string> lines = decode(path);
+    ASSERT_EQ(lines.size(), 1);
+    EXPECT_EQ(message(lines[0]), "value 3");
+    unlink(path.c_str());
+}
+
+// Test records from several threads are all written intact
+TEST(BinaryLogTest, Threads) {
+    std::string path = temp_path();
+    ASSERT_TRUE(BinaryLog::open(path));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < 20000; i++) {
+                RIX_BLOG(Log::DEBUG, "thread {} record {}", t, i);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    ASSERT_TRUE(BinaryLog::close());
+
+    std::vector<int> next(4, 0);
+    for (const std::string &line : decode(path)) {
+        int t, i;
+        ASSERT_EQ(std::sscanf(message(line).c_str(), "thread %d record %d", &t, &i), 2) << line;
+        EXPECT_EQ(i, next[t]);
+        next[t] = i + 1;
+    }
+    EXPECT_EQ(next, std::vector<int>(4, 20000));
+    unlink(path.c_str());
+}
+
+// Test full buffers are written in the background and flush waits for the
+// records still buffered, while the log stays open
+TEST(BinaryLogTest, Flush) {
+    std::string path = temp_path();
+    ASSERT_TRUE(BinaryLog::open(path));
+    // About 10 buffers
+    for (int i = 0; i < 20000; i++) {
+        RIX_BLOG(Log::INFO, "record {} of {}", i, 20000);
+    }
+    ASSERT_TRUE(BinaryLog::flush());
+    EXPECT_EQ(BinaryLog::dropped(), 0u);
+
+    std::vector<std::string> lines = decode(path);
+    ASSERT_EQ(lines.size(), 20000);
+    EXPECT_EQ(message(lines.front()), "record 0 of 20000");
+    EXPECT_EQ(message(lines.back()), "record 19999 of 20000");
+
+    RIX_BLOG(Log::INFO, "after flush");
+    ASSERT_TRUE(BinaryLog::close());
+    lines = decode(path);
+    ASSERT_EQ(lines.size(), 20001);
+    EXPECT_EQ(message(lines.back()), "after flush");
+    unlink(path.c_str());
+}
+
+// Test a log truncated in the middle of a record decodes up to that record,
+// and other files are rejected
+TEST(BinaryLogTest, TruncatedAndInvalid) {
+    std::string path = temp_path();
+    ASSERT_TRUE(BinaryLog::open(path));
+    RIX_BLOG(Log::INFO, "first {}", 1);
+    RIX_BLOG(Log::INFO, "second {}", 2);
+    ASSERT_TRUE(BinaryLog::close());
+
+    std::ifstream file(path, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::istringstream truncated(data.substr(0, data.size() - 3));
+    std::ostringstream text;
+    EXPECT_TRUE(BinaryLog::decode(truncated, text));
+    EXPECT_NE(text.str().find("first 1"), std::string::npos);
+    EXPECT_EQ(text.str().find("second"), std::string::npos);
+
+    std::istringstream invalid("not a binary log");
+    EXPECT_FALSE(BinaryLog::decode(invalid, text));
+    unlink(path.c_str());
+}
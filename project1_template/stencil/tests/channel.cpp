@@ -0,0 +1,246 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "rix/ipc/channel.hpp"
+#include "rix/ipc/poller.hpp"
+#include "rix/msg/standard/UInt32.hpp"
+
+using namespace rix::ipc;
+using namespace rix::msg;
+
+namespace {
+
+// Counts serializations to check the intra-process path never serializes
+class CountingUInt32 : public standard::UInt32 {
+   public:
+    inline static int serialized = 0;
+
+    void serialize(uint8_t *dst, size_t &offset) const override {
+        serialized++;
+        standard::UInt32::serialize(dst, offset);
+    }
+};
+
+std::shared_ptr<const CountingUInt32> make_message(uint32_t value) {
+    auto msg = std::make_shared<CountingUInt32>();
+    msg->data = value;
+    return msg;
+}
+
+}  // namespace
+
+TEST(ChannelTest, SharesMessages) {
+    Channel<CountingUInt32> channel;
+    ASSERT_TRUE(channel.ok());
+    auto first = channel.subscribe();
+    auto second = channel.subscribe();
+    EXPECT_EQ(channel.subscribers(), 2u);
+
+    CountingUInt32::serialized = 0;
+    auto msg = make_message(42);
+    channel.publish(msg);
+
+    // Both subscribers receive the published object itself
+    Channel<CountingUInt32>::Ptr received;
+    ASSERT_TRUE(first->take(received));
+    EXPECT_EQ(received.get(), msg.get());
+    ASSERT_TRUE(second->take(received));
+    EXPECT_EQ(received.get(), msg.get());
+    EXPECT_FALSE(first->take(received));
+    EXPECT_EQ(CountingUInt32::serialized, 0);
+}
+
+TEST(ChannelTest, Order) {
+    Channel<CountingUInt32> channel;
+    auto subscription = channel.subscribe(256);
+    for (uint32_t i = 0; i < 200; i++) {
+        channel.publish(make_message(i));
+    }
+    Channel<CountingUInt32>::Ptr msg;
+    for (uint32_t i = 0; i < 200; i++) {
+        ASSERT_TRUE(subscription->take(msg));
+        EXPECT_EQ(msg->data, i);
+    }
+    EXPECT_FALSE(subscription->take(msg));
+}
+
+TEST(ChannelTest, DropPolicies) {
+    Channel<CountingUInt32> channel;
+    auto oldest = channel.subscribe(4, DropPolicy::DROP_OLDEST);
+    auto newest = channel.subscribe(4, DropPolicy::DROP_NEWEST);
+    auto disconnect = channel.subscribe(4, DropPolicy::DISCONNECT);
+
+    auto msg = make_message(11);
+    for (uint32_t i = 0; i < 10; i++) {
+        channel.publish(make_message(i));
+    }
+
+    Channel<CountingUInt32>::Ptr received;
+    ASSERT_TRUE(oldest->take(received));
+    EXPECT_EQ(received->data, 6u);
+    EXPECT_EQ(oldest->dropped(), 6u);
+
+    ASSERT_TRUE(newest->take(received));
+    EXPECT_EQ(received->data, 0u);
+    EXPECT_EQ(newest->dropped(), 6u);
+
+    EXPECT_FALSE(disconnect->connected());
+    for (uint32_t i = 0; i < 4; i++) {
+        ASSERT_TRUE(disconnect->take(received));
+        EXPECT_EQ(received->data, i);
+    }
+    EXPECT_FALSE(disconnect->take(received));
+    EXPECT_EQ(channel.subscribers(), 2u);
+
+    // Dropped messages are released
+    channel.publish(make_message(10));
+    channel.publish(msg);
+    EXPECT_EQ(msg.use_count(), 2);
+}
+
+TEST(ChannelTest, ReleasedSubscription) {
+    Channel<CountingUInt32> channel;
+    auto msg = make_message(1);
+    {
+        auto subscription = channel.subscribe();
+        channel.publish(msg);
+        EXPECT_EQ(msg.use_count(), 2);
+    }
+    // The subscription and its queued messages are released by the next
+    // publish
+    EXPECT_EQ(channel.subscribers(), 0u);
+    channel.publish(make_message(2));
+    EXPECT_EQ(msg.use_count(), 1);
+}
+
+TEST(ChannelTest, TakeEmptiesSlot) {
+    Channel<CountingUInt32> channel;
+    auto subscription = channel.subscribe(4);
+    auto msg = make_message(1);
+
+    // Wrap around the ring a few times, so every slot is reused
+    Channel<CountingUInt32>::Ptr received;
+    for (uint32_t i = 0; i < 10; i++) {
+        channel.publish(msg);
+        EXPECT_EQ(msg.use_count(), 2);
+        ASSERT_TRUE(subscription->take(received));
+        EXPECT_EQ(received.get(), msg.get());
+        // The message is moved out of its slot, the ring keeps no reference
+        EXPECT_EQ(msg.use_count(), 2);
+        received.reset();
+        EXPECT_EQ(msg.use_count(), 1);
+    }
+}
+
+TEST(ChannelTest, PollFreshSubscription) {
+    Channel<CountingUInt32> channel;
+    auto subscription = channel.subscribe();
+
+    // Readable for the first message without a `take` beforehand
+    Poller poller;
+    poller.add(subscription->fd());
+    EXPECT_EQ(poller.wait(rix::util::Duration()), 0);
+    channel.publish(make_message(1));
+    EXPECT_EQ(poller.wait(rix::util::Duration(1.0)), 1);
+
+    Channel<CountingUInt32>::Ptr msg;
+    ASSERT_TRUE(subscription->take(msg));
+    EXPECT_EQ(msg->data, 1u);
+}
+
+TEST(ChannelTest, WaitAndPoll) {
+    Channel<CountingUInt32> channel;
+    auto subscription = channel.subscribe();
+    EXPECT_FALSE(subscription->wait(rix::util::Duration(0.01)));
+
+    std::thread publisher([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        channel.publish(make_message(5));
+    });
+    EXPECT_TRUE(subscription->wait(rix::util::Duration(5.0)));
+    publisher.join();
+
+    Channel<CountingUInt32>::Ptr msg;
+    ASSERT_TRUE(subscription->take(msg));
+    EXPECT_FALSE(subscription->take(msg));
+
+    // The empty take armed the subscription, so the next message wakes a
+    // poller until a take finds the queue empty again
+    Poller poller;
+    poller.add(subscription->fd());
+    EXPECT_EQ(poller.wait(rix::util::Duration()), 0);
+    channel.publish(make_message(6));
+    EXPECT_EQ(poller.wait(rix::util::Duration(1.0)), 1);
+    ASSERT_TRUE(subscription->take(msg));
+    EXPECT_EQ(msg->data, 6u);
+    EXPECT_FALSE(subscription->take(msg));
+    EXPECT_EQ(poller.wait(rix::util::Duration()), 0);
+}
+
+TEST(ChannelTest, Threaded) {
+    Channel<CountingUInt32> channel;
+    auto subscription = channel.subscribe(16, DropPolicy::DROP_OLDEST);
+    constexpr uint32_t count = 100000;
+
+    std::thread publisher([&] {
+        for (uint32_t i = 1; i <= count; i++) {
+            channel.publish(make_message(i));
+        }
+    });
+
+    // Messages may be dropped, but never reordered or duplicated
+    uint32_t last = 0;
+    uint64_t received = 0;
+    Channel<CountingUInt32>::Ptr msg;
+    while (last < count) {
+        if (subscription->take(msg)) {
+            ASSERT_GT(msg->data, last);
+            last = msg->data;
+            received++;
+        }
+    }
+    publisher.join();
+    EXPECT_EQ(received + subscription->dropped(), count);
+}
+
+TEST(ChannelTest, ClosedWithChannel) {
+    auto channel = std::make_unique<Channel<CountingUInt32>>();
+    auto subscription = channel->subscribe();
+    channel->publish(make_message(3));
+    channel.reset();
+
+    EXPECT_FALSE(subscription->connected());
+    EXPECT_TRUE(subscription->wait(rix::util::Duration(1.0)));
+    Channel<CountingUInt32>::Ptr msg;
+    ASSERT_TRUE(subscription->take(msg));
+    EXPECT_EQ(msg->data, 3u);
+}
+
+TEST(ChannelTest, CrossProcessFallback) {
+    Channel<CountingUInt32> channel("test_channel");
+    ASSERT_TRUE(channel.ok());
+    auto local = channel.subscribe();
+
+    // Without remote subscribers nothing is serialized
+    CountingUInt32::serialized = 0;
+    channel.publish(make_message(1));
+    EXPECT_EQ(CountingUInt32::serialized, 0);
+
+    Subscriber<standard::UInt32> remote("test_channel");
+    ASSERT_TRUE(remote.ok());
+    channel.publish(make_message(2));
+    EXPECT_EQ(CountingUInt32::serialized, 1);
+
+    standard::UInt32 msg;
+    ASSERT_TRUE(remote.take(msg));
+    EXPECT_EQ(msg.data, 2u);
+
+    Channel<CountingUInt32>::Ptr received;
+    ASSERT_TRUE(local->take(received));
+    EXPECT_EQ(received->data, 1u);
+    ASSERT_TRUE(local->take(received));
+    EXPECT_EQ(received->data, 2u);
+}
@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+
+#include "rix/util/fast_clock.hpp"
+
+using rix::util::Duration;
+using rix::util::FastClock;
+using rix::util::SteadyTime;
+
+// Test the first use after init does not calibrate again
+TEST(FastClockTest, Init) {
+    FastClock::init();
+    SteadyTime before = SteadyTime::now();
+    FastClock::to_nanoseconds(FastClock::now());
+    EXPECT_LT(SteadyTime::now() - before, Duration(0.001));
+}
+
+// Test ticks never go backwards
+TEST(FastClockTest, Monotonic) {
+    FastClock::Ticks last = FastClock::now();
+    for (int i = 0; i < 100000; i++) {
+        FastClock::Ticks t = FastClock::now();
+        EXPECT_GE(t, last);
+        last = t;
+    }
+    EXPECT_GE(FastClock::now_ordered(), last);
+}
+
+// Test the calibrated frequency is sane and TSC use follows invariant TSC
+TEST(FastClockTest, Calibration) {
+    EXPECT_GT(FastClock::frequency(), 1e8);
+    EXPECT_LT(FastClock::frequency(), 1e10);
+    if (!FastClock::invariant_tsc()) {
+        EXPECT_FALSE(FastClock::uses_tsc());
+        EXPECT_DOUBLE_EQ(FastClock::frequency(), 1e9);
+    }
+}
+
+// Test elapsed ticks agree with the monotonic clock
+TEST(FastClockTest, AgreesWithMonotonicClock) {
+    SteadyTime steady_start = SteadyTime::now();
+    FastClock::Ticks start = FastClock::now();
+    rix::util::sleep_for(Duration(0.05));
+    FastClock::Ticks end = FastClock::now_ordered();
+    Duration steady = SteadyTime::now() - steady_start;
+
+    Duration fast = FastClock::elapsed(start, end);
+    EXPECT_NEAR(fast.to_nanoseconds(), steady.to_nanoseconds(), 1'000'000);
+    EXPECT_NEAR(FastClock::to_steady_time(end).to_nanoseconds(), SteadyTime::now().to_nanoseconds(), 1'000'000);
+}
+
+// Test conversions
+TEST(FastClockTest, Conversions) {
+    EXPECT_EQ(FastClock::to_nanoseconds(0), 0);
+    EXPECT_EQ(FastClock::elapsed(10, 5), Duration());
+    FastClock::Ticks one_second = static_cast<FastClock::Ticks>(FastClock::frequency());
+    EXPECT_NEAR(FastClock::to_duration(one_second).to_nanoseconds(), 1'000'000'000, 1000);
+}
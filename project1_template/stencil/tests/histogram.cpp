@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+
+#include "rix/util/histogram.hpp"
+#include "rix/util/time.hpp"
+
+using rix::util::Duration;
+using rix::util::Histogram;
+
+// Test an empty histogram
+TEST(HistogramTest, Empty) {
+    Histogram h;
+    EXPECT_EQ(h.count(), 0);
+    EXPECT_EQ(h.min(), 0);
+    EXPECT_EQ(h.max(), 0);
+    EXPECT_EQ(h.mean(), 0.0);
+    EXPECT_EQ(h.percentile(50), 0);
+}
+
+// Test small values are recorded exactly
+TEST(HistogramTest, SmallValuesExact) {
+    Histogram h;
+    for (int64_t i = 1; i <= 20; i++) {
+        h.record(i);
+    }
+    EXPECT_EQ(h.count(), 20);
+    EXPECT_EQ(h.min(), 1);
+    EXPECT_EQ(h.max(), 20);
+    EXPECT_DOUBLE_EQ(h.mean(), 10.5);
+    EXPECT_EQ(h.percentile(50), 10);
+    EXPECT_EQ(h.percentile(100), 20);
+    EXPECT_EQ(h.percentile(0), 1);
+}
+
+// Test large values stay within the relative error bound
+TEST(HistogramTest, LargeValuesWithinRelativeError) {
+    Histogram h;
+    for (int64_t i = 1; i <= 1000; i++) {
+        h.record(i * 1'000'000);
+    }
+    int64_t p50 = h.percentile(50);
+    int64_t p99 = h.percentile(99);
+    EXPECT_NEAR(p50, 500'000'000, 500'000'000 / 32);
+    EXPECT_NEAR(p99, 990'000'000, 990'000'000 / 32);
+    EXPECT_EQ(h.percentile(100), 1'000'000'000);
+}
+
+// Test negative values and durations
+TEST(HistogramTest, NegativeAndDuration) {
+    Histogram h;
+    h.record(-5);
+    h.record(Duration(0.001));
+    EXPECT_EQ(h.min(), 0);
+    EXPECT_EQ(h.max(), 1'000'000);
+    EXPECT_EQ(h.count(), 2);
+}
+
+// Test recording with a count
+TEST(HistogramTest, RecordCount) {
+    Histogram h;
+    h.record(7, 9);
+    h.record(1000, 1);
+    EXPECT_EQ(h.count(), 10);
+    EXPECT_EQ(h.percentile(90), 7);
+    EXPECT_NEAR(h.percentile(100), 1000, 1000 / 32);
+}
+
+// Test merge and reset
+TEST(HistogramTest, MergeAndReset) {
+    Histogram a;
+    Histogram b;
+    a.record(10);
+    b.record(30);
+    b.record(20);
+    a.merge(b);
+    EXPECT_EQ(a.count(), 3);
+    EXPECT_EQ(a.min(), 10);
+    EXPECT_EQ(a.max(), 30);
+    EXPECT_EQ(a.percentile(50), 20);
+
+    Histogram c(a);
+    a.reset();
+    EXPECT_EQ(a.count(), 0);
+    EXPECT_EQ(c.count(), 3);
+}
+
+// Test the maximum value is representable
+TEST(HistogramTest, MaxValue) {
+    Histogram h;
+    h.record(std::numeric_limits<int64_t>::max());
+    EXPECT_EQ(h.percentile(50), std::numeric_limits<int64_t>::max());
+}
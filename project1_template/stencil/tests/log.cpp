@@ -0,0 +1,315 @@
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rix/util/log.hpp"
+
+using rix::util::Log;
+using rix::util::detail::TeeBuffer;
+
+namespace {
+
+std::vector<std::string> lines(const std::string &text) {
+    std::vector<std::string> result;
+    std::istringstream stream(text);
+    std::string line;
+    while (std::getline(stream, line)) {
+        result.push_back(line);
+    }
+    return result;
+}
+
+int evaluations = 0;
+
+int evaluate() { return ++evaluations; }
+
+std::string read_all(int fd) {
+    std::string result;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+        result.append(buffer, n);
+    }
+    return result;
+}
+
+// Counts the calls to `overflow`, which only happen when the put area is full
+class CountingTeeBuffer : public TeeBuffer {
+   public:
+    using TeeBuffer::TeeBuffer;
+
+    int overflows = 0;
+
+   protected:
+    int overflow(int c) override {
+        overflows++;
+        return TeeBuffer::overflow(c);
+    }
+};
+
+}  // namespace
+
+// Test a TeeBuffer holds data until it is flushed, then writes the same bytes
+// to every target
+TEST(TeeBufferTest, Targets) {
+    int fds[2];
+    ASSERT_EQ(pipe2(fds, O_NONBLOCK), 0);
+    std::stringbuf copy;
+    TeeBuffer buffer(fds[1]);
+    buffer.add(&copy);
+    std::ostream stream(&buffer);
+
+    stream << "value " << 42 << " " << 1.5 << '\n';
+    EXPECT_EQ(read_all(fds[0]), "");
+    EXPECT_EQ(copy.str(), "");
+    stream << std::flush;
+    EXPECT_EQ(read_all(fds[0]), "value 42 1.5\n");
+    EXPECT_EQ(copy.str(), "value 42 1.5\n");
+
+    // Spans that do not fit are written along with the buffered data
+    std::string large(TeeBuffer::buffer_size + 100, 'x');
+    stream << "head ";
+    stream.write(large.data(), large.size());
+    EXPECT_EQ(read_all(fds[0]), "head " + large);
+    stream << "tail" << std::flush;
+    EXPECT_EQ(copy.str(), "value 42 1.5\nhead " + large + "tail");
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+// Test many small writes are forwarded whenever the buffer fills up
+TEST(TeeBufferTest, Overflow) {
+    int fds[2];
+    ASSERT_EQ(pipe2(fds, O_NONBLOCK), 0);
+    std::string expected;
+    std::string written;
+    {
+        TeeBuffer buffer(fds[1]);
+        std::ostream stream(&buffer);
+        for (int i = 0; i < 2000; i++) {
+            stream << i << ',';
+            expected += std::to_string(i) + ",";
+        }
+        written = read_all(fds[0]);
+        EXPECT_GE(written.size(), TeeBuffer::buffer_size);
+        EXPECT_LT(written.size(), expected.size());
+    }
+    // The rest is flushed when the buffer is destroyed
+    close(fds[1]);
+    written += read_all(fds[0]);
+    EXPECT_EQ(written, expected);
+    close(fds[0]);
+}
+
+// Test characters, numbers and std::endl are written into the put area
+// without calling overflow until it is full
+TEST(TeeBufferTest, PutArea) {
+    std::stringbuf copy;
+    CountingTeeBuffer buffer(std::vector<std::streambuf *>{&copy});
+    std::ostream stream(&buffer);
+
+    stream << "value " << 42 << ' ' << 1.5 << std::endl;
+    EXPECT_EQ(buffer.overflows, 0);
+    EXPECT_EQ(copy.str(), "value 42 1.5\n");
+
+    for (size_t i = 0; i < TeeBuffer::buffer_size; i++) {
+        stream.put('x');
+    }
+    EXPECT_EQ(buffer.overflows, 0);
+    stream.put('y');
+    EXPECT_EQ(buffer.overflows, 1);
+    stream << std::flush;
+    EXPECT_EQ(copy.str(), "value 42 1.5\n" + std::string(TeeBuffer::buffer_size, 'x') + "y");
+}
+
+// Test synchronous records logged from several threads are written whole
+TEST(LogTest, SyncThreads) {
+    testing::internal::CaptureStdout();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < 200; i++) {
+                Log::info << "thread " << t << " record " << i << std::endl;
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    std::string output = testing::internal::GetCapturedStdout();
+
+    std::map<int, int> next;
+    std::vector<std::string> result = lines(output);
+    EXPECT_EQ(result.size(), 800u);
+    for (const std::string &line : result) {
+        size_t position = line.find("thread ");
+        ASSERT_NE(position, std::string::npos) << line;
+        EXPECT_NE(line.find("INFO"), std::string::npos) << line;
+        int t, i;
+        ASSERT_EQ(std::sscanf(line.c_str() + position, "thread %d record %d", &t, &i), 2) << line;
+        EXPECT_EQ(i, next[t]) << line;
+        next[t] = i + 1;
+    }
+}
+
+// Test synchronous records are written to stdout when flushed
+TEST(LogTest, Sync) {
+    testing::internal::CaptureStdout();
+    Log::warn << "sync " << 1 << std::endl;
+    std::string output = testing::internal::GetCapturedStdout();
+
+    std::vector<std::string> result = lines(output);
+    ASSERT_EQ(result.size(), 1);
+    EXPECT_NE(result[0].find("WARN"), std::string::npos);
+    EXPECT_NE(result[0].find("sync 1"), std::string::npos);
+}
+
+// Test records logged from several threads are all written, each with a
+// header, and in order per thread
+TEST(LogTest, Async) {
+    testing::internal::CaptureStdout();
+    Log::start_async();
+    EXPECT_TRUE(Log::is_async());
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < 1000; i++) {
+                Log::info << "thread " << t << " record " << i << std::endl;
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    Log::warn << "last" << std::endl;
+    Log::stop_async();
+    EXPECT_FALSE(Log::is_async());
+    std::string output = testing::internal::GetCapturedStdout();
+
+    std::map<int, int> next;
+    int total = 0;
+    for (const std::string &line : lines(output)) {
+        size_t position = line.find("thread ");
+        if (position == std::string::npos) {
+            continue;
+        }
+        EXPECT_NE(line.find("INFO"), std::string::npos) << line;
+        int t, i;
+        ASSERT_EQ(std::sscanf(line.c_str() + position, "thread %d record %d", &t, &i), 2) << line;
+        EXPECT_EQ(i, next[t]) << line;
+        next[t] = i + 1;
+        total++;
+    }
+    EXPECT_EQ(total + Log::dropped(), 4000);
+    EXPECT_NE(output.find("last"), std::string::npos);
+}
+
+// Test a record is split at a flush and continued without a new header
+TEST(LogTest, AsyncContinuation) {
+    testing::internal::CaptureStdout();
+    Log::start_async();
+    Log::info << "first " << std::flush << "second" << std::endl;
+    Log::stop_async();
+    std::string output = testing::internal::GetCapturedStdout();
+
+    std::vector<std::string> result = lines(output);
+    ASSERT_EQ(result.size(), 1);
+    EXPECT_NE(result[0].find("INFO"), std::string::npos);
+    EXPECT_NE(result[0].find("first second"), std::string::npos);
+}
+
+// Test the writer stopped at exit still writes the main thread's last record,
+// which its buffer queued when it was destroyed
+TEST(LogDeathTest, AsyncStoppedAtExit) {
+    EXPECT_EXIT(
+        {
+            // Death tests only capture stderr
+            ::dup2(STDERR_FILENO, STDOUT_FILENO);
+            Log::start_async();
+            // Not flushed, so only the buffer's destructor queues it
+            Log::info << "logged before exit\n";
+            std::exit(0);
+        },
+        testing::ExitedWithCode(0), "logged before exit");
+}
+
+// Test the runtime level filters records and skips formatting their arguments
+TEST(LogTest, RuntimeLevel) {
+    EXPECT_TRUE(Log::enabled(Log::DEBUG));  // Compiled in, selected at runtime
+    EXPECT_TRUE(Log::is_enabled(Log::INFO));
+
+    testing::internal::CaptureStdout();
+    Log::set_level(Log::WARN);
+    EXPECT_EQ(Log::level(), Log::WARN);
+    EXPECT_FALSE(Log::debug.enabled());
+    EXPECT_FALSE(Log::info.enabled());
+    EXPECT_FALSE(Log::is_enabled(Log::INFO));
+    Log::info << "hidden " << 1 << std::endl;
+    Log::warn << "shown " << 2 << std::endl;
+    Log::set_level(Log::DEBUG);
+    Log::info << "shown " << 3 << std::endl;
+    std::string output = testing::internal::GetCapturedStdout();
+
+    EXPECT_EQ(output.find("hidden"), std::string::npos);
+    EXPECT_NE(output.find("shown 2"), std::string::npos);
+    EXPECT_NE(output.find("shown 3"), std::string::npos);
+}
+
+// Test a signal switches between the current level and the toggle level
+TEST(LogTest, ToggleOnSignal) {
+    Log::set_level(Log::INFO);
+    ASSERT_TRUE(Log::toggle_level_on_signal(SIGUSR2, Log::ERROR));
+    raise(SIGUSR2);
+    EXPECT_EQ(Log::level(), Log::ERROR);
+    raise(SIGUSR2);
+    EXPECT_EQ(Log::level(), Log::INFO);
+    signal(SIGUSR2, SIG_DFL);
+    Log::set_level(Log::DEBUG);
+}
+
+// Test rate limited statements log the first and every nth execution, and do
+// not evaluate their arguments otherwise
+TEST(LogTest, EveryN) {
+    testing::internal::CaptureStdout();
+    evaluations = 0;
+    for (int i = 0; i < 10; i++) {
+        RIX_LOG_EVERY_N(info, 3) << "every " << i << " " << evaluate() << std::endl;
+    }
+    Log::set_level(Log::WARN);
+    for (int i = 0; i < 10; i++) {
+        RIX_LOG_EVERY_N(info, 1) << "disabled " << evaluate() << std::endl;
+    }
+    Log::set_level(Log::DEBUG);
+    std::string output = testing::internal::GetCapturedStdout();
+
+    EXPECT_EQ(evaluations, 4);
+    std::vector<std::string> result = lines(output);
+    ASSERT_EQ(result.size(), 4);
+    for (int i = 0; i < 4; i++) {
+        EXPECT_NE(result[i].find("every " + std::to_string(3 * i)), std::string::npos) << result[i];
+    }
+}
+
+TEST(LogTest, EveryT) {
+    testing::internal::CaptureStdout();
+    rix::util::Time start = rix::util::Time::now();
+    int logged = 0;
+    while (rix::util::Time::now() - start < rix::util::Duration(0.25)) {
+        RIX_LOG_EVERY_T(info, 0.1) << "tick " << ++logged << std::endl;
+    }
+    std::string output = testing::internal::GetCapturedStdout();
+
+    EXPECT_GE(logged, 2);
+    EXPECT_LE(logged, 3);
+    EXPECT_EQ(lines(output).size(), logged);
+}
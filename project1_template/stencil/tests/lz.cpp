@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "rix/util/lz.hpp"
+
+namespace lz = rix::util::lz;
+
+namespace {
+
+std::vector<uint8_t> compress(const std::vector<uint8_t> &data) {
+    std::vector<uint8_t> compressed(lz::compress_bound(data.size()));
+    compressed.resize(lz::compress(data.data(), data.size(), compressed.data()));
+    return compressed;
+}
+
+void expect_round_trip(const std::vector<uint8_t> &data) {
+    std::vector<uint8_t> compressed = compress(data);
+    EXPECT_LE(compressed.size(), lz::compress_bound(data.size()));
+    std::vector<uint8_t> decompressed(data.size());
+    ASSERT_TRUE(lz::decompress(compressed.data(), compressed.size(), decompressed.data(), decompressed.size()));
+    EXPECT_EQ(decompressed, data);
+}
+
+std::vector<uint8_t> random_bytes(size_t size, uint32_t seed) {
+    std::mt19937 generator(seed);
+    std::vector<uint8_t> data(size);
+    for (uint8_t &byte : data) {
+        byte = generator();
+    }
+    return data;
+}
+
+}  // namespace
+
+TEST(LzTest, Small) {
+    expect_round_trip({});
+    expect_round_trip({42});
+    expect_round_trip({1, 2, 3, 4, 1, 2, 3, 4, 1, 2, 3, 4, 1});
+}
+
+TEST(LzTest, Repetitive) {
+    std::string text;
+    for (int i = 0; i < 1000; i++) {
+        text += "vx=0.25 vy=0.00 wz=" + std::to_string(i % 7) + "\n";
+    }
+    std::vector<uint8_t> data(text.begin(), text.end());
+    expect_round_trip(data);
+    EXPECT_LT(compress(data).size(), data.size() / 10);
+
+    // Long runs use extended lengths and overlapping matches
+    expect_round_trip(std::vector<uint8_t>(100000, 7));
+    EXPECT_LT(compress(std::vector<uint8_t>(100000, 7)).size(), 500u);
+}
+
+TEST(LzTest, Incompressible) {
+    for (size_t size : {15, 300, 70000}) {
+        std::vector<uint8_t> data = random_bytes(size, size);
+        expect_round_trip(data);
+    }
+}
+
+TEST(LzTest, Mixed) {
+    // Repeats further apart than the largest offset, mixed with noise
+    std::vector<uint8_t> block = random_bytes(1000, 1);
+    std::vector<uint8_t> data;
+    for (int i = 0; i < 200; i++) {
+        data.insert(data.end(), block.begin(), block.end());
+        std::vector<uint8_t> noise = random_bytes(i * 7 % 500, i);
+        data.insert(data.end(), noise.begin(), noise.end());
+    }
+    expect_round_trip(data);
+}
+
+TEST(LzTest, Corrupted) {
+    std::string text;
+    for (int i = 0; i < 100; i++) {
+        text += "hello world " + std::to_string(i);
+    }
+    std::vector<uint8_t> data(text.begin(), text.end());
+    std::vector<uint8_t> compressed = compress(data);
+    std::vector<uint8_t> output(data.size());
+
+    // Wrong size
+    EXPECT_FALSE(lz::decompress(compressed.data(), compressed.size(), output.data(), output.size() - 1));
+    output.resize(data.size() + 1);
+    EXPECT_FALSE(lz::decompress(compressed.data(), compressed.size(), output.data(), output.size()));
+    output.resize(data.size());
+
+    // Truncated
+    EXPECT_FALSE(lz::decompress(compressed.data(), compressed.size() / 2, output.data(), output.size()));
+
+    // Every single-byte change either fails or stays within the output
+    for (size_t i = 0; i < compressed.size(); i++) {
+        std::vector<uint8_t> damaged = compressed;
+        damaged[i] ^= 0xff;
+        lz::decompress(damaged.data(), damaged.size(), output.data(), output.size());
+    }
+
+    // An offset before the start of the output
+    const uint8_t bad_offset[] = {0x10, 'a', 0x05, 0x00, 0x00};
+    output.resize(6);
+    EXPECT_FALSE(lz::decompress(bad_offset, sizeof(bad_offset), output.data(), output.size()));
+}
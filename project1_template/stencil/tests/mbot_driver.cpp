@@ -0,0 +1,239 @@
+#include <gtest/gtest.h>
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "mbot/mbot_base.hpp"
+#include "mbot_driver/mbot_driver.hpp"
+#include "rix/ipc/pipe.hpp"
+#include "rix/ipc/signal.hpp"
+#include "rix/msg/geometry/Twist2DStamped.hpp"
+#include "rix/msg/standard/UInt32.hpp"
+#include "rix/util/time.hpp"
+
+using namespace rix::ipc;
+using namespace rix::msg;
+using rix::util::Duration;
+using rix::util::SteadyTime;
+
+namespace {
+
+// A command received by the mock MBot and when it was received
+struct Drive {
+    geometry::Twist2DStamped cmd;
+    SteadyTime at;
+};
+
+// Commands received by `MockMBot`, shared with the test since the driver owns
+// the MBot
+struct DriveLog {
+    std::vector<Drive> drives() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return log;
+    }
+
+    mutable std::mutex mutex;
+    std::vector<Drive> log;
+};
+
+class MockMBot : public MBotBase {
+   public:
+    MockMBot(std::shared_ptr<DriveLog> log) : log(log) {}
+
+    bool ok() const override { return true; }
+
+    void drive(const Twist2DStamped &cmd) const override {
+        std::lock_guard<std::mutex> lock(log->mutex);
+        log->log.push_back({cmd, SteadyTime::now()});
+    }
+
+   private:
+    std::shared_ptr<DriveLog> log;
+};
+
+// An input that is always readable and whose reads fail
+class FailingInput : public interfaces::IO {
+   public:
+    ssize_t read(uint8_t *, size_t) const override {
+        errno = EIO;
+        return -1;
+    }
+    ssize_t write(const uint8_t *, size_t len) const override { return len; }
+    bool wait_for_writable(const Duration &) const override { return true; }
+    bool wait_for_readable(const Duration &) const override { return true; }
+    void set_nonblocking(bool) override {}
+    bool is_nonblocking() const override { return false; }
+};
+
+geometry::Twist2DStamped make_command(uint32_t seq, float vx) {
+    geometry::Twist2DStamped cmd;
+    cmd.header.seq = seq;
+    cmd.twist.vx = vx;
+    return cmd;
+}
+
+// Appends `cmd` to `frames` with its size prefix
+void append_frame(std::vector<uint8_t> &frames, const geometry::Twist2DStamped &cmd) {
+    standard::UInt32 size;
+    size.data = cmd.size();
+    size_t offset = frames.size();
+    frames.resize(offset + size.size() + cmd.size());
+    size.serialize(frames.data(), offset);
+    cmd.serialize(frames.data(), offset);
+}
+
+void send(const Pipe &pipe, const geometry::Twist2DStamped &cmd) {
+    std::vector<uint8_t> frame;
+    append_frame(frame, cmd);
+    ASSERT_EQ(pipe.write(frame.data(), frame.size()), static_cast<ssize_t>(frame.size()));
+}
+
+// Runs a driver reading from a pipe until `stop` is called
+class DriverTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        auto [read_end, write_end] = Pipe::create();
+        input = write_end;
+        log = std::make_shared<DriveLog>();
+        driver = std::make_unique<MBotDriver>(std::make_unique<Pipe>(read_end), std::make_unique<MockMBot>(log));
+        driver->set_report_period(Duration());
+    }
+
+    void start() {
+        auto sig = std::make_unique<Signal>(SIGUSR1);
+        stop_signal = sig.get();
+        thread = std::thread([this, sig = std::move(sig)]() mutable { driver->spin(std::move(sig)); });
+    }
+
+    void stop() {
+        stop_signal->raise();
+        thread.join();
+    }
+
+    Pipe input;
+    std::shared_ptr<DriveLog> log;
+    std::unique_ptr<MBotDriver> driver;
+    Signal *stop_signal;
+    std::thread thread;
+};
+
+}  // namespace
+
+// Test commands that arrive within one send period are coalesced to the newest
+TEST_F(DriverTest, CoalescesBurst) {
+    driver->set_max_rate(10.0);
+    start();
+
+    // The first command is sent right away and opens a 100 ms period
+    send(input, make_command(0, 0.1f));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::vector<uint8_t> burst;
+    for (uint32_t seq = 1; seq <= 5; seq++) {
+        append_frame(burst, make_command(seq, 0.1f * (seq + 1)));
+    }
+    ASSERT_EQ(input.write(burst.data(), burst.size()), static_cast<ssize_t>(burst.size()));
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    stop();
+
+    // Both commands, then the stop on exit
+    std::vector<Drive> drives = log->drives();
+    ASSERT_EQ(drives.size(), 3u);
+    EXPECT_EQ(drives[0].cmd.header.seq, 0u);
+    EXPECT_EQ(drives[1].cmd.header.seq, 5u);
+    EXPECT_FLOAT_EQ(drives[1].cmd.twist.vx, 0.6f);
+    // Send slots are on a grid that starts with `spin`, shortly before the
+    // first command arrived
+    EXPECT_GE(drives[1].at - drives[0].at, Duration(0.075));
+    EXPECT_FLOAT_EQ(drives[2].cmd.twist.vx, 0.0f);
+
+    EXPECT_EQ(driver->stats().received, 6u);
+    EXPECT_EQ(driver->stats().sent, 2u);
+    EXPECT_EQ(driver->stats().coalesced, 4u);
+}
+
+// Test commands arriving faster than max_rate are sent at most once per period
+TEST_F(DriverTest, LimitsRate) {
+    driver->set_max_rate(20.0);
+    start();
+
+    // 200 Hz for 300 ms
+    for (uint32_t seq = 0; seq < 60; seq++) {
+        send(input, make_command(seq, 0.5f));
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    stop();
+
+    std::vector<Drive> drives = log->drives();
+    ASSERT_GE(drives.size(), 2u);
+    drives.pop_back();  // The stop on exit
+    // About 6 periods in 300 ms, and the last command is never lost
+    EXPECT_GE(drives.size(), 4u);
+    EXPECT_LE(drives.size(), 9u);
+    EXPECT_EQ(drives.back().cmd.header.seq, 59u);
+    for (size_t i = 1; i < drives.size(); i++) {
+        EXPECT_GE(drives[i].at - drives[i - 1].at, Duration(0.04)) << "between sends " << i - 1 << " and " << i;
+        EXPECT_GT(drives[i].cmd.header.seq, drives[i - 1].cmd.header.seq);
+    }
+
+    const MBotDriver::Stats &stats = driver->stats();
+    EXPECT_EQ(stats.received, 60u);
+    EXPECT_EQ(stats.sent, drives.size());
+    EXPECT_EQ(stats.sent + stats.coalesced, stats.received);
+}
+
+// Test the MBot is stopped once commands stop arriving for the timeout
+TEST_F(DriverTest, StopsOnTimeout) {
+    driver->set_command_timeout(Duration(0.1));
+    start();
+
+    // Commands every 50 ms keep the watchdog from firing
+    for (uint32_t seq = 0; seq < 6; seq++) {
+        send(input, make_command(seq, 0.5f));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    EXPECT_EQ(driver->stats().timeouts, 0u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    stop();
+
+    // Every command, the stop on timeout, then the stop on exit
+    std::vector<Drive> drives = log->drives();
+    ASSERT_EQ(drives.size(), 8u);
+    EXPECT_EQ(drives[5].cmd.header.seq, 5u);
+    EXPECT_FLOAT_EQ(drives[5].cmd.twist.vx, 0.5f);
+    EXPECT_FLOAT_EQ(drives[6].cmd.twist.vx, 0.0f);
+    EXPECT_GE(drives[6].at - drives[5].at, Duration(0.1));
+    EXPECT_LT(drives[6].at - drives[5].at, Duration(0.2));
+    EXPECT_EQ(driver->stats().timeouts, 1u);
+}
+
+// Test the watchdog does not repeat the stop while the MBot is stopped
+TEST_F(DriverTest, TimeoutStopsOnce) {
+    driver->set_command_timeout(Duration(0.05));
+    start();
+
+    send(input, make_command(0, 0.5f));
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    stop();
+
+    std::vector<Drive> drives = log->drives();
+    ASSERT_EQ(drives.size(), 3u);
+    EXPECT_FLOAT_EQ(drives[1].cmd.twist.vx, 0.0f);
+    EXPECT_EQ(driver->stats().timeouts, 1u);
+}
+
+// Test a read error other than EAGAIN or EINTR stops the MBot and ends spin
+TEST(DriverErrorTest, StopsOnReadError) {
+    auto log = std::make_shared<DriveLog>();
+    MBotDriver driver(std::make_unique<FailingInput>(), std::make_unique<MockMBot>(log));
+    driver.spin(std::make_unique<Signal>(SIGUSR1));
+
+    std::vector<Drive> drives = log->drives();
+    ASSERT_EQ(drives.size(), 1u);
+    EXPECT_FLOAT_EQ(drives[0].cmd.twist.vx, 0.0f);
+}
@@ -110,3 +110,13 @@ TEST(PipeTest, ReadEndCannotWrite) {
     ssize_t result = reader.write(reinterpret_cast<const uint8_t*>(msg.data()), msg.size());
     EXPECT_EQ(result, -1);  // Should fail
 }
+
+// Test the read end is readable (EOF) once the write end is closed
+TEST(PipeTest, ReadEndReadableAfterWriterCloses) {
+    auto [reader, writer] = Pipe::create();
+    EXPECT_FALSE(reader.is_readable());
+    { Pipe closed(std::move(writer)); }
+    EXPECT_TRUE(reader.wait_for_readable(rix::util::Duration(0.1)));
+    uint8_t byte;
+    EXPECT_EQ(reader.read(&byte, 1), 0);
+}
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+
+#include "rix/ipc/pipe.hpp"
+#include "rix/ipc/poller.hpp"
+#include "rix/ipc/signal.hpp"
+
+using namespace rix::ipc;
+
+// Test wait times out when nothing is ready
+TEST(PollerTest, TimeoutWhenNothingReady) {
+    auto [reader, writer] = Pipe::create();
+    Poller poller;
+    size_t index = poller.add(reader.fd());
+    EXPECT_EQ(poller.size(), 1);
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(poller.wait(rix::util::Duration(0.02)), 0);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+    EXPECT_FALSE(poller.ready(index));
+}
+
+// Test only the file descriptors with pending data are ready
+TEST(PollerTest, ReportsReadyDescriptors) {
+    auto [reader1, writer1] = Pipe::create();
+    auto [reader2, writer2] = Pipe::create();
+    Poller poller;
+    size_t first = poller.add(reader1.fd());
+    size_t second = poller.add(reader2.fd());
+
+    uint8_t byte = 1;
+    writer2.write(&byte, 1);
+    EXPECT_EQ(poller.wait(rix::util::Duration::max()), 1);
+    EXPECT_FALSE(poller.ready(first));
+    EXPECT_TRUE(poller.ready(second));
+}
+
+// Test wait wakes up as soon as data arrives
+TEST(PollerTest, WakesOnData) {
+    auto [reader, writer] = Pipe::create();
+    Poller poller;
+    size_t index = poller.add(reader.fd());
+
+    std::thread writer_thread([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        uint8_t byte = 1;
+        writer.write(&byte, 1);
+    });
+
+    EXPECT_EQ(poller.wait(rix::util::Duration(5.0)), 1);
+    EXPECT_TRUE(poller.ready(index));
+    writer_thread.join();
+}
+
+// Test a hang-up is reported as ready
+TEST(PollerTest, HangupIsReady) {
+    auto [reader, writer] = Pipe::create();
+    Poller poller;
+    size_t index = poller.add(reader.fd());
+    { Pipe closed(std::move(writer)); }
+    EXPECT_EQ(poller.wait(rix::util::Duration(0.0)), 1);
+    EXPECT_TRUE(poller.ready(index));
+}
+
+// Test disabled and invalid descriptors are ignored
+TEST(PollerTest, DisabledAndInvalidDescriptorsIgnored) {
+    auto [reader, writer] = Pipe::create();
+    Poller poller;
+    size_t invalid = poller.add(-1);
+    size_t index = poller.add(reader.fd());
+    poller.disable(index);
+
+    uint8_t byte = 1;
+    writer.write(&byte, 1);
+    EXPECT_EQ(poller.wait(rix::util::Duration(0.0)), 0);
+    EXPECT_FALSE(poller.ready(invalid));
+    EXPECT_FALSE(poller.ready(index));
+}
+
+// Test a Signal can be waited on through its file descriptor
+TEST(PollerTest, WaitsOnSignal) {
+    Signal sig(SIGUSR1);
+    ASSERT_GE(sig.fd(), 0);
+    Poller poller;
+    size_t index = poller.add(sig.fd());
+
+    EXPECT_EQ(poller.wait(rix::util::Duration(0.0)), 0);
+    EXPECT_TRUE(sig.raise());
+    EXPECT_EQ(poller.wait(rix::util::Duration(1.0)), 1);
+    EXPECT_TRUE(poller.ready(index));
+    EXPECT_TRUE(sig.wait(rix::util::Duration(0.0)));
+    EXPECT_EQ(poller.wait(rix::util::Duration(0.0)), 0);
+}
@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rix/ipc/shm_ring.hpp"
+
+using namespace rix::ipc;
+
+namespace {
+
+bool push_string(const ShmRing &ring, const std::string &value, bool overwrite = false) {
+    return ring.push(value.data(), value.size(), overwrite);
+}
+
+std::string pop_string(const ShmRing &ring) {
+    std::vector<uint8_t> record;
+    if (!ring.pop(record)) {
+        return "";
+    }
+    return std::string(record.begin(), record.end());
+}
+
+}  // namespace
+
+TEST(SharedMemoryTest, CreateAndShare) {
+    SharedMemory memory = SharedMemory::create("test", 4096);
+    ASSERT_TRUE(memory.ok());
+    EXPECT_EQ(memory.size(), 4096u);
+    EXPECT_EQ(memory.data()[0], 0);
+
+    // A second mapping of the same file sees the same bytes
+    SharedMemory copy(memory);
+    ASSERT_TRUE(copy.ok());
+    EXPECT_NE(copy.data(), memory.data());
+    std::strcpy(reinterpret_cast<char *>(memory.data()), "shared");
+    EXPECT_STREQ(reinterpret_cast<char *>(copy.data()), "shared");
+
+    SharedMemory moved(std::move(copy));
+    EXPECT_FALSE(copy.ok());
+    EXPECT_EQ(copy.data(), nullptr);
+    EXPECT_STREQ(reinterpret_cast<char *>(moved.data()), "shared");
+}
+
+TEST(SharedMemoryTest, EmptyFileIsInvalid) {
+    SharedMemory memory = SharedMemory::create("empty", 0);
+    EXPECT_FALSE(memory.ok());
+}
+
+TEST(ShmRingTest, PushPop) {
+    ShmRing ring = ShmRing::create(1024);
+    ASSERT_TRUE(ring.ok());
+    EXPECT_EQ(ring.capacity(), 1024u);
+    EXPECT_TRUE(ring.empty());
+
+    EXPECT_TRUE(push_string(ring, "first"));
+    EXPECT_TRUE(push_string(ring, "second"));
+    EXPECT_FALSE(ring.empty());
+    EXPECT_EQ(pop_string(ring), "first");
+    EXPECT_EQ(pop_string(ring), "second");
+    EXPECT_TRUE(ring.empty());
+
+    std::vector<uint8_t> record;
+    EXPECT_FALSE(ring.pop(record));
+    EXPECT_FALSE(push_string(ring, std::string(ring.max_record_size() + 1, 'x')));
+}
+
+TEST(ShmRingTest, DropNewest) {
+    ShmRing ring = ShmRing::create(64);
+    // 8-byte header and 8-byte payload per record
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(push_string(ring, "record" + std::to_string(i)));
+    }
+    EXPECT_FALSE(push_string(ring, "dropped"));
+    EXPECT_EQ(ring.dropped(), 1u);
+    EXPECT_EQ(pop_string(ring), "record0");
+}
+
+TEST(ShmRingTest, DropOldest) {
+    ShmRing ring = ShmRing::create(64);
+    for (int i = 0; i < 10; i++) {
+        EXPECT_TRUE(push_string(ring, "record" + std::to_string(i), true));
+    }
+    EXPECT_EQ(ring.dropped(), 6u);
+    for (int i = 6; i < 10; i++) {
+        EXPECT_EQ(pop_string(ring), "record" + std::to_string(i));
+    }
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(ShmRingTest, Wrap) {
+    ShmRing ring = ShmRing::create(64);
+    // Records of 24 bytes do not divide the buffer, so they wrap with padding
+    for (int i = 0; i < 100; i++) {
+        std::string value = "wrap record " + std::to_string(i % 10);
+        ASSERT_TRUE(push_string(ring, value));
+        ASSERT_EQ(pop_string(ring), value);
+    }
+    for (int i = 0; i < 100; i++) {
+        ASSERT_TRUE(push_string(ring, "wrap record " + std::to_string(i % 10), true));
+    }
+    // Only the newest records fit, in order
+    EXPECT_EQ(pop_string(ring), "wrap record 8");
+    EXPECT_EQ(pop_string(ring), "wrap record 9");
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(ShmRingTest, ArmAndClose) {
+    ShmRing ring = ShmRing::create(64);
+    EXPECT_FALSE(ring.disarm());
+    EXPECT_TRUE(ring.arm());
+    EXPECT_TRUE(push_string(ring, "wake"));
+    EXPECT_TRUE(ring.disarm());
+    EXPECT_FALSE(ring.disarm());
+
+    // Records already pushed keep the consumer from blocking
+    EXPECT_FALSE(ring.arm());
+    EXPECT_FALSE(ring.disarm());
+
+    EXPECT_FALSE(ring.closed());
+    ring.close();
+    EXPECT_TRUE(ring.closed());
+}
+
+TEST(ShmRingTest, AttachRejectsOtherMemory) {
+    ShmRing ring{SharedMemory::create("not a ring", 4096)};
+    EXPECT_FALSE(ring.ok());
+    EXPECT_EQ(errno, EINVAL);
+}
+
+TEST(ShmRingTest, CrossProcess) {
+    ShmRing ring = ShmRing::create(1 << 12);
+    ASSERT_TRUE(ring.ok());
+
+    pid_t pid = ::fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        // The child attaches through a duplicate of the descriptor, as a
+        // process receiving it over a socket would
+        ShmRing child{SharedMemory(::dup(ring.memory().fd()))};
+        for (uint32_t i = 0; i < 10000; i++) {
+            while (!child.push(&i, sizeof(i), false)) {
+            }
+        }
+        ::_exit(0);
+    }
+
+    std::vector<uint8_t> record;
+    for (uint32_t i = 0; i < 10000; i++) {
+        while (!ring.pop(record)) {
+        }
+        uint32_t value;
+        ASSERT_EQ(record.size(), sizeof(value));
+        std::memcpy(&value, record.data(), sizeof(value));
+        ASSERT_EQ(value, i);
+    }
+    int status;
+    ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+TEST(ShmRingTest, ConcurrentDropOldest) {
+    ShmRing ring = ShmRing::create(256);
+    constexpr uint64_t count = 200000;
+
+    // The consumer must only see increasing values, never a torn record
+    std::thread producer([&] {
+        for (uint64_t i = 1; i <= count; i++) {
+            uint64_t values[2] = {i, ~i};
+            ring.push(values, sizeof(values), true);
+        }
+    });
+
+    std::vector<uint8_t> record;
+    uint64_t last = 0;
+    uint64_t received = 0;
+    while (last < count) {
+        if (!ring.pop(record)) {
+            continue;
+        }
+        uint64_t values[2];
+        ASSERT_EQ(record.size(), sizeof(values));
+        std::memcpy(values, record.data(), sizeof(values));
+        ASSERT_EQ(values[1], ~values[0]);
+        ASSERT_GT(values[0], last);
+        last = values[0];
+        received++;
+    }
+    producer.join();
+    EXPECT_EQ(received + ring.dropped(), count);
+}
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "rix/util/spsc_ring.hpp"
+
+using rix::util::SpscRing;
+
+namespace {
+
+std::string pop_string(SpscRing &ring) {
+    const uint8_t *data;
+    size_t size;
+    if (!ring.front(data, size)) {
+        return "<empty>";
+    }
+    std::string result(reinterpret_cast<const char *>(data), size);
+    ring.pop();
+    return result;
+}
+
+}  // namespace
+
+// Test records come out in order and unchanged
+TEST(SpscRingTest, PushPop) {
+    SpscRing ring(100);
+    EXPECT_EQ(ring.capacity(), 128);
+    EXPECT_TRUE(ring.empty());
+
+    EXPECT_TRUE(ring.push("hello", 5));
+    EXPECT_TRUE(ring.push("ab", 2, "cd", 2));
+    EXPECT_FALSE(ring.empty());
+    EXPECT_EQ(pop_string(ring), "hello");
+    EXPECT_EQ(pop_string(ring), "abcd");
+    EXPECT_TRUE(ring.empty());
+    EXPECT_EQ(pop_string(ring), "<empty>");
+}
+
+// Test a full ring rejects records and accepts them again once drained
+TEST(SpscRingTest, Full) {
+    SpscRing ring(64);
+    std::string record(24, 'x');  // 32 bytes with the header
+    EXPECT_TRUE(ring.push(record.data(), record.size()));
+    EXPECT_TRUE(ring.push(record.data(), record.size()));
+    EXPECT_FALSE(ring.push(record.data(), record.size()));
+    EXPECT_FALSE(ring.push(std::string(ring.max_record_size() + 1, 'y').data(), ring.max_record_size() + 1));
+
+    EXPECT_EQ(pop_string(ring), record);
+    EXPECT_TRUE(ring.push(record.data(), record.size()));
+}
+
+// Test records that do not fit before the end of the buffer start at the beginning
+TEST(SpscRingTest, Wrap) {
+    SpscRing ring(64);
+    for (int i = 0; i < 100; i++) {
+        std::string record = std::to_string(i) + std::string(i % 20, '.');
+        ASSERT_TRUE(ring.push(record.data(), record.size()));
+        ASSERT_EQ(pop_string(ring), record);
+    }
+    EXPECT_TRUE(ring.empty());
+}
+
+// Test a producer and a consumer thread exchange every record intact
+TEST(SpscRingTest, Threaded) {
+    SpscRing ring(1024);
+    const uint32_t count = 200000;
+
+    std::thread producer([&] {
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t record[4] = {i, i * 3, i * 7, i * 11};
+            size_t size = (i % 4 + 1) * sizeof(uint32_t);
+            while (!ring.push(record, size)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint32_t expected = 0;
+    while (expected < count) {
+        const uint8_t *data;
+        size_t size;
+        if (!ring.front(data, size)) {
+            std::this_thread::yield();
+            continue;
+        }
+        uint32_t record[4] = {};
+        ASSERT_EQ(size, (expected % 4 + 1) * sizeof(uint32_t));
+        std::memcpy(record, data, size);
+        ASSERT_EQ(record[0], expected);
+        if (size == sizeof(record)) {
+            ASSERT_EQ(record[3], expected * 11);
+        }
+        ring.pop();
+        expected++;
+    }
+    producer.join();
+    EXPECT_TRUE(ring.empty());
+}
@@ -0,0 +1,414 @@
+#include <gtest/gtest.h>
+
+#include <time.h>
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rix/ipc/pipe.hpp"
+#include "rix/ipc/signal.hpp"
+#include "rix/msg/geometry/Twist2DStamped.hpp"
+#include "rix/util/time.hpp"
+#include "teleop_keyboard/teleop_keyboard.hpp"
+
+using namespace rix::ipc;
+using namespace rix::msg;
+using rix::util::Duration;
+
+namespace {
+
+constexpr float linear_speed = 0.5f;
+constexpr float angular_speed = 2.0f;
+
+// Size of a frame without its size prefix
+const size_t message_size = geometry::Twist2DStamped().size();
+const size_t prefixed_size = sizeof(uint32_t) + message_size;
+
+// Counts the writes made to a pipe
+class CountingPipe : public Pipe {
+   public:
+    explicit CountingPipe(Pipe &&pipe) : Pipe(std::move(pipe)), writes(0) {}
+
+    ssize_t write(const uint8_t *buffer, size_t len) const override {
+        writes++;
+        return Pipe::write(buffer, len);
+    }
+
+    mutable std::atomic<int> writes;
+};
+
+// A pipe whose reads fail, while poll still reports it readable
+class FailingPipe : public Pipe {
+   public:
+    explicit FailingPipe(Pipe &&pipe) : Pipe(std::move(pipe)) {}
+
+    ssize_t read(uint8_t *, size_t) const override {
+        errno = EIO;
+        return -1;
+    }
+};
+
+// Runs a teleop that reads keys from one pipe and writes frames to another
+class TeleopTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        auto [key_read, key_write] = Pipe::create();
+        auto [frame_read, frame_write] = Pipe::create();
+        keys = std::move(key_write);
+        frames = std::move(frame_read);
+        auto counting = std::make_unique<CountingPipe>(std::move(frame_write));
+        output = counting.get();
+        teleop = std::make_unique<TeleopKeyboard>(std::make_unique<Pipe>(std::move(key_read)), std::move(counting),
+                                                  linear_speed, angular_speed);
+    }
+
+    void TearDown() override {
+        if (thread.joinable()) {
+            stop();
+        }
+    }
+
+    void start(int signum = SIGUSR1) {
+        auto sig = std::make_unique<Signal>(signum);
+        stop_signal = sig.get();
+        thread = std::thread([this, sig = std::move(sig)]() mutable { teleop->spin(std::move(sig)); });
+    }
+
+    void stop() {
+        stop_signal->raise();
+        thread.join();
+    }
+
+    void press(const std::string &pressed) {
+        ASSERT_EQ(keys.write(reinterpret_cast<const uint8_t *>(pressed.data()), pressed.size()),
+                  static_cast<ssize_t>(pressed.size()));
+    }
+
+    // Reads `size` bytes of frames, or fewer if none arrive for a second
+    std::vector<uint8_t> read_output(size_t size) {
+        std::vector<uint8_t> data(size);
+        size_t received = 0;
+        while (received < size && frames.wait_for_readable(Duration(1.0))) {
+            ssize_t n = frames.read(data.data() + received, size - received);
+            if (n <= 0) {
+                break;
+            }
+            received += n;
+        }
+        data.resize(received);
+        return data;
+    }
+
+    // Returns true if nothing more is written within `timeout`
+    bool idle(const Duration &timeout = Duration(0.05)) { return !frames.wait_for_readable(timeout); }
+
+    Pipe keys;
+    Pipe frames;
+    CountingPipe *output;
+    std::unique_ptr<TeleopKeyboard> teleop;
+    Signal *stop_signal;
+    std::thread thread;
+};
+
+// Deserializes the size-prefixed frames in `data`
+std::vector<geometry::Twist2DStamped> parse_frames(const std::vector<uint8_t> &data) {
+    std::vector<geometry::Twist2DStamped> cmds;
+    size_t offset = 0;
+    while (offset < data.size()) {
+        standard::UInt32 size;
+        EXPECT_TRUE(size.deserialize(data.data(), data.size(), offset));
+        EXPECT_EQ(size.data, message_size);
+        geometry::Twist2DStamped cmd;
+        EXPECT_TRUE(cmd.deserialize(data.data(), offset + size.data, offset));
+        cmds.push_back(cmd);
+    }
+    return cmds;
+}
+
+// Serializes the frame the teleop should send: `Twist2DStamped::serialize`
+// of the command, after its size if `size_prefixed`
+std::vector<uint8_t> expected_frame(uint32_t seq, const standard::Time &stamp, float vx, float wz,
+                                    bool size_prefixed) {
+    geometry::Twist2DStamped cmd;
+    cmd.header.seq = seq;
+    cmd.header.stamp = stamp;
+    cmd.twist.vx = vx;
+    cmd.twist.wz = wz;
+    std::vector<uint8_t> frame((size_prefixed ? sizeof(uint32_t) : 0) + cmd.size());
+    size_t offset = 0;
+    if (size_prefixed) {
+        standard::UInt32 size;
+        size.data = cmd.size();
+        size.serialize(frame.data(), offset);
+    }
+    cmd.serialize(frame.data(), offset);
+    return frame;
+}
+
+// Returns the stamp of the frame at `offset` in `data`
+standard::Time frame_stamp(const std::vector<uint8_t> &data, size_t offset, bool size_prefixed) {
+    geometry::Twist2DStamped cmd;
+    offset += size_prefixed ? sizeof(uint32_t) : 0;
+    EXPECT_TRUE(cmd.deserialize(data.data(), data.size(), offset));
+    return cmd.header.stamp;
+}
+
+}  // namespace
+
+// Test a burst of keys read at once is written with a single write, as the
+// command of the last key only
+TEST_F(TeleopTest, CoalescesBurst) {
+    start();
+    press("wwwad");
+    std::vector<geometry::Twist2DStamped> cmds = parse_frames(read_output(prefixed_size));
+    ASSERT_EQ(cmds.size(), 1u);
+    EXPECT_FLOAT_EQ(cmds[0].twist.vx, 0.0f);
+    EXPECT_FLOAT_EQ(cmds[0].twist.wz, -angular_speed);
+    EXPECT_TRUE(idle());
+    EXPECT_EQ(output->writes, 1);
+}
+
+// Test keys that are not commands are ignored, and a batch without a command
+// key writes nothing
+TEST_F(TeleopTest, IgnoresOtherKeys) {
+    start();
+    press("xyz");
+    EXPECT_TRUE(idle());
+    press("qw?");
+    std::vector<geometry::Twist2DStamped> cmds = parse_frames(read_output(prefixed_size));
+    ASSERT_EQ(cmds.size(), 1u);
+    EXPECT_FLOAT_EQ(cmds[0].twist.vx, linear_speed);
+    EXPECT_TRUE(idle());
+    EXPECT_EQ(output->writes, 1);
+}
+
+// Test without coalescing every command key of a burst gets a frame, in order
+// and with consecutive sequence numbers, all in a single write
+TEST_F(TeleopTest, SendsEveryKeyWithoutCoalescing) {
+    teleop->set_coalesce(false);
+    EXPECT_FALSE(teleop->coalesce());
+    start();
+    press("wsx d");
+    std::vector<geometry::Twist2DStamped> cmds = parse_frames(read_output(4 * prefixed_size));
+    ASSERT_EQ(cmds.size(), 4u);
+    EXPECT_FLOAT_EQ(cmds[0].twist.vx, linear_speed);
+    EXPECT_FLOAT_EQ(cmds[1].twist.vx, -linear_speed);
+    EXPECT_FLOAT_EQ(cmds[2].twist.vx, 0.0f);
+    EXPECT_FLOAT_EQ(cmds[2].twist.wz, 0.0f);
+    EXPECT_FLOAT_EQ(cmds[3].twist.wz, -angular_speed);
+    for (size_t i = 1; i < cmds.size(); i++) {
+        EXPECT_EQ(cmds[i].header.seq, cmds[0].header.seq + i);
+    }
+    EXPECT_TRUE(idle());
+    EXPECT_EQ(output->writes, 1);
+}
+
+// Test the teleop wakes up as soon as a key arrives instead of at the next
+// 100 ms poll
+TEST_F(TeleopTest, WakesOnInput) {
+    start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    for (int i = 0; i < 5; i++) {
+        rix::util::SteadyTime pressed = rix::util::SteadyTime::now();
+        press("w");
+        ASSERT_EQ(parse_frames(read_output(prefixed_size)).size(), 1u);
+        EXPECT_LT(rix::util::SteadyTime::now() - pressed, Duration(0.02));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+}
+
+// Test SIGINT ends spin while it waits for keys
+TEST_F(TeleopTest, ExitsOnSigint) {
+    start(SIGINT);
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    rix::util::SteadyTime raised = rix::util::SteadyTime::now();
+    stop();
+    EXPECT_LT(rix::util::SteadyTime::now() - raised, Duration(0.05));
+    EXPECT_EQ(output->writes, 0);
+}
+
+// Test once every writer closed the input, the teleop stops watching it
+// instead of waking up on the hang-up over and over, and still exits on the
+// signal
+TEST_F(TeleopTest, StopsWatchingClosedInput) {
+    start();
+    press("w");
+    ASSERT_EQ(parse_frames(read_output(prefixed_size)).size(), 1u);
+    keys = Pipe();
+
+    timespec before;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &before);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    timespec after;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &after);
+    double cpu = (after.tv_sec - before.tv_sec) + (after.tv_nsec - before.tv_nsec) * 1e-9;
+    EXPECT_LT(cpu, 0.05);
+
+    rix::util::SteadyTime raised = rix::util::SteadyTime::now();
+    stop();
+    EXPECT_LT(rix::util::SteadyTime::now() - raised, Duration(0.05));
+    EXPECT_TRUE(idle());
+    EXPECT_EQ(output->writes, 1);
+}
+
+// Test the stream sends frames at its rate and ramps vx to the target within
+// the acceleration limit, up after a key and back down after the stop key
+// Test a read error other than EAGAIN or EINTR ends spin instead of waking
+// it again on every wait
+TEST(TeleopErrorTest, StopsOnReadError) {
+    auto [key_read, key_write] = Pipe::create();
+    auto [frame_read, frame_write] = Pipe::create();
+    TeleopKeyboard teleop(std::make_unique<FailingPipe>(std::move(key_read)), std::make_unique<Pipe>(frame_write),
+                          linear_speed, angular_speed);
+    const uint8_t key = 'w';
+    ASSERT_EQ(key_write.write(&key, 1), 1);
+
+    auto sig = std::make_unique<Signal>(SIGUSR1);
+    Signal *stop_signal = sig.get();
+    std::atomic<bool> done(false);
+    std::thread thread([&, sig = std::move(sig)]() mutable {
+        teleop.spin(std::move(sig));
+        done = true;
+    });
+    for (int i = 0; i < 100 && !done; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_TRUE(done);
+    if (!done) {
+        // Still running, so the signal is still alive
+        stop_signal->raise();
+    }
+    thread.join();
+}
+
+TEST_F(TeleopTest, StreamRampsToTarget) {
+    teleop->set_stream_rate(100.0);
+    teleop->set_acceleration(1.0, 0.0);  // 0.01 m/s per frame
+    start();
+    press("w");
+    std::vector<geometry::Twist2DStamped> cmds = parse_frames(read_output(80 * prefixed_size));
+    press(" ");
+    std::vector<geometry::Twist2DStamped> stopping = parse_frames(read_output(80 * prefixed_size));
+    stop();
+    ASSERT_EQ(cmds.size(), 80u);
+    ASSERT_EQ(stopping.size(), 80u);
+
+    // Up to the target, in steps of at most 0.01 m/s
+    for (size_t i = 1; i < cmds.size(); i++) {
+        EXPECT_GE(cmds[i].twist.vx, cmds[i - 1].twist.vx) << "frame " << i;
+        EXPECT_LE(cmds[i].twist.vx - cmds[i - 1].twist.vx, 0.01f + 1e-5f) << "frame " << i;
+        EXPECT_FLOAT_EQ(cmds[i].twist.wz, 0.0f);
+    }
+    EXPECT_FLOAT_EQ(cmds.back().twist.vx, linear_speed);
+
+    // Back down to zero
+    EXPECT_LT(stopping.front().twist.vx, linear_speed);
+    for (size_t i = 1; i < stopping.size(); i++) {
+        EXPECT_LE(stopping[i].twist.vx, stopping[i - 1].twist.vx) << "frame " << i;
+        EXPECT_LE(stopping[i - 1].twist.vx - stopping[i].twist.vx, 0.01f + 1e-5f) << "frame " << i;
+    }
+    EXPECT_FLOAT_EQ(stopping.back().twist.vx, 0.0f);
+
+    // Stamped on absolute deadlines every 10 ms: a late frame is followed
+    // closely by the next one, but frames never get ahead of the grid and the
+    // average period holds
+    cmds.insert(cmds.end(), stopping.begin(), stopping.end());
+    rix::util::Time first(cmds.front().header.stamp);
+    for (size_t i = 1; i < cmds.size(); i++) {
+        EXPECT_EQ(cmds[i].header.seq, cmds[i - 1].header.seq + 1);
+        // The first frame may itself be up to a period late
+        EXPECT_GE(rix::util::Time(cmds[i].header.stamp) - first, Duration(0.01 * (i - 1))) << "frame " << i;
+    }
+    Duration span = rix::util::Time(cmds.back().header.stamp) - first;
+    double period = span.to_nanoseconds() * 1e-9 / (cmds.size() - 1);
+    EXPECT_NEAR(period, 0.01, 0.001);
+}
+
+// Test the patched key templates are byte for byte the serialized command,
+// seq, stamp and twist included, with the size prefix
+TEST_F(TeleopTest, KeyFramesMatchSerialize) {
+    teleop->set_coalesce(false);
+    start();
+    rix::util::Time before = rix::util::Time::now();
+    press("wasd ");
+    std::vector<uint8_t> data = read_output(5 * prefixed_size);
+    rix::util::Time after = rix::util::Time::now();
+    ASSERT_EQ(data.size(), 5 * prefixed_size);
+
+    // All frames of a batch share the stamp of the read
+    standard::Time stamp = frame_stamp(data, 0, true);
+    EXPECT_GE(rix::util::Time(stamp), before);
+    EXPECT_LE(rix::util::Time(stamp), after);
+    const float twists[5][2] = {{linear_speed, 0.0f}, {0.0f, angular_speed}, {-linear_speed, 0.0f},
+                                {0.0f, -angular_speed}, {0.0f, 0.0f}};
+    for (uint32_t i = 0; i < 5; i++) {
+        std::vector<uint8_t> frame(data.begin() + i * prefixed_size, data.begin() + (i + 1) * prefixed_size);
+        EXPECT_EQ(frame, expected_frame(i, stamp, twists[i][0], twists[i][1], true)) << "frame " << i;
+    }
+
+    // A template patched again carries the new seq and stamp only
+    press("w");
+    data = read_output(prefixed_size);
+    ASSERT_EQ(data.size(), prefixed_size);
+    standard::Time second = frame_stamp(data, 0, true);
+    EXPECT_GE(rix::util::Time(second), rix::util::Time(stamp));
+    EXPECT_EQ(data, expected_frame(5, second, linear_speed, 0.0f, true));
+}
+
+// Test without the size prefix each frame is the serialized command alone,
+// written on its own
+TEST_F(TeleopTest, UnprefixedFramesMatchSerialize) {
+    teleop->set_size_prefixed(false);
+    EXPECT_FALSE(teleop->size_prefixed());
+    teleop->set_coalesce(false);
+    start();
+    press("sd");
+    std::vector<uint8_t> data = read_output(2 * message_size);
+    ASSERT_EQ(data.size(), 2 * message_size);
+
+    standard::Time stamp = frame_stamp(data, 0, false);
+    std::vector<uint8_t> first(data.begin(), data.begin() + message_size);
+    std::vector<uint8_t> second(data.begin() + message_size, data.end());
+    EXPECT_EQ(first, expected_frame(0, stamp, -linear_speed, 0.0f, false));
+    EXPECT_EQ(second, expected_frame(1, stamp, 0.0f, -angular_speed, false));
+    EXPECT_TRUE(idle());
+    EXPECT_EQ(output->writes, 2);
+}
+
+// Test the coalesced frame of a batch is unprefixed too
+TEST_F(TeleopTest, UnprefixedCoalescedFrameMatchesSerialize) {
+    teleop->set_size_prefixed(false);
+    start();
+    press("dw");
+    std::vector<uint8_t> data = read_output(message_size);
+    ASSERT_EQ(data.size(), message_size);
+    EXPECT_EQ(data, expected_frame(0, frame_stamp(data, 0, false), linear_speed, 0.0f, false));
+    EXPECT_TRUE(idle());
+}
+
+// Test the stream template carries each streamed command, stamped when sent
+TEST_F(TeleopTest, StreamFramesMatchSerialize) {
+    teleop->set_stream_rate(100.0);
+    start();
+    press("a");
+    std::vector<uint8_t> data = read_output(30 * prefixed_size);
+    stop();
+    ASSERT_EQ(data.size(), 30 * prefixed_size);
+
+    bool turning = false;
+    for (uint32_t i = 0; i < 30; i++) {
+        std::vector<uint8_t> frame(data.begin() + i * prefixed_size, data.begin() + (i + 1) * prefixed_size);
+        standard::Time stamp = frame_stamp(data, i * prefixed_size, true);
+        // Zero until the key is picked up, then the full turn rate (no
+        // acceleration limit)
+        std::vector<uint8_t> turn = expected_frame(i, stamp, 0.0f, angular_speed, true);
+        turning = turning || frame == turn;
+        EXPECT_EQ(frame, turning ? turn : expected_frame(i, stamp, 0.0f, 0.0f, true)) << "frame " << i;
+    }
+    EXPECT_TRUE(turning);
+}
@@ -0,0 +1,223 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+
+#include "rix/util/time.hpp"
+
+using namespace rix::util;
+
+// Test SteadyTime follows the monotonic clock
+TEST(SteadyTimeTest, NowIsMonotonic) {
+    SteadyTime a = SteadyTime::now();
+    SteadyTime b = SteadyTime::now();
+    EXPECT_LE(a, b);
+    EXPECT_GE(b - a, Duration());
+
+    auto steady_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now().time_since_epoch())
+                         .count();
+    EXPECT_NEAR(SteadyTime::now().to_nanoseconds(), steady_ns, 10'000'000);
+}
+
+// Test SteadyTime arithmetic with Duration
+TEST(SteadyTimeTest, Arithmetic) {
+    SteadyTime a = SteadyTime::now();
+    SteadyTime b = a + Duration(1.5);
+    EXPECT_EQ(b - a, Duration(1.5));
+    EXPECT_EQ(b - Duration(1.5), a);
+    EXPECT_GT(b, a);
+    EXPECT_NE(b, a);
+
+    SteadyTime c = a;
+    c += Duration(0, 10);
+    EXPECT_EQ(c.to_nanoseconds(), a.to_nanoseconds() + 10);
+    c -= Duration(0, 10);
+    EXPECT_EQ(c, a);
+    EXPECT_LT(SteadyTime::min(), a);
+    EXPECT_GT(SteadyTime::max(), a);
+}
+
+// Test sleeping until an absolute monotonic deadline
+TEST(SteadyTimeTest, SleepUntil) {
+    SteadyTime deadline = SteadyTime::now() + Duration(0.02);
+    sleep_until(deadline);
+    SteadyTime now = SteadyTime::now();
+    EXPECT_GE(now, deadline);
+    EXPECT_LT(now - deadline, Duration(0.01));
+
+    // Deadlines in the past return immediately
+    SteadyTime start = SteadyTime::now();
+    sleep_until(start - Duration(1.0));
+    EXPECT_LT(SteadyTime::now() - start, Duration(0.01));
+}
+
+// Test Timer measures elapsed time
+TEST(TimerTest, MeasuresElapsedTime) {
+    Timer timer;
+    timer.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    timer.stop();
+    EXPECT_GE(timer.get(), Duration(0.02));
+    EXPECT_LT(timer.get(), Duration(0.5));
+}
+
+// Test Rate keeps the loop period
+TEST(RateTest, KeepsPeriod) {
+    Rate rate(100.0);
+    EXPECT_EQ(rate.period(), Duration(0.01));
+    EXPECT_NEAR(rate.frequency(), 100.0, 1e-6);
+
+    SteadyTime start = SteadyTime::now();
+    for (int i = 0; i < 10; i++) {
+        rate.sleep();
+    }
+    Duration elapsed = SteadyTime::now() - start;
+    EXPECT_GE(elapsed, Duration(0.09));
+    EXPECT_LT(elapsed, Duration(0.2));
+}
+
+// Test Rate reports an overrun when the loop takes longer than the period
+TEST(RateTest, ReportsOverrun) {
+    Rate rate(Duration(0.005));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_FALSE(rate.sleep());
+    EXPECT_TRUE(rate.sleep());
+}
+
+// Test Rate keeps absolute deadlines, so wakeup latency does not accumulate
+TEST(RateTest, NoDrift) {
+    SteadyTime start = SteadyTime::now();
+    Rate rate(Duration(0.002));
+    rate.set_overrun_policy(Rate::CATCH_UP);
+    for (int i = 0; i < 50; i++) {
+        rate.sleep();
+    }
+    // Only the lateness of the last wakeup adds to the ideal elapsed time
+    Duration elapsed = SteadyTime::now() - start;
+    EXPECT_GE(elapsed, Duration(0.1));
+    EXPECT_LT(elapsed - Duration(0.1) - rate.lateness(), Duration(0.001));
+}
+
+// Test the hybrid sleep/spin mode wakes up close to the deadline
+TEST(RateTest, SpinMargin) {
+    Rate rate(Duration(0.002));
+    rate.set_spin_margin(Duration(0.0005));
+    EXPECT_EQ(rate.spin_margin(), Duration(0.0005));
+    for (int i = 0; i < 50; i++) {
+        rate.sleep();
+        EXPECT_GE(rate.lateness(), Duration());
+    }
+    // Preemption can make the odd cycle late, but most must hit the deadline
+    EXPECT_LT(rate.stats().overruns, 10);
+    EXPECT_LT(rate.stats().jitter.percentile(50), 100'000);
+}
+
+// Test overruns are counted and reset starts a new period
+TEST(RateTest, CountsOverruns) {
+    Rate rate(Duration(0.005));
+    rix::util::sleep_for(Duration(0.01));
+    EXPECT_FALSE(rate.sleep());
+    EXPECT_EQ(rate.stats().overruns, 1);
+    EXPECT_GE(rate.lateness(), Duration(0.005));
+
+    rix::util::sleep_for(Duration(0.01));
+    rate.reset();
+    EXPECT_TRUE(rate.sleep());
+    EXPECT_EQ(rate.stats().overruns, 1);
+}
+
+// Test the SKIP policy drops missed periods and keeps the phase
+TEST(RateTest, SkipPolicy) {
+    SteadyTime start = SteadyTime::now();
+    Rate rate(Duration(0.01));
+    rate.set_overrun_policy(Rate::SKIP);
+    EXPECT_EQ(rate.overrun_policy(), Rate::SKIP);
+    rix::util::sleep_for(Duration(0.035));
+    EXPECT_FALSE(rate.sleep());
+
+    // At least 2 periods were missed, more if the sleep overshot
+    int64_t missed = rate.lateness().to_nanoseconds() / Duration(0.01).to_nanoseconds();
+    EXPECT_GE(missed, 2);
+    EXPECT_EQ(rate.stats().missed, missed);
+
+    // The next deadline is still on the original grid
+    EXPECT_TRUE(rate.sleep());
+    Duration expected = Duration(0.01) * static_cast<int>(missed + 2);
+    Duration elapsed = SteadyTime::now() - start;
+    EXPECT_GE(elapsed, expected);
+    EXPECT_LT(elapsed - expected - rate.lateness(), Duration(0.001));
+}
+
+// Test the CATCH_UP policy runs the missed cycles back to back
+TEST(RateTest, CatchUpPolicy) {
+    Rate rate(Duration(0.05));
+    rate.set_overrun_policy(Rate::CATCH_UP);
+    // Three deadlines missed, half a period before the fourth one
+    rix::util::sleep_for(Duration(0.175));
+    EXPECT_FALSE(rate.sleep());
+    EXPECT_FALSE(rate.sleep());
+    EXPECT_FALSE(rate.sleep());
+    EXPECT_TRUE(rate.sleep());
+    EXPECT_EQ(rate.stats().overruns, 3);
+    EXPECT_EQ(rate.stats().missed, 0);
+}
+
+// Test a zero period is clamped, so the SKIP policy never divides by zero
+TEST(RateTest, ZeroPeriod) {
+    Rate rate;
+    EXPECT_EQ(rate.period(), Rate::min_period());
+    rate.set_period(Duration(0.01));
+    rate.set_period(Duration());
+    EXPECT_EQ(rate.period(), Rate::min_period());
+
+    rate.set_overrun_policy(Rate::SKIP);
+    rix::util::sleep_for(Duration(0.001));
+    EXPECT_FALSE(rate.sleep());
+    EXPECT_GT(rate.stats().missed, 0u);
+}
+
+// Test the statistics of a loop
+TEST(RateTest, Stats) {
+    Rate rate(Duration(0.002));
+    for (int i = 0; i < 20; i++) {
+        rate.sleep();
+    }
+    const Rate::Stats &stats = rate.stats();
+    EXPECT_EQ(stats.cycles, 20);
+    EXPECT_EQ(stats.jitter.count(), 20);
+    EXPECT_EQ(stats.jitter.max(), stats.max_lateness.to_nanoseconds());
+    EXPECT_GE(stats.max_lateness, rate.lateness());
+
+    rate.reset_stats();
+    EXPECT_EQ(rate.stats().cycles, 0);
+    EXPECT_EQ(rate.stats().jitter.count(), 0);
+    EXPECT_EQ(rate.stats().max_lateness, Duration());
+}
+
+// Test formatting into a buffer matches the expected layout
+TEST(TimeTest, Format) {
+    Time t(1'000'000'000, 5'000);  // 2001-09-09 01:46:40.000005 GMT
+    char buffer[Time::format_size];
+    size_t length = t.format(buffer, sizeof(buffer));
+    EXPECT_EQ(std::string(buffer, length), "09/09/01 01:46:40.000005 GMT");
+    EXPECT_EQ(buffer[length], '\0');
+    EXPECT_EQ(t.to_string(), "09/09/01 01:46:40.000005 GMT");
+
+    // Same second, cached prefix
+    Time u(1'000'000'000, 999'999'999);
+    EXPECT_EQ(u.to_string(), "09/09/01 01:46:40.999999 GMT");
+
+    // Next second
+    EXPECT_EQ((u + Duration(0, 1)).to_string(), "09/09/01 01:46:41.000000 GMT");
+
+    // Before the epoch
+    EXPECT_EQ(Time(-0.5).to_string(), "12/31/69 23:59:59.500000 GMT");
+}
+
+// Test formatting into a buffer that is too small
+TEST(TimeTest, FormatBufferTooSmall) {
+    char buffer[8];
+    EXPECT_EQ(Time::now().format(buffer, sizeof(buffer)), 0);
+    EXPECT_EQ(Time::now().format(buffer, 0), 0);
+    EXPECT_FALSE(Time::now().to_string(true).empty());
+}
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+
+#include "rix/ipc/timer_fd.hpp"
+
+using namespace rix::ipc;
+
+// Test that a new timer is valid and disarmed
+TEST(TimerFdTest, ConstructorCreatesDisarmedTimer) {
+    TimerFd timer;
+    EXPECT_TRUE(timer.ok());
+    EXPECT_FALSE(timer.armed());
+    EXPECT_FALSE(timer.is_readable());
+}
+
+// Test a one-shot timer becomes readable after it expires
+TEST(TimerFdTest, OneShotExpires) {
+    TimerFd timer;
+    ASSERT_TRUE(timer.set(rix::util::Duration(0.02)));
+    EXPECT_TRUE(timer.armed());
+    EXPECT_FALSE(timer.is_readable());
+
+    EXPECT_TRUE(timer.wait_for_readable(rix::util::Duration(1.0)));
+    EXPECT_EQ(timer.consume(), 1);
+    EXPECT_FALSE(timer.armed());
+}
+
+// Test a zero initial duration expires immediately instead of disarming
+TEST(TimerFdTest, ZeroInitialExpiresImmediately) {
+    TimerFd timer;
+    ASSERT_TRUE(timer.set(rix::util::Duration(0.0)));
+    EXPECT_TRUE(timer.wait_for_readable(rix::util::Duration(1.0)));
+    EXPECT_EQ(timer.consume(), 1);
+}
+
+// Test an absolute deadline expires at that time, and past deadlines at once
+TEST(TimerFdTest, SetAtAbsoluteDeadline) {
+    TimerFd timer;
+    rix::util::SteadyTime deadline = rix::util::SteadyTime::now() + rix::util::Duration(0.02);
+    ASSERT_TRUE(timer.set_at(deadline));
+    EXPECT_TRUE(timer.armed());
+    EXPECT_TRUE(timer.wait_for_readable(rix::util::Duration(1.0)));
+    EXPECT_GE(rix::util::SteadyTime::now(), deadline);
+    EXPECT_EQ(timer.consume(), 1);
+
+    ASSERT_TRUE(timer.set_at(rix::util::SteadyTime::now() - rix::util::Duration(1.0)));
+    EXPECT_TRUE(timer.wait_for_readable(rix::util::Duration(1.0)));
+    EXPECT_EQ(timer.consume(), 1);
+}
+
+// Test periodic expirations accumulate while not consumed
+TEST(TimerFdTest, PeriodicAccumulatesExpirations) {
+    TimerFd timer(true);
+    ASSERT_TRUE(timer.set_periodic(rix::util::Duration(0.01)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(55));
+    uint64_t count = timer.consume();
+    EXPECT_GE(count, 4);
+    EXPECT_LE(count, 6);
+    EXPECT_TRUE(timer.armed());
+}
+
+// Test non-blocking consume returns 0 when nothing expired
+TEST(TimerFdTest, NonblockingConsumeWithoutExpiration) {
+    TimerFd timer(true);
+    EXPECT_TRUE(timer.is_nonblocking());
+    ASSERT_TRUE(timer.set(rix::util::Duration(10.0)));
+    EXPECT_EQ(timer.consume(), 0);
+}
+
+// Test disarm discards the pending timer
+TEST(TimerFdTest, DisarmStopsTimer) {
+    TimerFd timer;
+    ASSERT_TRUE(timer.set_periodic(rix::util::Duration(0.01)));
+    ASSERT_TRUE(timer.disarm());
+    EXPECT_FALSE(timer.armed());
+    EXPECT_FALSE(timer.wait_for_readable(rix::util::Duration(0.05)));
+}
+
+// Test move constructor transfers ownership
+TEST(TimerFdTest, MoveConstructor) {
+    TimerFd a;
+    int fd = a.fd();
+    TimerFd b(std::move(a));
+    EXPECT_FALSE(a.ok());
+    EXPECT_EQ(b.fd(), fd);
+}
@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "rix/util/timer_wheel.hpp"
+
+using rix::util::Duration;
+using rix::util::SteadyTime;
+using rix::util::TimerWheel;
+
+namespace {
+
+SteadyTime at_ms(int64_t ms) { return SteadyTime(SteadyTime::Type(std::chrono::milliseconds(ms))); }
+
+}  // namespace
+
+// Test an empty wheel
+TEST(TimerWheelTest, Empty) {
+    TimerWheel wheel(Duration(0.001), at_ms(0));
+    EXPECT_EQ(wheel.size(), 0);
+    EXPECT_EQ(wheel.next_deadline(), SteadyTime::max());
+    EXPECT_EQ(wheel.advance(at_ms(100000)), 0);
+    EXPECT_FALSE(wheel.pending(TimerWheel::invalid_id));
+    EXPECT_FALSE(wheel.cancel(TimerWheel::invalid_id));
+}
+
+// Test timers fire at their deadline and not before
+TEST(TimerWheelTest, FiresAtDeadline) {
+    TimerWheel wheel(Duration(0.001), at_ms(0));
+    int fired = 0;
+    TimerWheel::Id id = wheel.schedule(at_ms(10), [&] { fired++; });
+    EXPECT_TRUE(wheel.pending(id));
+    EXPECT_EQ(wheel.next_deadline(), at_ms(10));
+
+    EXPECT_EQ(wheel.advance(at_ms(9)), 0);
+    EXPECT_EQ(fired, 0);
+    EXPECT_EQ(wheel.advance(at_ms(10)), 1);
+    EXPECT_EQ(fired, 1);
+    EXPECT_FALSE(wheel.pending(id));
+    EXPECT_EQ(wheel.size(), 0);
+    EXPECT_EQ(wheel.advance(at_ms(20)), 0);
+}
+
+// Test deadlines are rounded up to the next tick
+TEST(TimerWheelTest, RoundsUp) {
+    TimerWheel wheel(Duration(0.001), at_ms(0));
+    int fired = 0;
+    wheel.schedule(at_ms(5) + Duration(0, 1), [&] { fired++; });
+    EXPECT_EQ(wheel.next_deadline(), at_ms(6));
+    wheel.advance(at_ms(5) + Duration(0, 999999));
+    EXPECT_EQ(fired, 0);
+    wheel.advance(at_ms(6));
+    EXPECT_EQ(fired, 1);
+}
+
+// Test past deadlines expire on the next advance
+TEST(TimerWheelTest, PastDeadline) {
+    TimerWheel wheel(Duration(0.001), at_ms(0));
+    wheel.advance(at_ms(50));
+    int fired = 0;
+    wheel.schedule(at_ms(10), [&] { fired++; });
+    EXPECT_LE(wheel.next_deadline(), at_ms(51));
+    wheel.advance(at_ms(51));
+    EXPECT_EQ(fired, 1);
+}
+
+// Test cancel and reschedule
+TEST(TimerWheelTest, CancelAndReschedule) {
+    TimerWheel wheel(Duration(0.001), at_ms(0));
+    int a = 0, b = 0;
+    TimerWheel::Id id_a = wheel.schedule(at_ms(10), [&] { a++; });
+    TimerWheel::Id id_b = wheel.schedule(at_ms(10), [&] { b++; });
+    EXPECT_TRUE(wheel.cancel(id_a));
+    EXPECT_FALSE(wheel.cancel(id_a));
+    EXPECT_TRUE(wheel.reschedule(id_b, at_ms(1000)));
+    EXPECT_EQ(wheel.size(), 1);
+
+    wheel.advance(at_ms(999));
+    EXPECT_EQ(a, 0);
+    EXPECT_EQ(b, 0);
+    wheel.advance(at_ms(1000));
+    EXPECT_EQ(b, 1);
+
+    // Stale ids are rejected after the slot is reused
+    TimerWheel::Id id_c = wheel.schedule(at_ms(2000), [] {});
+    EXPECT_NE(id_c, id_a);
+    EXPECT_FALSE(wheel.cancel(id_a));
+    EXPECT_TRUE(wheel.pending(id_c));
+}
+
+// Test callbacks can schedule and cancel timers
+TEST(TimerWheelTest, CallbacksModifyWheel) {
+    TimerWheel wheel(Duration(0.001), at_ms(0));
+    std::vector<int64_t> fired;
+    TimerWheel::Id victim = TimerWheel::invalid_id;
+
+    // A periodic timer that re-arms itself
+    std::function<void()> periodic;
+    int64_t next = 10;
+    periodic = [&] {
+        fired.push_back(next);
+        next += 10;
+        if (next <= 50) {
+            wheel.schedule(at_ms(next), periodic);
+        }
+    };
+    wheel.schedule(at_ms(next), periodic);
+
+    // Two timers in the same slot, the first cancels the second
+    wheel.schedule(at_ms(25), [&] { wheel.cancel(victim); });
+    victim = wheel.schedule(at_ms(25), [&] { fired.push_back(-1); });
+
+    wheel.advance(at_ms(100));
+    EXPECT_EQ(fired, (std::vector<int64_t>{10, 20, 30, 40, 50}));
+    EXPECT_EQ(wheel.size(), 0);
+}
+
+// Test timers in higher levels cascade and fire on time
+TEST(TimerWheelTest, Cascade) {
+    TimerWheel wheel(Duration(0.001), at_ms(0));
+    std::vector<int64_t> deadlines = {300, 256, 70000, 65536, 20'000'000, 5'000'000'000};
+    std::vector<int64_t> fired;
+    for (int64_t ms : deadlines) {
+        wheel.schedule(at_ms(ms), [&fired, ms] { fired.push_back(ms); });
+    }
+
+    // Follow next_deadline like an event loop would
+    int wakeups = 0;
+    while (wheel.size() > 0) {
+        SteadyTime next = wheel.next_deadline();
+        size_t before = fired.size();
+        wheel.advance(next);
+        for (size_t i = before; i < fired.size(); i++) {
+            EXPECT_EQ(at_ms(fired[i]), next);
+        }
+        wakeups++;
+        ASSERT_LT(wakeups, 1000);
+    }
+    EXPECT_EQ(fired, (std::vector<int64_t>{256, 300, 65536, 70000, 20'000'000, 5'000'000'000}));
+}
+
+// Test many random timers fire in order and within one tick of their deadline
+TEST(TimerWheelTest, RandomDeadlines) {
+    TimerWheel wheel(Duration(0.001), at_ms(0));
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int64_t> dist(0, 200'000'000);  // Up to 200 s, in us
+
+    std::vector<TimerWheel::Id> ids;
+    int64_t now_us = 0;
+    int64_t last = -1;
+    int fired = 0;
+    for (int i = 0; i < 5000; i++) {
+        int64_t deadline = dist(rng);
+        ids.push_back(wheel.schedule(SteadyTime(SteadyTime::Type(std::chrono::microseconds(deadline))), [&, deadline] {
+            EXPECT_GE(now_us, deadline);
+            EXPECT_LT(now_us - deadline, 2000);
+            EXPECT_GE((deadline + 999) / 1000, (last + 999) / 1000);
+            last = deadline;
+            fired++;
+        }));
+    }
+    int cancelled = 0;
+    for (size_t i = 0; i < ids.size(); i += 3) {
+        cancelled += wheel.cancel(ids[i]);
+    }
+
+    while (now_us < 200'000'000) {
+        now_us += 997;
+        wheel.advance(SteadyTime(SteadyTime::Type(std::chrono::microseconds(now_us))));
+    }
+    wheel.advance(SteadyTime(SteadyTime::Type(std::chrono::microseconds(201'000'000))));
+    EXPECT_EQ(fired + cancelled, 5000);
+    EXPECT_EQ(wheel.size(), 0);
+}
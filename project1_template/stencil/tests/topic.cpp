@@ -0,0 +1,253 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "rix/ipc/poller.hpp"
+#include "rix/ipc/topic.hpp"
+#include "rix/ipc/unix_socket.hpp"
+#include "rix/msg/geometry/Twist2DStamped.hpp"
+#include "rix/msg/standard/UInt32.hpp"
+
+using namespace rix::ipc;
+using namespace rix::msg;
+
+namespace {
+
+standard::UInt32 make_message(uint32_t value) {
+    standard::UInt32 msg;
+    msg.data = value;
+    return msg;
+}
+
+// Subscribers are removed by the accept thread once their connection closes
+bool wait_for_subscribers(const Publisher<standard::UInt32> &pub, size_t count) {
+    for (int i = 0; i < 200 && pub.subscribers() != count; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return pub.subscribers() == count;
+}
+
+}  // namespace
+
+TEST(TopicTest, PublishSubscribe) {
+    Publisher<standard::UInt32> pub("test_basic");
+    ASSERT_TRUE(pub.ok());
+    Subscriber<standard::UInt32> sub("test_basic");
+    ASSERT_TRUE(sub.ok());
+    EXPECT_EQ(pub.subscribers(), 1u);
+    EXPECT_TRUE(sub.connected());
+
+    standard::UInt32 msg;
+    EXPECT_FALSE(sub.take(msg));
+    pub.publish(make_message(1));
+    pub.publish(make_message(2));
+    ASSERT_TRUE(sub.take(msg));
+    EXPECT_EQ(msg.data, 1u);
+    ASSERT_TRUE(sub.take(msg));
+    EXPECT_EQ(msg.data, 2u);
+    EXPECT_FALSE(sub.take(msg));
+}
+
+TEST(TopicTest, FanOut) {
+    Publisher<standard::UInt32> pub("test_fan_out");
+    Subscriber<standard::UInt32> first("test_fan_out");
+    Subscriber<standard::UInt32> second("test_fan_out");
+    ASSERT_TRUE(first.ok());
+    ASSERT_TRUE(second.ok());
+    EXPECT_EQ(pub.subscribers(), 2u);
+
+    for (uint32_t i = 0; i < 100; i++) {
+        pub.publish(make_message(i));
+    }
+    standard::UInt32 msg;
+    for (uint32_t i = 0; i < 100; i++) {
+        ASSERT_TRUE(first.take(msg));
+        EXPECT_EQ(msg.data, i);
+        ASSERT_TRUE(second.take(msg));
+        EXPECT_EQ(msg.data, i);
+    }
+}
+
+TEST(TopicTest, Errors) {
+    Subscriber<standard::UInt32> missing("test_missing");
+    EXPECT_FALSE(missing.ok());
+    EXPECT_EQ(errno, ENOENT);
+
+    Publisher<standard::UInt32> invalid("test/invalid");
+    EXPECT_FALSE(invalid.ok());
+    EXPECT_EQ(errno, EINVAL);
+
+    Publisher<standard::UInt32> pub("test_errors");
+    ASSERT_TRUE(pub.ok());
+    Publisher<standard::UInt32> duplicate("test_errors");
+    EXPECT_FALSE(duplicate.ok());
+    EXPECT_EQ(errno, EADDRINUSE);
+
+    // The message type is checked with its hash
+    Subscriber<geometry::Twist2DStamped> mismatch("test_errors");
+    EXPECT_FALSE(mismatch.ok());
+    EXPECT_EQ(errno, EPROTOTYPE);
+    EXPECT_TRUE(wait_for_subscribers(pub, 0));
+}
+
+TEST(TopicTest, DropPolicies) {
+    Publisher<standard::UInt32> pub("test_drop");
+    // Room for 4 messages of 8 bytes (with their header)
+    Subscriber<standard::UInt32> oldest("test_drop", 64, DropPolicy::DROP_OLDEST);
+    Subscriber<standard::UInt32> newest("test_drop", 64, DropPolicy::DROP_NEWEST);
+    Subscriber<standard::UInt32> disconnect("test_drop", 64, DropPolicy::DISCONNECT);
+    ASSERT_EQ(pub.subscribers(), 3u);
+
+    for (uint32_t i = 0; i < 10; i++) {
+        pub.publish(make_message(i));
+    }
+
+    standard::UInt32 msg;
+    ASSERT_TRUE(oldest.take(msg));
+    EXPECT_EQ(msg.data, 6u);
+    EXPECT_EQ(oldest.dropped(), 6u);
+    EXPECT_TRUE(oldest.connected());
+
+    ASSERT_TRUE(newest.take(msg));
+    EXPECT_EQ(msg.data, 0u);
+    EXPECT_EQ(newest.dropped(), 6u);
+    EXPECT_TRUE(newest.connected());
+
+    // The messages received before the disconnection can still be read
+    EXPECT_FALSE(disconnect.connected());
+    EXPECT_TRUE(disconnect.wait(rix::util::Duration()));
+    for (uint32_t i = 0; i < 4; i++) {
+        ASSERT_TRUE(disconnect.take(msg));
+        EXPECT_EQ(msg.data, i);
+    }
+    EXPECT_FALSE(disconnect.take(msg));
+    EXPECT_EQ(pub.subscribers(), 2u);
+}
+
+TEST(TopicTest, WaitWakesOnPublish) {
+    Publisher<standard::UInt32> pub("test_wait");
+    Subscriber<standard::UInt32> sub("test_wait");
+    EXPECT_FALSE(sub.wait(rix::util::Duration(0.01)));
+
+    std::thread publisher([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        pub.publish(make_message(7));
+    });
+    EXPECT_TRUE(sub.wait(rix::util::Duration(5.0)));
+    publisher.join();
+    standard::UInt32 msg;
+    ASSERT_TRUE(sub.take(msg));
+    EXPECT_EQ(msg.data, 7u);
+
+    // The wakeup of a message already taken does not end the next wait
+    EXPECT_FALSE(sub.wait(rix::util::Duration(0.01)));
+}
+
+TEST(TopicTest, ReaderWithPoller) {
+    TopicWriter writer("test_poller", standard::UInt32().hash());
+    TopicReader reader("test_poller", standard::UInt32().hash());
+    ASSERT_TRUE(reader.ok());
+    reader.set_nonblocking(true);
+
+    uint8_t buffer[16];
+    EXPECT_EQ(reader.read(buffer, sizeof(buffer)), -1);
+    EXPECT_EQ(errno, EAGAIN);
+
+    // The empty read armed the ring, so the next message wakes the poller
+    Poller poller;
+    poller.add(reader.fd());
+    EXPECT_EQ(poller.wait(rix::util::Duration()), 0);
+    const uint8_t message[] = {1, 2, 3};
+    EXPECT_EQ(writer.write(message, sizeof(message)), 3);
+    EXPECT_EQ(writer.write(message, 2), 2);
+    EXPECT_EQ(poller.wait(rix::util::Duration(1.0)), 1);
+
+    // Each read returns one message, and the reader stays readable until a
+    // read finds the ring empty
+    EXPECT_EQ(reader.read(buffer, sizeof(buffer)), 3);
+    EXPECT_EQ(poller.wait(rix::util::Duration()), 1);
+    EXPECT_EQ(reader.read(buffer, 1), 1);
+    EXPECT_EQ(reader.read(buffer, sizeof(buffer)), -1);
+    EXPECT_EQ(poller.wait(rix::util::Duration()), 0);
+
+    EXPECT_EQ(writer.read(buffer, sizeof(buffer)), -1);
+    EXPECT_EQ(reader.write(buffer, sizeof(buffer)), -1);
+}
+
+TEST(TopicTest, PollFreshReader) {
+    TopicWriter writer("test_poll_fresh", standard::UInt32().hash());
+    const uint8_t message[] = {1, 2, 3};
+    TopicReader before("test_poll_fresh", standard::UInt32().hash());
+    EXPECT_EQ(writer.write(message, sizeof(message)), 3);
+    TopicReader after("test_poll_fresh", standard::UInt32().hash());
+    ASSERT_TRUE(before.ok());
+    ASSERT_TRUE(after.ok());
+
+    // Neither reader has read yet: one was subscribed when the message was
+    // written, the other finds nothing queued until the next one
+    Poller poller;
+    poller.add(before.fd());
+    EXPECT_EQ(poller.wait(rix::util::Duration(1.0)), 1);
+
+    Poller idle;
+    idle.add(after.fd());
+    EXPECT_EQ(idle.wait(rix::util::Duration()), 0);
+    EXPECT_EQ(writer.write(message, 2), 2);
+    EXPECT_EQ(idle.wait(rix::util::Duration(1.0)), 1);
+
+    uint8_t buffer[16];
+    EXPECT_EQ(before.read(buffer, sizeof(buffer)), 3);
+    EXPECT_EQ(after.read(buffer, sizeof(buffer)), 2);
+}
+
+TEST(TopicTest, PublisherGone) {
+    auto pub = std::make_unique<Publisher<standard::UInt32>>("test_gone");
+    Subscriber<standard::UInt32> sub("test_gone");
+    pub->publish(make_message(3));
+    pub.reset();
+
+    EXPECT_FALSE(sub.connected());
+    EXPECT_TRUE(sub.wait(rix::util::Duration(1.0)));
+    standard::UInt32 msg;
+    ASSERT_TRUE(sub.take(msg));
+    EXPECT_EQ(msg.data, 3u);
+    EXPECT_FALSE(sub.take(msg));
+
+    // The topic can be published again
+    Publisher<standard::UInt32> again("test_gone");
+    EXPECT_TRUE(again.ok());
+}
+
+TEST(TopicTest, SubscriberGone) {
+    Publisher<standard::UInt32> pub("test_unsubscribe");
+    {
+        Subscriber<standard::UInt32> sub("test_unsubscribe");
+        EXPECT_EQ(pub.subscribers(), 1u);
+    }
+    EXPECT_TRUE(wait_for_subscribers(pub, 0));
+    pub.publish(make_message(1));
+}
+
+// Test a client that connects but never sends its request does not hold up
+// other subscribers
+TEST(TopicTest, SilentClient) {
+    Publisher<standard::UInt32> pub("test_silent");
+    ASSERT_TRUE(pub.ok());
+    UnixSocket silent = UnixSocket::connect(topic_path("test_silent"), UnixSocket::Type::SEQPACKET);
+    ASSERT_TRUE(silent.ok());
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    auto start = std::chrono::steady_clock::now();
+    Subscriber<standard::UInt32> sub("test_silent");
+    EXPECT_TRUE(sub.ok());
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(200));
+    EXPECT_EQ(pub.subscribers(), 1u);
+
+    // Closing it before sending a request is not an error either
+    silent = UnixSocket();
+    Subscriber<standard::UInt32> other("test_silent");
+    EXPECT_TRUE(other.ok());
+    EXPECT_EQ(pub.subscribers(), 2u);
+}
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+#include "rix/util/time.hpp"
+#include "rix/util/trace.hpp"
+
+using rix::util::Duration;
+using rix::util::Time;
+using rix::util::Trace;
+
+// Test stages are numbered in the order they are added and start empty
+TEST(TraceTest, AddStage) {
+    Trace trace("test");
+    EXPECT_EQ(trace.add_stage("read"), 0u);
+    EXPECT_EQ(trace.add_stage("write"), 1u);
+    EXPECT_EQ(trace.stage(0).count(), 0);
+    EXPECT_EQ(trace.stage(1).count(), 0);
+}
+
+// Test recording a latency only touches its stage
+TEST(TraceTest, RecordDuration) {
+    Trace trace("test");
+    size_t read = trace.add_stage("read");
+    size_t write = trace.add_stage("write");
+
+    trace.record(read, Duration(0, 1000));
+    trace.record(read, Duration(0, 3000));
+    trace.record(write, Duration(0, 2000));
+
+    EXPECT_EQ(trace.stage(read).count(), 2);
+    EXPECT_NEAR(trace.stage(read).max(), 3000, 3000 / 32);
+    EXPECT_NEAR(trace.stage(read).min(), 1000, 1000 / 32);
+    EXPECT_EQ(trace.stage(write).count(), 1);
+    EXPECT_NEAR(trace.stage(write).max(), 2000, 2000 / 32);
+}
+
+// Test recording from an origin measures the time elapsed since it
+TEST(TraceTest, RecordOrigin) {
+    Trace trace("test");
+    size_t stage = trace.add_stage("end_to_end");
+
+    Time origin = Time::now() - Duration(0.01);
+    Time before = Time::now();
+    trace.record(stage, origin);
+    Duration elapsed = Time::now() - before;
+
+    ASSERT_EQ(trace.stage(stage).count(), 1);
+    // At least the 10 ms since the origin, at most the time spent recording
+    // more, within the histogram's relative error
+    EXPECT_GE(trace.stage(stage).max(), 10'000'000 - 10'000'000 / 32);
+    EXPECT_LE(trace.stage(stage).max(), (10'000'000 + elapsed.to_nanoseconds()) * 33 / 32);
+}
+
+// Test the report lists every stage in order with its count and percentiles
+TEST(TraceTest, Report) {
+    Trace trace("pipeline");
+    size_t read = trace.add_stage("read");
+    size_t write = trace.add_stage("write");
+    for (int i = 0; i < 10; i++) {
+        trace.record(read, Duration(0, 100'000));
+    }
+    trace.record(write, Duration(0, 2'000'000));
+
+    std::ostringstream os;
+    os << std::setprecision(3);
+    trace.report(os);
+    std::string report = os.str();
+
+    EXPECT_EQ(report.find("Trace: pipeline"), 0u);
+    for (const char *column : {"stage", "count", "p50", "p90", "p99", "p99.9", "max"}) {
+        EXPECT_NE(report.find(column), std::string::npos) << column;
+    }
+
+    std::istringstream lines(report);
+    std::string line;
+    std::getline(lines, line);  // Title
+    std::getline(lines, line);  // Column names
+
+    // Latencies are in microseconds, so 100 us and 2000 us
+    std::string name;
+    int64_t count;
+    double p50, p90, p99, p999, max;
+    ASSERT_TRUE(std::getline(lines, line));
+    std::istringstream(line) >> name >> count >> p50 >> p90 >> p99 >> p999 >> max;
+    EXPECT_EQ(name, "read");
+    EXPECT_EQ(count, 10);
+    EXPECT_NEAR(p50, 100.0, 100.0 / 32);
+    EXPECT_NEAR(max, 100.0, 100.0 / 32);
+
+    ASSERT_TRUE(std::getline(lines, line));
+    std::istringstream(line) >> name >> count >> p50 >> p90 >> p99 >> p999 >> max;
+    EXPECT_EQ(name, "write");
+    EXPECT_EQ(count, 1);
+    EXPECT_NEAR(p50, 2000.0, 2000.0 / 32);
+    EXPECT_NEAR(max, 2000.0, 2000.0 / 32);
+
+    EXPECT_FALSE(std::getline(lines, line));
+
+    // The stream's formatting is restored
+    EXPECT_EQ(os.precision(), 3);
+    EXPECT_FALSE(os.flags() & std::ios::fixed);
+}
+
+// Test reset empties every stage but keeps them
+TEST(TraceTest, Reset) {
+    Trace trace("test");
+    size_t stage = trace.add_stage("read");
+    trace.record(stage, Duration(0, 1000));
+    trace.reset();
+    EXPECT_EQ(trace.stage(stage).count(), 0);
+
+    std::ostringstream os;
+    trace.report(os);
+    EXPECT_NE(os.str().find("read"), std::string::npos);
+}
@@ -0,0 +1,186 @@
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rix/ipc/pipe.hpp"
+#include "rix/ipc/unix_socket.hpp"
+
+using namespace rix::ipc;
+
+namespace {
+
+ssize_t write_string(const UnixSocket &socket, const std::string &msg) {
+    return socket.write(reinterpret_cast<const uint8_t *>(msg.data()), msg.size());
+}
+
+std::string read_string(const UnixSocket &socket, size_t size = 256) {
+    std::vector<uint8_t> buffer(size);
+    ssize_t bytes = socket.read(buffer.data(), buffer.size());
+    return bytes > 0 ? std::string(buffer.begin(), buffer.begin() + bytes) : "";
+}
+
+}  // namespace
+
+TEST(UnixSocketTest, DefaultConstructor) {
+    UnixSocket socket;
+    EXPECT_FALSE(socket.ok());
+}
+
+TEST(UnixSocketTest, StreamPair) {
+    auto [a, b] = UnixSocket::pair(UnixSocket::Type::STREAM);
+    ASSERT_TRUE(a.ok());
+    ASSERT_TRUE(b.ok());
+    EXPECT_EQ(a.type(), UnixSocket::Type::STREAM);
+
+    // Both ends can write
+    EXPECT_EQ(write_string(a, "ping"), 4);
+    EXPECT_EQ(read_string(b), "ping");
+    EXPECT_EQ(write_string(b, "pong"), 4);
+    EXPECT_EQ(read_string(a), "pong");
+}
+
+TEST(UnixSocketTest, SeqpacketPreservesBoundaries) {
+    auto [a, b] = UnixSocket::pair(UnixSocket::Type::SEQPACKET);
+    ASSERT_TRUE(a.ok());
+    EXPECT_EQ(write_string(a, "first"), 5);
+    EXPECT_EQ(write_string(a, "second"), 6);
+
+    EXPECT_EQ(read_string(b), "first");
+    EXPECT_EQ(read_string(b), "second");
+
+    // A packet larger than the buffer is truncated, not split
+    EXPECT_EQ(write_string(a, "truncated"), 9);
+    EXPECT_EQ(write_string(a, "next"), 4);
+    EXPECT_EQ(read_string(b, 5), "trunc");
+    EXPECT_EQ(read_string(b), "next");
+}
+
+TEST(UnixSocketTest, WriteAfterPeerClosed) {
+    auto [a, b] = UnixSocket::pair(UnixSocket::Type::STREAM);
+    b = UnixSocket();
+    // Fails with EPIPE instead of raising SIGPIPE
+    EXPECT_EQ(write_string(a, "lost"), -1);
+    EXPECT_EQ(errno, EPIPE);
+}
+
+TEST(UnixSocketTest, ListenAcceptConnect) {
+    const std::string path = "/tmp/rix_unix_socket_test";
+    UnixSocket listener = UnixSocket::listen(path, UnixSocket::Type::SEQPACKET);
+    ASSERT_TRUE(listener.ok());
+
+    UnixSocket client;
+    std::thread connector([&] { client = UnixSocket::connect(path, UnixSocket::Type::SEQPACKET); });
+    UnixSocket server = listener.accept();
+    connector.join();
+    ASSERT_TRUE(server.ok());
+    ASSERT_TRUE(client.ok());
+    EXPECT_EQ(server.type(), UnixSocket::Type::SEQPACKET);
+
+    EXPECT_EQ(write_string(client, "hello"), 5);
+    EXPECT_EQ(read_string(server), "hello");
+
+    // Listening again on the same path replaces the stale socket file
+    listener = UnixSocket();
+    listener = UnixSocket::listen(path, UnixSocket::Type::SEQPACKET);
+    EXPECT_TRUE(listener.ok());
+    listener = UnixSocket();
+    File::remove(path);
+}
+
+// Test listen only replaces a socket file nobody listens on
+TEST(UnixSocketTest, ListenKeepsLivePath) {
+    const std::string path = "/tmp/rix_unix_socket_test_live";
+    UnixSocket listener = UnixSocket::listen(path, UnixSocket::Type::STREAM);
+    ASSERT_TRUE(listener.ok());
+
+    // The first listener still accepts connections
+    UnixSocket second = UnixSocket::listen(path, UnixSocket::Type::STREAM);
+    EXPECT_FALSE(second.ok());
+    EXPECT_EQ(errno, EADDRINUSE);
+    UnixSocket client = UnixSocket::connect(path, UnixSocket::Type::STREAM);
+    EXPECT_TRUE(client.ok());
+    client = UnixSocket();
+    listener = UnixSocket();
+    File::remove(path);
+
+    // A regular file is never removed
+    {
+        File file(path, O_WRONLY | O_CREAT, 0644);
+        ASSERT_TRUE(file.ok());
+    }
+    UnixSocket over_file = UnixSocket::listen(path, UnixSocket::Type::STREAM);
+    EXPECT_FALSE(over_file.ok());
+    EXPECT_EQ(errno, EADDRINUSE);
+    EXPECT_EQ(::access(path.c_str(), F_OK), 0);
+    File::remove(path);
+}
+
+TEST(UnixSocketTest, ConnectWithoutListener) {
+    UnixSocket client = UnixSocket::connect("/tmp/rix_unix_socket_missing", UnixSocket::Type::STREAM);
+    EXPECT_FALSE(client.ok());
+    EXPECT_EQ(errno, ENOENT);
+}
+
+TEST(UnixSocketTest, PathTooLong) {
+    UnixSocket listener = UnixSocket::listen(std::string(200, 'x'), UnixSocket::Type::STREAM);
+    EXPECT_FALSE(listener.ok());
+    EXPECT_EQ(errno, ENAMETOOLONG);
+}
+
+TEST(UnixSocketTest, PassFileDescriptors) {
+    auto [a, b] = UnixSocket::pair(UnixSocket::Type::SEQPACKET);
+    auto [reader, writer] = Pipe::create();
+
+    const uint8_t tag = 42;
+    EXPECT_EQ(a.send_fds(&tag, 1, {writer.fd()}), 1);
+
+    uint8_t received = 0;
+    std::vector<int> fds;
+    EXPECT_EQ(b.receive_fds(&received, 1, fds), 1);
+    EXPECT_EQ(received, tag);
+    ASSERT_EQ(fds.size(), 1u);
+    EXPECT_NE(fds[0], writer.fd());
+
+    // The received descriptor refers to the same pipe
+    const std::string msg = "through the pipe";
+    EXPECT_EQ(::write(fds[0], msg.data(), msg.size()), static_cast<ssize_t>(msg.size()));
+    ::close(fds[0]);
+    std::vector<uint8_t> buffer(msg.size());
+    EXPECT_EQ(reader.read(buffer.data(), buffer.size()), static_cast<ssize_t>(msg.size()));
+    EXPECT_EQ(std::string(buffer.begin(), buffer.end()), msg);
+
+    // Messages without descriptors receive none
+    EXPECT_EQ(write_string(a, "x"), 1);
+    EXPECT_EQ(b.receive_fds(&received, 1, fds), 1);
+    EXPECT_TRUE(fds.empty());
+}
+
+TEST(UnixSocketTest, BufferSizes) {
+    auto [a, b] = UnixSocket::pair(UnixSocket::Type::STREAM);
+    ASSERT_TRUE(a.set_send_buffer_size(64 * 1024));
+    ASSERT_TRUE(b.set_receive_buffer_size(64 * 1024));
+    // The kernel doubles the requested size
+    EXPECT_GE(a.send_buffer_size(), 64 * 1024);
+    EXPECT_GE(b.receive_buffer_size(), 64 * 1024);
+
+    UnixSocket invalid;
+    EXPECT_FALSE(invalid.set_send_buffer_size(4096));
+    EXPECT_EQ(invalid.send_buffer_size(), -1);
+}
+
+TEST(UnixSocketTest, CopyAndMove) {
+    auto [a, b] = UnixSocket::pair(UnixSocket::Type::SEQPACKET);
+    UnixSocket copy(a);
+    EXPECT_TRUE(copy.ok());
+    EXPECT_NE(copy.fd(), a.fd());
+    EXPECT_EQ(copy.type(), UnixSocket::Type::SEQPACKET);
+
+    UnixSocket moved(std::move(copy));
+    EXPECT_FALSE(copy.ok());
+    EXPECT_EQ(write_string(moved, "moved"), 5);
+    EXPECT_EQ(read_string(b), "moved");
+}